@@ -0,0 +1,217 @@
+#include "VTC_AdaptiveLUT.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace vtc {
+
+std::shared_ptr<const AdaptiveLUT> AdaptiveLUT::Build(const LUT3D& dense, float tolerance) {
+    const int d = dense.dimension;
+    if (!dense.data || d <= kBaseDim || (d - 1) % kCells != 0) {
+        return nullptr;
+    }
+    const int f = (d - 1) / kCells;
+    if ((f & (f - 1)) != 0) {
+        return nullptr;
+    }
+    int maxLevel = 0;
+    while ((1 << maxLevel) < f) ++maxLevel;
+
+    auto lut = std::shared_ptr<AdaptiveLUT>(new AdaptiveLUT());
+    lut->factor_ = f;
+
+    auto source = [&](int x, int y, int z) {
+        return dense.data + ((static_cast<std::size_t>(z) * d + y) * d + x) * 3;
+    };
+    auto cellIndex = [](int cx, int cy, int cz) { return (cz * kCells + cy) * kCells + cx; };
+
+    lut->base_.resize(static_cast<std::size_t>(kBaseDim) * kBaseDim * kBaseDim * 3);
+    float* out = lut->base_.data();
+    for (int z = 0; z < kBaseDim; ++z) {
+        for (int y = 0; y < kBaseDim; ++y) {
+            for (int x = 0; x < kBaseDim; ++x) {
+                const float* p = source(x * f, y * f, z * f);
+                *out++ = p[0];
+                *out++ = p[1];
+                *out++ = p[2];
+            }
+        }
+    }
+
+    // Value of cell (cx, cy, cz) at source node (x, y, z) on or inside it,
+    // from `brick` (a float lattice at `level`), its stored brick, or the base.
+    auto interpolate = [&](const float* brick, int level, int cx, int cy, int cz, int x, int y, int z) {
+        const int lx = x - cx * f, ly = y - cy * f, lz = z - cz * f;
+        if (brick) {
+            const int n = 1 << level;
+            const int step = f / n;
+            const int ix = std::min(lx / step, n - 1);
+            const int iy = std::min(ly / step, n - 1);
+            const int iz = std::min(lz / step, n - 1);
+            return TrilinearCell(brick, n + 1, ix, iy, iz, static_cast<float>(lx - ix * step) / step,
+                                 static_cast<float>(ly - iy * step) / step, static_cast<float>(lz - iz * step) / step);
+        }
+        const float fx = static_cast<float>(lx) / f, fy = static_cast<float>(ly) / f, fz = static_cast<float>(lz) / f;
+        const std::uint32_t cell = level ? lut->cells_[cellIndex(cx, cy, cz)] : 0;
+        return cell ? lut->SampleBrick(cell, fx, fy, fz)
+                    : TrilinearCell(lut->base_.data(), kBaseDim, cx, cy, cz, fx, fy, fz);
+    };
+    auto cellError = [&](const float* brick, int level, int cx, int cy, int cz) {
+        float worst = 0.0f;
+        for (int z = cz * f; z <= (cz + 1) * f; ++z) {
+            for (int y = cy * f; y <= (cy + 1) * f; ++y) {
+                for (int x = cx * f; x <= (cx + 1) * f; ++x) {
+                    const RGB c = interpolate(brick, level, cx, cy, cz, x, y, z);
+                    const float* p = source(x, y, z);
+                    worst = std::max({worst, std::fabs(c.r - p[0]), std::fabs(c.g - p[1]), std::fabs(c.b - p[2])});
+                }
+            }
+        }
+        return worst;
+    };
+
+    // Start each cell at the coarsest level that holds the tolerance on its
+    // own, with every node taken from the source.
+    const int cellCount = kCells * kCells * kCells;
+    std::vector<int> levels(cellCount, maxLevel);
+    std::vector<float> scratch;
+    for (int cz = 0; cz < kCells; ++cz) {
+        for (int cy = 0; cy < kCells; ++cy) {
+            for (int cx = 0; cx < kCells; ++cx) {
+                for (int level = 0; level < maxLevel; ++level) {
+                    const int n = 1 << level;
+                    const int step = f / n;
+                    scratch.clear();
+                    for (int k = 0; k <= n; ++k) {
+                        for (int j = 0; j <= n; ++j) {
+                            for (int i = 0; i <= n; ++i) {
+                                const float* p = source(cx * f + i * step, cy * f + j * step, cz * f + k * step);
+                                scratch.insert(scratch.end(), p, p + 3);
+                            }
+                        }
+                    }
+                    if (cellError(level ? scratch.data() : nullptr, level, cx, cy, cz) <= tolerance) {
+                        levels[cellIndex(cx, cy, cz)] = level;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Conforming to coarser neighbours can push a cell past the tolerance.
+    // Refine it, or once it is at full resolution the neighbours that bind
+    // it, and rebuild until nothing moves. Levels only grow, so this ends.
+    std::vector<int> order(cellCount);
+    std::vector<float> errors(cellCount);
+    for (;;) {
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return levels[a] < levels[b]; });
+        lut->cells_.assign(cellCount, 0);
+        lut->bricks_.clear();
+        lut->codes_.clear();
+
+        for (int cell : order) {
+            const int level = levels[cell];
+            if (level == 0) continue;
+            const int cx = cell % kCells, cy = cell / kCells % kCells, cz = cell / (kCells * kCells);
+            const int n = 1 << level;
+            const int step = f / n;
+            scratch.clear();
+            for (int k = 0; k <= n; ++k) {
+                for (int j = 0; j <= n; ++j) {
+                    for (int i = 0; i <= n; ++i) {
+                        const int x = cx * f + i * step, y = cy * f + j * step, z = cz * f + k * step;
+                        // The coarsest cell sharing this node owns its value;
+                        // coarser cells were built first.
+                        const int g[3] = {x, y, z};
+                        int range[3][2];
+                        for (int a = 0; a < 3; ++a) {
+                            const int c = g[a] / f;
+                            range[a][0] = std::max(g[a] % f == 0 ? c - 1 : c, 0);
+                            range[a][1] = std::min(c, kCells - 1);
+                        }
+                        int owner = cell;
+                        for (int nz = range[2][0]; nz <= range[2][1]; ++nz) {
+                            for (int ny = range[1][0]; ny <= range[1][1]; ++ny) {
+                                for (int nx = range[0][0]; nx <= range[0][1]; ++nx) {
+                                    const int other = cellIndex(nx, ny, nz);
+                                    if (levels[other] < levels[owner]) owner = other;
+                                }
+                            }
+                        }
+                        if (owner == cell) {
+                            const float* p = source(x, y, z);
+                            scratch.insert(scratch.end(), p, p + 3);
+                        } else {
+                            const RGB c = interpolate(nullptr, levels[owner], owner % kCells, owner / kCells % kCells,
+                                                      owner / (kCells * kCells), x, y, z);
+                            scratch.insert(scratch.end(), {c.r, c.g, c.b});
+                        }
+                    }
+                }
+            }
+
+            Brick brick;
+            brick.offset = static_cast<std::uint32_t>(lut->codes_.size());
+            for (int c = 0; c < 3; ++c) {
+                float lo = scratch[c], hi = scratch[c];
+                for (std::size_t i = c; i < scratch.size(); i += 3) {
+                    lo = std::min(lo, scratch[i]);
+                    hi = std::max(hi, scratch[i]);
+                }
+                brick.low[c] = lo;
+                brick.step[c] = (hi - lo) / 65535.0f;
+            }
+            for (std::size_t i = 0; i < scratch.size(); ++i) {
+                const int c = static_cast<int>(i % 3);
+                const float code = brick.step[c] > 0.0f ? (scratch[i] - brick.low[c]) / brick.step[c] : 0.0f;
+                lut->codes_.push_back(static_cast<std::uint16_t>(std::lrint(std::min(std::max(code, 0.0f), 65535.0f))));
+            }
+            lut->cells_[cell] = static_cast<std::uint32_t>(lut->bricks_.size() << kLevelBits) |
+                                static_cast<std::uint32_t>(level);
+            lut->bricks_.push_back(brick);
+        }
+
+        bool changed = false;
+        for (int cell = 0; cell < cellCount; ++cell) {
+            const int cx = cell % kCells, cy = cell / kCells % kCells, cz = cell / (kCells * kCells);
+            errors[cell] = cellError(nullptr, levels[cell], cx, cy, cz);
+            if (errors[cell] <= tolerance) continue;
+            if (levels[cell] < maxLevel) {
+                ++levels[cell];
+                changed = true;
+                continue;
+            }
+            for (int nz = std::max(cz - 1, 0); nz <= std::min(cz + 1, kCells - 1); ++nz) {
+                for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, kCells - 1); ++ny) {
+                    for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, kCells - 1); ++nx) {
+                        const int other = cellIndex(nx, ny, nz);
+                        if (levels[other] < maxLevel) {
+                            ++levels[other];
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+        if (!changed) {
+            lut->maxError_ = *std::max_element(errors.begin(), errors.end());
+            break;
+        }
+    }
+
+    if (dense.shaper && dense.shaperSize >= 2) {
+        lut->shaperSize_ = dense.shaperSize;
+        lut->shaper_.assign(dense.shaper, dense.shaper + static_cast<std::size_t>(dense.shaperSize) * 3);
+    }
+    return lut;
+}
+
+std::size_t AdaptiveLUT::Bytes() const {
+    return (base_.size() + shaper_.size()) * sizeof(float) + cells_.size() * sizeof(std::uint32_t) +
+           bricks_.size() * sizeof(Brick) + codes_.size() * sizeof(std::uint16_t);
+}
+
+}  // namespace vtc
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../Shared/VTC_LUTData.h"
+#include "VTC_LUTKernel.h"
+
+namespace vtc {
+
+// Hierarchical lattice for large, mostly smooth LUTs: a 17^3 base lattice
+// whose cells are subdivided 2x, 4x, ... up to the source resolution, each
+// only as far as it takes to stay within a tolerance of the source. A
+// subdivided cell keeps its own brick of (n + 1)^3 nodes, stored as 16-bit
+// codes over the brick's own range.
+//
+// Where cells of different resolution meet, the finer one takes the coarser
+// one's interpolation on the shared face, so the result has no cracks. The
+// tolerance is checked at every source node after that, and the source and
+// this representation are both trilinear between source nodes, so MaxError()
+// bounds the difference everywhere.
+class AdaptiveLUT {
+public:
+    static constexpr int kBaseDim = 17;
+
+    // nullptr unless dense.dimension is kBaseDim refined by a power of two
+    // (33, 65, 129, ...). A shaped LUT keeps its shaper.
+    static std::shared_ptr<const AdaptiveLUT> Build(const LUT3D& dense, float tolerance);
+
+    RGB Sample(float r, float g, float b) const;
+
+    int SourceDimension() const { return factor_ * kCells + 1; }
+    int BrickCount() const { return static_cast<int>(bricks_.size()); }
+    std::size_t Bytes() const;
+    float MaxError() const { return maxError_; }  // against the source
+
+private:
+    static constexpr int kCells = kBaseDim - 1;
+    static constexpr int kLevelBits = 4;
+
+    struct Brick {
+        std::uint32_t offset = 0;  // first code in codes_
+        float low[3] = {};         // value = low + code * step, per channel
+        float step[3] = {};
+    };
+
+    AdaptiveLUT() = default;
+
+    RGB SampleBrick(std::uint32_t cell, float fx, float fy, float fz) const;
+
+    int factor_ = 0;  // source cells per base cell along each axis
+    float maxError_ = 0.0f;
+    std::vector<float> base_;           // kBaseDim^3 RGB, r fastest
+    std::vector<std::uint32_t> cells_;  // per base cell: brick << kLevelBits | log2(n), or 0 for the base alone
+    std::vector<Brick> bricks_;
+    std::vector<std::uint16_t> codes_;  // (n + 1)^3 RGB per brick
+    std::vector<float> shaper_;
+    int shaperSize_ = 0;
+};
+
+inline RGB AdaptiveLUT::SampleBrick(std::uint32_t cell, float fx, float fy, float fz) const {
+    const int n = 1 << (cell & ((1u << kLevelBits) - 1));
+    const Brick& brick = bricks_[cell >> kLevelBits];
+    const float bx = fx * n;
+    const float by = fy * n;
+    const float bz = fz * n;
+    const int ix = std::min(static_cast<int>(bx), n - 1);
+    const int iy = std::min(static_cast<int>(by), n - 1);
+    const int iz = std::min(static_cast<int>(bz), n - 1);
+    const RGB q = TrilinearCell(codes_.data() + brick.offset, n + 1, ix, iy, iz, bx - ix, by - iy, bz - iz);
+    return {brick.low[0] + q.r * brick.step[0], brick.low[1] + q.g * brick.step[1],
+            brick.low[2] + q.b * brick.step[2]};
+}
+
+inline RGB AdaptiveLUT::Sample(float r, float g, float b) const {
+    if (shaperSize_) {
+        const float* curve = shaper_.data();
+        r = ApplyShaper(curve, shaperSize_, r);
+        g = ApplyShaper(curve + shaperSize_, shaperSize_, g);
+        b = ApplyShaper(curve + 2 * shaperSize_, shaperSize_, b);
+    }
+    const float x = clamp01(r) * kCells;
+    const float y = clamp01(g) * kCells;
+    const float z = clamp01(b) * kCells;
+    const int cx = std::min(static_cast<int>(x), kCells - 1);
+    const int cy = std::min(static_cast<int>(y), kCells - 1);
+    const int cz = std::min(static_cast<int>(z), kCells - 1);
+    const float fx = x - cx;
+    const float fy = y - cy;
+    const float fz = z - cz;
+
+    const std::uint32_t cell = cells_[(cz * kCells + cy) * kCells + cx];
+    if (cell == 0) {
+        return TrilinearCell(base_.data(), kBaseDim, cx, cy, cz, fx, fy, fz);
+    }
+    return SampleBrick(cell, fx, fy, fz);
+}
+
+}  // namespace vtc
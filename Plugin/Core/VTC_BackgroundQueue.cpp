@@ -0,0 +1,120 @@
+#include "VTC_BackgroundQueue.h"
+
+#include <algorithm>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#include <pthread/qos.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace vtc {
+
+namespace {
+
+void lowerCurrentThreadPriority() {
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+}
+
+}  // namespace
+
+BackgroundQueue& BackgroundQueue::Shared() {
+    static BackgroundQueue queue;
+    return queue;
+}
+
+BackgroundQueue::~BackgroundQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        pending_.clear();
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void BackgroundQueue::Submit(TaskLane lane, Task task, std::uint64_t key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        ensureStarted();
+        pending_.push_back({lane, std::move(task), key});
+    }
+    wake_.notify_one();
+}
+
+void BackgroundQueue::Cancel(TaskLane lane) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [lane](const Entry& e) { return e.lane == lane; }),
+                   pending_.end());
+    if (pending_.empty() && !busy_) {
+        idle_.notify_all();
+    }
+}
+
+void BackgroundQueue::Cancel(TaskLane lane, std::uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [lane, key](const Entry& e) { return e.lane == lane && e.key == key; }),
+                   pending_.end());
+    if (pending_.empty() && !busy_) {
+        idle_.notify_all();
+    }
+}
+
+bool BackgroundQueue::Pending(TaskLane lane, std::uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (busy_ && runningLane_ == lane && runningKey_ == key) {
+        return true;
+    }
+    return std::any_of(pending_.begin(), pending_.end(),
+                       [lane, key](const Entry& e) { return e.lane == lane && e.key == key; });
+}
+
+void BackgroundQueue::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return pending_.empty() && !busy_; });
+}
+
+void BackgroundQueue::ensureStarted() {
+    if (!worker_.joinable()) {
+        worker_ = std::thread([this] { run(); });
+    }
+}
+
+void BackgroundQueue::run() {
+    lowerCurrentThreadPriority();
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (stop_) return;
+
+        auto next = std::min_element(pending_.begin(), pending_.end(), [](const Entry& a, const Entry& b) {
+            return static_cast<int>(a.lane) < static_cast<int>(b.lane);
+        });
+        Task task = std::move(next->task);
+        runningLane_ = next->lane;
+        runningKey_ = next->key;
+        pending_.erase(next);
+        busy_ = true;
+        lock.unlock();
+        task();
+        lock.lock();
+        busy_ = false;
+        if (pending_.empty()) {
+            idle_.notify_all();
+        }
+    }
+}
+
+}  // namespace vtc
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace vtc {
+
+// Pending work is grouped by lane so one kind of work can be dropped without
+// touching the other. Lower lanes run first.
+enum class TaskLane : int {
+    kRefine = 0,    // full-resolution rebake replacing a draft composite
+    kPrebake = 1,   // stacks an export is about to reach
+    kPrefetch = 2,  // speculative bake of a stack the user may pick next
+};
+
+// Single low-priority worker for bakes that must never hold up a render
+// thread. Tasks run in lane order, then submission order; the thread starts
+// on first use.
+class BackgroundQueue {
+public:
+    using Task = std::function<void()>;
+
+    static BackgroundQueue& Shared();
+
+    ~BackgroundQueue();
+
+    // `key` (0: none) groups the tasks of one job within a lane, e.g. the
+    // refines of one stack, so the job can be replaced on its own.
+    void Submit(TaskLane lane, Task task, std::uint64_t key = 0);
+
+    // Drops tasks of `lane` that have not started yet.
+    void Cancel(TaskLane lane);
+
+    // Same, only those submitted with `key`.
+    void Cancel(TaskLane lane, std::uint64_t key);
+
+    // True while a task of `lane` submitted with `key` is queued or running.
+    bool Pending(TaskLane lane, std::uint64_t key);
+
+    // Blocks until the queue is empty and the worker is idle.
+    void WaitIdle();
+
+private:
+    struct Entry {
+        TaskLane lane;
+        Task task;
+        std::uint64_t key;
+    };
+
+    BackgroundQueue() = default;
+    void ensureStarted();
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::deque<Entry> pending_;
+    std::thread worker_;
+    bool busy_ = false;
+    TaskLane runningLane_ = TaskLane::kRefine;  // of the task running while busy_
+    std::uint64_t runningKey_ = 0;
+    bool stop_ = false;
+};
+
+}  // namespace vtc
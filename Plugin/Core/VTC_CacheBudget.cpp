@@ -0,0 +1,91 @@
+#include "VTC_CacheBudget.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "VTC_BackgroundQueue.h"
+#include "VTC_Diag.h"
+#include "VTC_StackBake.h"
+
+namespace vtc {
+
+namespace {
+
+std::size_t readLimitFromEnv() {
+    const char* v = std::getenv("VTC_CACHE_BUDGET_MB");
+    if (!v || !*v) return CacheBudget::kDefaultBudgetBytes;
+    char* end = nullptr;
+    const unsigned long long mb = std::strtoull(v, &end, 10);
+    if (end == v || mb == 0) return CacheBudget::kDefaultBudgetBytes;
+    return static_cast<std::size_t>(mb) << 20;
+}
+
+}  // namespace
+
+CacheBudget& CacheBudget::Shared() {
+    static CacheBudget budget;
+    return budget;
+}
+
+CacheBudget::CacheBudget() : limit_(readLimitFromEnv()) {}
+
+void CacheBudget::Register(BudgetedCache* cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::find(caches_.begin(), caches_.end(), cache) == caches_.end()) {
+        caches_.push_back(cache);
+    }
+}
+
+void CacheBudget::Unregister(BudgetedCache* cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    caches_.erase(std::remove(caches_.begin(), caches_.end(), cache), caches_.end());
+}
+
+void CacheBudget::Enforce() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (UsedBytes() > LimitBytes()) {
+        BudgetedCache* victim = nullptr;
+        std::uint64_t oldest = 0;
+        for (BudgetedCache* cache : caches_) {
+            std::uint64_t tick = 0;
+            if (cache->OldestUse(tick) && (!victim || tick < oldest)) {
+                victim = cache;
+                oldest = tick;
+            }
+        }
+        // Everything left is in use; the budget is exceeded until it is not.
+        if (!victim || victim->EvictOldest() == 0) {
+            return;
+        }
+    }
+}
+
+void CacheBudget::PurgeAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (BudgetedCache* cache : caches_) {
+        cache->Purge();
+    }
+}
+
+void CacheBudget::SetLimitBytes(std::size_t bytes) {
+    limit_.store(bytes, std::memory_order_relaxed);
+    Enforce();
+}
+
+void PurgeCaches() {
+    BackgroundQueue& queue = BackgroundQueue::Shared();
+    queue.Cancel(TaskLane::kRefine);
+    queue.Cancel(TaskLane::kPrebake);
+    queue.Cancel(TaskLane::kPrefetch);
+    // The purge drops the speculative composites, so this is where the
+    // prefetch has had its chance.
+    const PrefetchStats stats = GetPrefetchStats();
+    if (stats.baked > 0) {
+        VTC_LUT_LOG("prefetch: %llu of %llu speculative composites used (%.0f%%)",
+                    static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.baked),
+                    100.0 * static_cast<double>(stats.hits) / static_cast<double>(stats.baked));
+    }
+    CacheBudget::Shared().PurgeAll();
+}
+
+}  // namespace vtc
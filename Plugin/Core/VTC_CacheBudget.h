@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace vtc {
+
+// A cache whose memory is accounted by CacheBudget. Implementations lock
+// their own state in every method; CacheBudget never holds a cache's lock.
+class BudgetedCache {
+public:
+    virtual ~BudgetedCache() = default;
+
+    // Use tick (CacheBudget::Tick) of the entry EvictOldest would drop, or
+    // false when nothing is evictable. Entries nobody has used yet may report
+    // 0 to go first.
+    virtual bool OldestUse(std::uint64_t& tick) = 0;
+
+    // Drops the least recently used entry and returns the bytes it released.
+    virtual std::size_t EvictOldest() = 0;
+
+    // Drops everything that is not in use right now.
+    virtual void Purge() = 0;
+};
+
+// Process-wide byte budget shared by every plugin cache. Caches Charge()
+// what they allocate and Release() what they free; Enforce() evicts the
+// globally least recently used entries until usage fits the limit.
+//
+// The limit defaults to VTC_CACHE_BUDGET_MB from the environment, else
+// kDefaultBudgetBytes.
+class CacheBudget {
+public:
+    static constexpr std::size_t kDefaultBudgetBytes = 256u << 20;
+
+    static CacheBudget& Shared();
+
+    void Register(BudgetedCache* cache);
+    void Unregister(BudgetedCache* cache);
+
+    // Monotonic clock for lastUse stamps, shared so entries of different
+    // caches compare.
+    std::uint64_t Tick() { return clock_.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    void Charge(std::size_t bytes) { used_.fetch_add(bytes, std::memory_order_relaxed); }
+    void Release(std::size_t bytes) { used_.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    // True if `bytes` more would still fit without evicting anything.
+    bool HasRoom(std::size_t bytes) const { return UsedBytes() + bytes <= LimitBytes(); }
+
+    // Call with no cache lock held, after a Charge().
+    void Enforce();
+
+    // Purges every registered cache.
+    void PurgeAll();
+
+    void SetLimitBytes(std::size_t bytes);
+    std::size_t LimitBytes() const { return limit_.load(std::memory_order_relaxed); }
+    std::size_t UsedBytes() const { return used_.load(std::memory_order_relaxed); }
+
+private:
+    CacheBudget();
+
+    std::mutex mutex_;  // guards caches_ and serialises eviction
+    std::vector<BudgetedCache*> caches_;
+    std::atomic<std::uint64_t> clock_{0};
+    std::atomic<std::size_t> used_{0};
+    std::atomic<std::size_t> limit_{kDefaultBudgetBytes};
+};
+
+// Host asked for memory back (OFX purgeCaches, AE setdown): drops queued
+// background bakes that would refill the caches, then purges them.
+void PurgeCaches();
+
+}  // namespace vtc
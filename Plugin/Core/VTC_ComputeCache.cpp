@@ -0,0 +1,121 @@
+#include "VTC_ComputeCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vtc {
+
+namespace {
+
+// Bump when the composite bake changes so stale host-cache entries miss.
+constexpr std::uint32_t kComputeKeyVersion = 3;
+
+struct KeyHasher {
+    std::uint64_t a = 0xcbf29ce484222325ull;  // FNV-1a, two offset bases
+    std::uint64_t b = 0x84222325cbf29ce4ull;
+
+    void add(const void* data, std::size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            a = (a ^ p[i]) * 0x100000001b3ull;
+            b = (b ^ p[i]) * 0x100000001b3ull;
+            b ^= b >> 29;
+        }
+    }
+
+    template <typename T>
+    void add(const T& value) { add(&value, sizeof(value)); }
+};
+
+}  // namespace
+
+ComputeKey MakeComputeKey(const ParamsSnapshot& params, int dimension) {
+    // Hash the resolved stack, so a disabled layer gives the same key
+    // whatever look and intensity it holds.
+    const ResolvedStack stack = ResolveStack(params);
+    KeyHasher h;
+    h.add(kComputeKeyVersion);
+    h.add(dimension);
+    auto addLayers = [&h](const ResolvedStack& s) {
+        h.add(s.count);
+        for (int i = 0; i < s.count; ++i) {
+            std::uint32_t intensityBits = 0;
+            std::memcpy(&intensityBits, &s.layers[i].intensity, sizeof(intensityBits));
+            h.add(s.layers[i].lutId);
+            h.add(s.layers[i].revision);  // a rewritten user LUT misses
+            h.add(intensityBits);
+        }
+    };
+    addLayers(stack);
+    for (const StackTrim* trim : {&stack.input, &stack.output}) {
+        h.add(trim->active);
+        if (trim->active) {
+            h.add(trim->matrix);
+            h.add(trim->offset);
+        }
+    }
+    // Both ends share the trims; the far end's layers and the quantized mix
+    // tell the steps of a transition apart.
+    h.add(stack.to != nullptr);
+    if (stack.to) {
+        addLayers(*stack.to);
+        h.add(stack.mix);
+    }
+    return {h.a, h.b};
+}
+
+std::shared_ptr<const CompositeLUT> ComputeComposite(const ParamsSnapshot& params, int dimension) {
+    const ResolvedStack stack = ResolveStack(params);
+    if (!stack.NeedsComposite()) {
+        return nullptr;
+    }
+    return vtc::AcquireComposite(stack, dimension);
+}
+
+std::shared_ptr<const CompositeLUT> InProcessComputeCache::AcquireComposite(const ParamsSnapshot& params,
+                                                                           int dimension) {
+    const ComputeKey key = MakeComputeKey(params, dimension);
+    auto sameKey = [&key](const std::shared_ptr<Bake>& b) { return b->key == key; };
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto it = std::find_if(baking_.begin(), baking_.end(), sameKey); it != baking_.end();
+         it = std::find_if(baking_.begin(), baking_.end(), sameKey)) {
+        // Another thread is baking this key: wait for it instead of baking
+        // the same lattice twice.
+        const std::shared_ptr<Bake> other = *it;
+        computed_.wait(lock, [&other] { return other->done; });
+        if (!other->failed) return other->value;
+    }
+
+    const std::shared_ptr<Bake> bake = std::make_shared<Bake>();
+    bake->key = key;
+    baking_.push_back(bake);
+    ++computeCount_;
+    lock.unlock();
+
+    auto finish = [&](std::shared_ptr<const CompositeLUT> value, bool failed) {
+        lock.lock();
+        bake->done = true;
+        bake->failed = failed;
+        bake->value = std::move(value);
+        baking_.erase(std::find(baking_.begin(), baking_.end(), bake));
+        lock.unlock();
+        computed_.notify_all();
+    };
+    std::shared_ptr<const CompositeLUT> value;
+    try {
+        value = ComputeComposite(params, dimension);
+    } catch (...) {
+        // Wake the waiters rather than leave them on a bake that never ends.
+        finish(nullptr, true);
+        throw;
+    }
+    finish(value, false);
+    return value;
+}
+
+std::uint64_t InProcessComputeCache::ComputeCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return computeCount_;
+}
+
+}  // namespace vtc
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../Shared/VTC_Params.h"
+#include "VTC_StackBake.h"
+
+namespace vtc {
+
+// 128-bit digest of everything a composite depends on: the contributing
+// layers' look indices, file revisions and intensities, plus the lattice
+// size. Values, not LUT addresses, so it means the same thing in every
+// render process.
+struct ComputeKey {
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+
+    bool operator==(const ComputeKey& o) const { return hi == o.hi && lo == o.lo; }
+};
+
+ComputeKey MakeComputeKey(const ParamsSnapshot& params, int dimension);
+
+// Derived data shared by every render thread that asks for the same key; a
+// composite is baked once and concurrent requests wait for that bake. The AE
+// adapter backs this with the host compute cache (AEGP_ComputeCacheSuite1);
+// InProcessComputeCache stands in everywhere else.
+class ComputeCache {
+public:
+    virtual ~ComputeCache() = default;
+
+    // Composite for the stack of `params` at `dimension` (0 = full), or
+    // nullptr for stacks that need none (see ResolvedStack::NeedsComposite).
+    virtual std::shared_ptr<const CompositeLUT> AcquireComposite(const ParamsSnapshot& params,
+                                                                 int dimension = 0) = 0;
+};
+
+// Bakes the composite a ComputeCache stores under MakeComputeKey(params,
+// dimension). Shared by every implementation.
+std::shared_ptr<const CompositeLUT> ComputeComposite(const ParamsSnapshot& params, int dimension);
+
+// Only shares bakes in flight: a finished composite is kept by the stack bake
+// cache, which charges it to CacheBudget and drops it on PurgeCaches, so this
+// holds nothing once the bake returns.
+class InProcessComputeCache final : public ComputeCache {
+public:
+    std::shared_ptr<const CompositeLUT> AcquireComposite(const ParamsSnapshot& params,
+                                                         int dimension = 0) override;
+
+    // Bakes started, shared ones counted once.
+    std::uint64_t ComputeCount() const;
+
+private:
+    struct Bake {
+        ComputeKey key;
+        bool done = false;
+        bool failed = false;  // threw; waiters bake it themselves
+        std::shared_ptr<const CompositeLUT> value;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable computed_;
+    std::vector<std::shared_ptr<Bake>> baking_;
+    std::uint64_t computeCount_ = 0;
+};
+
+}  // namespace vtc
@@ -0,0 +1,175 @@
+#include "VTC_CubeLoader.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace vtc {
+
+namespace {
+
+constexpr int kMaxCubeDim = 256;
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+// One logical line of the buffer, without the terminator.
+bool nextLine(const char*& p, const char* end, const char*& lineBegin, const char*& lineEnd) {
+    if (p >= end) return false;
+    lineBegin = p;
+    while (p < end && *p != '\n' && *p != '\r') ++p;
+    lineEnd = p;
+    while (p < end && (*p == '\n' || *p == '\r')) ++p;
+    return true;
+}
+
+bool startsWithKeyword(const char* b, const char* e, const char* keyword) {
+    const std::size_t n = std::strlen(keyword);
+    return static_cast<std::size_t>(e - b) >= n && std::strncmp(b, keyword, n) == 0 &&
+           (static_cast<std::size_t>(e - b) == n || std::isspace(static_cast<unsigned char>(b[n])));
+}
+
+// Parses up to `count` floats from [b, e); returns how many were read.
+int parseFloats(const char* b, const char* e, float* out, int count) {
+    char line[256];  // strtof needs a terminator, and must not run into the next line
+    const std::size_t len = static_cast<std::size_t>(e - b);
+    if (len >= sizeof(line)) return -1;
+    std::memcpy(line, b, len);
+    line[len] = '\0';
+    const char* s = line;
+    int n = 0;
+    while (n < count) {
+        char* next = nullptr;
+        const float v = std::strtof(s, &next);
+        if (next == s) break;
+        out[n++] = v;
+        s = next;
+    }
+    while (*s && std::isspace(static_cast<unsigned char>(*s))) ++s;
+    return *s ? -1 : n;  // trailing garbage
+}
+
+std::string cachePathFor(const std::string& cubePath, const std::string& cacheDir) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : cubePath) h = (h ^ c) * 0x100000001b3ull;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.vtclut", static_cast<unsigned long long>(h));
+    return cacheDir + "/" + name;
+}
+
+std::shared_ptr<const LoadedLUT> mapCache(const std::string& path, const FileStamp& src) {
+    std::shared_ptr<LUTPack> pack = LUTPack::Open(path);
+    if (!pack || pack->Count() != 1 || pack->Source() != src) {
+        return nullptr;  // stale or foreign: reparse
+    }
+    const LUT3D* lut = pack->Get(0);
+    if (!lut) return nullptr;
+    return std::make_shared<LoadedLUT>(std::move(pack), *lut);
+}
+
+}  // namespace
+
+LoadedLUT::LoadedLUT(std::vector<float> data, int dimension) : owned_(std::move(data)) {
+    lut_ = {owned_.data(), dimension};
+}
+
+LoadedLUT::LoadedLUT(std::shared_ptr<LUTPack> pack, const LUT3D& lut) : pack_(std::move(pack)), lut_(lut) {}
+
+bool ParseCube(const char* text, std::size_t size, std::vector<float>& data, int& dimension, std::string* error) {
+    data.clear();
+    dimension = 0;
+    std::size_t expected = 0;
+
+    const char* p = text;
+    const char* end = text + size;
+    const char* b = nullptr;
+    const char* e = nullptr;
+    int lineNo = 0;
+    while (nextLine(p, end, b, e)) {
+        ++lineNo;
+        while (b < e && std::isspace(static_cast<unsigned char>(*b))) ++b;
+        if (b == e || *b == '#') continue;
+
+        if (startsWithKeyword(b, e, "TITLE")) continue;
+        if (startsWithKeyword(b, e, "LUT_3D_SIZE")) {
+            float v = 0.0f;
+            if (parseFloats(b + 11, e, &v, 1) != 1 || v < 2.0f || v > kMaxCubeDim || v != std::floor(v)) {
+                return fail(error, "line " + std::to_string(lineNo) + ": bad LUT_3D_SIZE");
+            }
+            dimension = static_cast<int>(v);
+            expected = static_cast<std::size_t>(dimension) * dimension * dimension * 3;
+            data.reserve(expected);
+            continue;
+        }
+        if (startsWithKeyword(b, e, "DOMAIN_MIN") || startsWithKeyword(b, e, "DOMAIN_MAX")) {
+            const bool isMin = b[8] == 'I';
+            float v[3] = {};
+            const float unit = isMin ? 0.0f : 1.0f;
+            if (parseFloats(b + 10, e, v, 3) != 3 || v[0] != unit || v[1] != unit || v[2] != unit) {
+                return fail(error, "line " + std::to_string(lineNo) + ": only a 0..1 domain is supported");
+            }
+            continue;
+        }
+        if (startsWithKeyword(b, e, "LUT_1D_SIZE")) {
+            return fail(error, "1D LUTs are not supported");
+        }
+
+        float rgb[3];
+        if (parseFloats(b, e, rgb, 3) != 3) {
+            return fail(error, "line " + std::to_string(lineNo) + ": expected three values");
+        }
+        if (dimension == 0) {
+            return fail(error, "data before LUT_3D_SIZE");
+        }
+        if (data.size() >= expected) {
+            return fail(error, "more entries than LUT_3D_SIZE allows");
+        }
+        data.insert(data.end(), rgb, rgb + 3);
+    }
+
+    if (dimension == 0 || data.size() != expected) {
+        return fail(error, "expected " + std::to_string(expected / 3) + " entries, got " +
+                               std::to_string(data.size() / 3));
+    }
+    return true;
+}
+
+std::shared_ptr<const LoadedLUT> LoadCubeFile(const std::string& cubePath, const std::string& cacheDir,
+                                              std::string* error) {
+    FileStamp src;
+    if (!StatFile(cubePath, src)) {
+        fail(error, "cannot stat " + cubePath);
+        return nullptr;
+    }
+
+    const std::string cachePath = cacheDir.empty() ? std::string() : cachePathFor(cubePath, cacheDir);
+    if (!cachePath.empty()) {
+        if (auto cached = mapCache(cachePath, src)) return cached;
+    }
+
+    MappedFile text;
+    if (!text.Open(cubePath)) {
+        fail(error, "cannot read " + cubePath);
+        return nullptr;
+    }
+    std::vector<float> data;
+    int dim = 0;
+    if (!ParseCube(reinterpret_cast<const char*>(text.data()), text.size(), data, dim, error)) {
+        return nullptr;
+    }
+    if (!cachePath.empty()) {
+        // Best effort: a failed write only costs a reparse next time.
+        LUTPackItem item;
+        item.data = data.data();
+        item.dimension = dim;
+        (void)WriteLUTPack(cachePath, {item}, src);
+    }
+    return std::make_shared<LoadedLUT>(std::move(data), dim);
+}
+
+}  // namespace vtc
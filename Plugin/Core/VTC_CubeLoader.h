@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Shared/VTC_LUTData.h"
+#include "VTC_LUTPack.h"
+
+namespace vtc {
+
+// A LUT read from disk at runtime. The lattice is either parsed floats or,
+// on later loads, an entry of a mapped .vtclut cache used in place.
+class LoadedLUT {
+public:
+    explicit LoadedLUT(std::vector<float> data, int dimension);
+    LoadedLUT(std::shared_ptr<LUTPack> pack, const LUT3D& lut);
+
+    const LUT3D& lut() const { return lut_; }
+
+private:
+    std::vector<float> owned_;
+    std::shared_ptr<LUTPack> pack_;
+    LUT3D lut_{nullptr, 0};
+};
+
+// Parses .cube text into the runtime layout (r fastest, as in .cube).
+// Accepts LUT_3D_SIZE, TITLE, comments and a unit DOMAIN_MIN/MAX; anything
+// else that is not a data row is an error.
+bool ParseCube(const char* text, std::size_t size, std::vector<float>& data, int& dimension,
+               std::string* error = nullptr);
+
+// Loads a .cube file. With a `cacheDir`, a single-LUT f32 pack keyed by the
+// source path is kept there and mapped on later loads for as long as the
+// source's size and modification time match; a miss parses and rewrites it.
+std::shared_ptr<const LoadedLUT> LoadCubeFile(const std::string& cubePath, const std::string& cacheDir,
+                                              std::string* error = nullptr);
+
+}  // namespace vtc
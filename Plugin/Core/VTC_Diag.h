@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace vtc {
+
+// LUT library, cache and bake diagnostics stay quiet unless VTC_LUT_DIAG=1,
+// mirroring VTC_PRGPU_DIAG in the PrGPU host.
+inline bool DiagEnabled() {
+    static const bool s_enabled = [] {
+        const char* v = std::getenv("VTC_LUT_DIAG");
+        return v && v[0] == '1';
+    }();
+    return s_enabled;
+}
+
+} // namespace vtc
+
+#define VTC_LUT_LOG(fmt, ...) \
+    do { if (vtc::DiagEnabled()) std::fprintf(stderr, "[VTC LUT] " fmt "\n", ##__VA_ARGS__); } while (0)
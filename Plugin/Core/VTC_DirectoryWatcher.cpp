@@ -0,0 +1,124 @@
+#include "VTC_DirectoryWatcher.h"
+
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+#include "VTC_MappedFile.h"
+
+namespace vtc {
+
+namespace {
+
+// With inotify the timeout only catches directories created after start.
+constexpr int kInotifyRescanMs = 5000;
+constexpr int kPollIntervalMs = 1000;
+// Listing must stay unchanged this long before a change is reported.
+constexpr int kSettleMs = 300;
+
+std::uint64_t fnv1a(std::uint64_t h, const void* data, std::size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+}  // namespace
+
+DirectoryWatcher::DirectoryWatcher(std::vector<std::string> dirs, std::function<void()> onChange)
+    : dirs_(std::move(dirs)), onChange_(std::move(onChange)) {
+    if (::pipe(stopPipe_) != 0) {
+        stopPipe_[0] = stopPipe_[1] = -1;
+        return;
+    }
+#if defined(__linux__)
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    thread_ = std::thread([this] { run(); });
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    if (thread_.joinable()) {
+        const char stop = 1;
+        (void)::write(stopPipe_[1], &stop, 1);
+        thread_.join();
+    }
+    for (int fd : {inotifyFd_, stopPipe_[0], stopPipe_[1]}) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+void DirectoryWatcher::addWatches() {
+#if defined(__linux__)
+    if (inotifyFd_ < 0) return;
+    // Re-adding an existing watch is a no-op, so this also covers folders
+    // created since the last pass.
+    for (const std::string& dir : dirs_) {
+        (void)inotify_add_watch(inotifyFd_, dir.c_str(),
+                                IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+    }
+#endif
+}
+
+bool DirectoryWatcher::wait(int ms) {
+    pollfd fds[2] = {{stopPipe_[0], POLLIN, 0}, {inotifyFd_, POLLIN, 0}};
+    const int n = inotifyFd_ >= 0 ? 2 : 1;
+    if (::poll(fds, n, ms) < 0) return true;
+    if (fds[0].revents) return false;
+    if (n == 2 && (fds[1].revents & POLLIN)) {
+        char events[4096];
+        while (::read(inotifyFd_, events, sizeof(events)) > 0) {
+        }
+    }
+    return true;
+}
+
+// Order-independent digest of every entry's name and stamp.
+std::uint64_t DirectoryWatcher::signature() const {
+    std::uint64_t sig = 0;
+    for (const std::string& dir : dirs_) {
+        DIR* d = ::opendir(dir.c_str());
+        if (!d) continue;
+        while (dirent* e = ::readdir(d)) {
+            if (e->d_name[0] == '.') continue;
+            const std::string path = dir + "/" + e->d_name;
+            FileStamp stamp;
+            if (!StatFile(path, stamp)) continue;
+            const std::uint64_t fields[3] = {static_cast<std::uint64_t>(stamp.size),
+                                             static_cast<std::uint64_t>(stamp.mtimeNs), stamp.inode};
+            std::uint64_t h = fnv1a(1469598103934665603ull, path.data(), path.size());
+            sig += fnv1a(h, fields, sizeof(fields));
+        }
+        ::closedir(d);
+    }
+    return sig;
+}
+
+void DirectoryWatcher::run() {
+    addWatches();
+    std::uint64_t last = signature();
+    for (;;) {
+        if (!wait(inotifyFd_ >= 0 ? kInotifyRescanMs : kPollIntervalMs)) return;
+        addWatches();
+        std::uint64_t sig = signature();
+        if (sig == last) continue;
+
+        for (std::uint64_t settled = ~sig; settled != sig;) {
+            if (!wait(kSettleMs)) return;
+            settled = sig;
+            sig = signature();
+        }
+        last = sig;
+        onChange_();
+    }
+}
+
+}  // namespace vtc
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vtc {
+
+// Calls `onChange` on its own thread when files in any of `dirs` are added,
+// removed or rewritten. A change only fires once the listing has settled, so
+// a file still being copied in reports once, not per write. inotify wakes
+// the thread on Linux; elsewhere, or if inotify is unavailable, the listing
+// is polled. Directories that do not exist yet are picked up once created.
+class DirectoryWatcher {
+public:
+    DirectoryWatcher(std::vector<std::string> dirs, std::function<void()> onChange);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+private:
+    void run();
+    bool wait(int ms);  // false once the watcher is stopping
+    void addWatches();
+    std::uint64_t signature() const;
+
+    std::vector<std::string> dirs_;
+    std::function<void()> onChange_;
+    int inotifyFd_ = -1;
+    int stopPipe_[2] = {-1, -1};
+    std::thread thread_;
+};
+
+}  // namespace vtc
@@ -0,0 +1,27 @@
+#pragma once
+
+// Links a binary file into read-only data as `extern "C" const float
+// name[]`, aligned to 64 bytes (SIMD loads, cache lines). The baker writes
+// both the blobs and the sources that include them, so a re-bake touches
+// the .cpp and the build picks the new data up.
+//
+// `file` is resolved by the assembler against its include path; the
+// generated sources name it relative to their own folder (Plugin/Core), which
+// every build passes as -Wa,-I.
+
+#if defined(__APPLE__)
+#define VTC_INCBIN_SYMBOL(name) "_" #name
+#define VTC_INCBIN_SECTION ".const_data"
+#define VTC_INCBIN_END ".text\n"
+#else
+#define VTC_INCBIN_SYMBOL(name) #name
+#define VTC_INCBIN_SECTION ".section .rodata"
+#define VTC_INCBIN_END ".previous\n"
+#endif
+
+#define VTC_INCBIN(name, file)                                  \
+    extern "C" const float name[];                              \
+    __asm__(VTC_INCBIN_SECTION "\n"                             \
+            ".globl " VTC_INCBIN_SYMBOL(name) "\n"              \
+            ".p2align 6\n" VTC_INCBIN_SYMBOL(name) ":\n"        \
+            ".incbin \"" file "\"\n" VTC_INCBIN_END)
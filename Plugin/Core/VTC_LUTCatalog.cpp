@@ -0,0 +1,394 @@
+#include "VTC_LUTCatalog.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+#include "VTC_LUTPack.h"
+
+namespace vtc {
+
+namespace {
+
+constexpr char kCatalogMagic[8] = {'V', 'T', 'C', 'L', 'U', 'T', 'C', 'T'};
+
+struct CatalogHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t tagCount;
+    std::uint32_t postingCount;
+    std::uint64_t entriesOffset;
+    std::uint64_t tagsOffset;
+    std::uint64_t postingsOffset;
+    std::uint64_t fileBytes;
+    std::uint32_t checksum;  // over everything after the header
+    std::uint32_t reserved;
+};
+static_assert(sizeof(CatalogHeader) == 64, "catalog header layout");
+
+struct CatalogEntry {
+    std::uint64_t contentHash;
+    std::uint64_t payloadOffset;
+    std::int64_t sourceSize;
+    std::int64_t sourceMtime;  // nanoseconds since the epoch
+    std::uint32_t nameOffset;
+    std::uint32_t categoryOffset;
+    std::uint32_t tagsOffset;
+    std::uint32_t sourceOffset;
+    std::uint16_t nameLength;
+    std::uint16_t categoryLength;
+    std::uint16_t tagsLength;
+    std::uint16_t sourceLength;
+    std::uint16_t dimension;
+    std::uint8_t table;
+    std::uint8_t reserved;
+    std::int32_t packIndex;
+    std::uint32_t packId;
+    std::uint32_t reserved2;
+};
+static_assert(sizeof(CatalogEntry) == 72, "catalog entry layout");
+
+struct CatalogTag {
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::uint32_t firstPosting;
+    std::uint32_t postingCount;
+};
+static_assert(sizeof(CatalogTag) == 16, "catalog tag layout");
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+inline unsigned char fold(char c) {
+    return static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+}
+
+// <0, 0, >0 as `a` sorts before, with or after `b`, ASCII case folded.
+int compareFolded(std::string_view a, std::string_view b) {
+    const std::size_t n = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < n; ++i) {
+        const unsigned char x = fold(a[i]), y = fold(b[i]);
+        if (x != y) return x < y ? -1 : 1;
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+bool startsWithFolded(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && compareFolded(s.substr(0, prefix.size()), prefix) == 0;
+}
+
+std::string folded(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) c = static_cast<char>(fold(c));
+    return out;
+}
+
+// Tags as stored: trimmed, commas dropped, empty ones skipped.
+std::string cleanTag(const std::string& tag) {
+    std::string out;
+    for (char c : tag) {
+        if (c != ',') out += c;
+    }
+    const std::size_t first = out.find_first_not_of(" \t");
+    if (first == std::string::npos) return std::string();
+    return out.substr(first, out.find_last_not_of(" \t") - first + 1);
+}
+
+}  // namespace
+
+std::shared_ptr<LUTCatalog> LUTCatalog::Open(const std::string& path, std::string* error) {
+    auto catalog = std::shared_ptr<LUTCatalog>(new LUTCatalog());
+    if (!catalog->file_.Open(path)) {
+        fail(error, "cannot map " + path);
+        return nullptr;
+    }
+    const unsigned char* base = catalog->file_.data();
+    const std::size_t size = catalog->file_.size();
+
+    CatalogHeader header;
+    if (size < sizeof(header)) {
+        fail(error, "truncated header");
+        return nullptr;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kCatalogMagic, sizeof(kCatalogMagic)) != 0) {
+        fail(error, "not a .vtccat catalog");
+        return nullptr;
+    }
+    if (header.version != kLUTCatalogVersion) {
+        fail(error, "unsupported catalog version " + std::to_string(header.version));
+        return nullptr;
+    }
+    const std::uint64_t entriesBytes = static_cast<std::uint64_t>(header.entryCount) * sizeof(CatalogEntry);
+    const std::uint64_t tagsBytes = static_cast<std::uint64_t>(header.tagCount) * sizeof(CatalogTag);
+    const std::uint64_t postingsBytes = static_cast<std::uint64_t>(header.postingCount) * sizeof(std::uint32_t);
+    if (header.fileBytes != size || header.entriesOffset < sizeof(header) || header.entriesOffset > size ||
+        entriesBytes > size - header.entriesOffset || header.tagsOffset > size ||
+        tagsBytes > size - header.tagsOffset || header.postingsOffset > size ||
+        postingsBytes > size - header.postingsOffset) {
+        fail(error, "truncated catalog");
+        return nullptr;
+    }
+    if (Crc32(base + sizeof(header), size - sizeof(header)) != header.checksum) {
+        fail(error, "catalog checksum mismatch");
+        return nullptr;
+    }
+
+    // Checked once here so lookups can trust every offset.
+    auto inside = [size](std::uint64_t offset, std::uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+    for (std::uint32_t i = 0; i < header.entryCount; ++i) {
+        CatalogEntry e;
+        std::memcpy(&e, base + header.entriesOffset + i * sizeof(CatalogEntry), sizeof(e));
+        if (e.table > 1 || e.dimension < 2 || e.packIndex < -1 || !inside(e.nameOffset, e.nameLength) ||
+            !inside(e.categoryOffset, e.categoryLength) || !inside(e.tagsOffset, e.tagsLength) ||
+            !inside(e.sourceOffset, e.sourceLength) || e.sourceLength == 0) {
+            fail(error, "bad catalog entry " + std::to_string(i));
+            return nullptr;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.tagCount; ++i) {
+        CatalogTag t;
+        std::memcpy(&t, base + header.tagsOffset + i * sizeof(CatalogTag), sizeof(t));
+        if (!inside(t.nameOffset, t.nameLength) || t.firstPosting > header.postingCount ||
+            t.postingCount > header.postingCount - t.firstPosting) {
+            fail(error, "bad catalog tag " + std::to_string(i));
+            return nullptr;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.postingCount; ++i) {
+        std::uint32_t posting;
+        std::memcpy(&posting, base + header.postingsOffset + i * sizeof(posting), sizeof(posting));
+        if (posting >= header.entryCount) {
+            fail(error, "bad catalog posting " + std::to_string(i));
+            return nullptr;
+        }
+    }
+
+    const std::size_t slash = path.rfind('/');
+    catalog->dir_ = slash == std::string::npos ? "." : path.substr(0, slash);
+    catalog->entryCount_ = header.entryCount;
+    catalog->tagCount_ = header.tagCount;
+    catalog->entriesOffset_ = header.entriesOffset;
+    catalog->tagsOffset_ = header.tagsOffset;
+    catalog->postingsOffset_ = header.postingsOffset;
+    return catalog;
+}
+
+std::string_view LUTCatalog::string(std::uint32_t offset, std::uint32_t length) const {
+    return {reinterpret_cast<const char*>(file_.data() + offset), length};
+}
+
+LUTCatalogEntry LUTCatalog::Entry(int index) const {
+    CatalogEntry e;
+    std::memcpy(&e, file_.data() + entriesOffset_ + static_cast<std::size_t>(index) * sizeof(CatalogEntry), sizeof(e));
+    LUTCatalogEntry out;
+    out.table = static_cast<LUTTable>(e.table);
+    out.name = string(e.nameOffset, e.nameLength);
+    out.category = string(e.categoryOffset, e.categoryLength);
+    out.tags = string(e.tagsOffset, e.tagsLength);
+    out.source = string(e.sourceOffset, e.sourceLength);
+    out.packIndex = e.packIndex;
+    out.packId = e.packId;
+    out.payloadOffset = e.payloadOffset;
+    out.dimension = e.dimension;
+    out.contentHash = e.contentHash;
+    out.sourceSize = e.sourceSize;
+    out.sourceMtime = e.sourceMtime;
+    return out;
+}
+
+std::pair<int, int> LUTCatalog::PrefixRange(LUTTable table, std::string_view prefix) const {
+    const int t = static_cast<int>(table);
+    // Entries sort by (table, folded name), so both ends are lower bounds:
+    // the first entry not before (t, prefix), and the first past every name
+    // that starts with it.
+    auto lowerBound = [&](bool pastPrefix) {
+        int lo = 0, hi = Count();
+        while (lo < hi) {
+            const int mid = lo + (hi - lo) / 2;
+            const LUTCatalogEntry e = Entry(mid);
+            const int et = static_cast<int>(e.table);
+            bool before = et < t;
+            if (et == t) {
+                before = pastPrefix ? compareFolded(e.name, prefix) < 0 || startsWithFolded(e.name, prefix)
+                                    : compareFolded(e.name, prefix) < 0;
+            }
+            if (before) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    };
+    return {lowerBound(false), lowerBound(true)};
+}
+
+int LUTCatalog::Find(LUTTable table, std::string_view name) const {
+    const std::pair<int, int> range = PrefixRange(table, name);
+    for (int i = range.first; i < range.second; ++i) {
+        const std::string_view candidate = Entry(i).name;
+        if (candidate.size() != name.size()) break;  // longer names follow their prefix
+        if (candidate == name) return i;
+    }
+    return -1;
+}
+
+std::string_view LUTCatalog::tagName(std::uint32_t tag) const {
+    CatalogTag t;
+    std::memcpy(&t, file_.data() + tagsOffset_ + tag * sizeof(CatalogTag), sizeof(t));
+    return string(t.nameOffset, t.nameLength);
+}
+
+std::vector<int> LUTCatalog::Tagged(std::string_view tag) const {
+    std::uint32_t lo = 0, hi = tagCount_;
+    while (lo < hi) {
+        const std::uint32_t mid = lo + (hi - lo) / 2;
+        if (compareFolded(tagName(mid), tag) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    std::vector<int> entries;
+    if (lo == tagCount_ || compareFolded(tagName(lo), tag) != 0) return entries;
+    CatalogTag t;
+    std::memcpy(&t, file_.data() + tagsOffset_ + lo * sizeof(CatalogTag), sizeof(t));
+    entries.resize(t.postingCount);
+    for (std::uint32_t i = 0; i < t.postingCount; ++i) {
+        std::uint32_t posting;
+        std::memcpy(&posting, file_.data() + postingsOffset_ + (t.firstPosting + i) * sizeof(posting),
+                    sizeof(posting));
+        entries[i] = static_cast<int>(posting);
+    }
+    return entries;
+}
+
+std::string LUTCatalog::SourcePath(const LUTCatalogEntry& entry) const {
+    if (!entry.source.empty() && entry.source[0] == '/') return std::string(entry.source);
+    return dir_ + "/" + std::string(entry.source);
+}
+
+bool WriteLUTCatalog(const std::string& path, std::vector<LUTCatalogItem> items, std::string* error) {
+    for (LUTCatalogItem& item : items) {
+        const int t = static_cast<int>(item.table);
+        if (t < 0 || t > 1 || item.dimension < 2 || item.dimension > 0xFFFF || item.source.empty()) {
+            return fail(error, "bad LUT \"" + item.name + "\"");
+        }
+        std::vector<std::string> tags;
+        for (const std::string& tag : item.tags) {
+            std::string clean = cleanTag(tag);
+            if (!clean.empty()) tags.push_back(std::move(clean));
+        }
+        item.tags = std::move(tags);
+    }
+    // Same order PrefixRange searches in; ties keep a stable byte order so
+    // the file does not depend on the order items were found.
+    std::sort(items.begin(), items.end(), [](const LUTCatalogItem& a, const LUTCatalogItem& b) {
+        if (a.table != b.table) return static_cast<int>(a.table) < static_cast<int>(b.table);
+        const int c = compareFolded(a.name, b.name);
+        if (c) return c < 0;
+        if (a.name != b.name) return a.name < b.name;
+        return a.source < b.source;
+    });
+
+    // Folded tag -> entries carrying it, in entry order.
+    std::map<std::string, std::vector<std::uint32_t>> postings;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        for (const std::string& tag : items[i].tags) {
+            std::vector<std::uint32_t>& list = postings[folded(tag)];
+            if (list.empty() || list.back() != i) list.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    std::size_t postingCount = 0;
+    for (const auto& tag : postings) postingCount += tag.second.size();
+
+    const std::uint64_t entriesOffset = sizeof(CatalogHeader);
+    const std::uint64_t tagsOffset = entriesOffset + items.size() * sizeof(CatalogEntry);
+    const std::uint64_t postingsOffset = tagsOffset + postings.size() * sizeof(CatalogTag);
+    const std::uint64_t stringsOffset = postingsOffset + postingCount * sizeof(std::uint32_t);
+
+    std::string strings;
+    auto addString = [&](const std::string& s, std::uint32_t& offset, std::uint64_t limit) {
+        if (s.size() > limit || stringsOffset + strings.size() + s.size() > 0xFFFFFFFFull) return false;
+        offset = static_cast<std::uint32_t>(stringsOffset + strings.size());
+        strings += s;
+        return true;
+    };
+
+    std::vector<CatalogEntry> entries(items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const LUTCatalogItem& item = items[i];
+        std::string tags;
+        for (const std::string& tag : item.tags) tags += (tags.empty() ? "" : ",") + tag;
+        CatalogEntry& e = entries[i];
+        std::memset(&e, 0, sizeof(e));
+        e.contentHash = item.contentHash;
+        e.payloadOffset = item.payloadOffset;
+        e.sourceSize = item.sourceSize;
+        e.sourceMtime = item.sourceMtime;
+        if (!addString(item.name, e.nameOffset, 0xFFFF) || !addString(item.category, e.categoryOffset, 0xFFFF) ||
+            !addString(tags, e.tagsOffset, 0xFFFF) || !addString(item.source, e.sourceOffset, 0xFFFF)) {
+            return fail(error, "strings of \"" + item.name + "\" too long");
+        }
+        e.nameLength = static_cast<std::uint16_t>(item.name.size());
+        e.categoryLength = static_cast<std::uint16_t>(item.category.size());
+        e.tagsLength = static_cast<std::uint16_t>(tags.size());
+        e.sourceLength = static_cast<std::uint16_t>(item.source.size());
+        e.dimension = static_cast<std::uint16_t>(item.dimension);
+        e.table = static_cast<std::uint8_t>(item.table);
+        e.packIndex = item.packIndex;
+        e.packId = item.packId;
+    }
+
+    std::vector<CatalogTag> tags;
+    std::vector<std::uint32_t> postingTable;
+    postingTable.reserve(postingCount);
+    for (const auto& tag : postings) {
+        CatalogTag t;
+        if (!addString(tag.first, t.nameOffset, 0xFFFFFFFFull)) return fail(error, "catalog too large");
+        t.nameLength = static_cast<std::uint32_t>(tag.first.size());
+        t.firstPosting = static_cast<std::uint32_t>(postingTable.size());
+        t.postingCount = static_cast<std::uint32_t>(tag.second.size());
+        postingTable.insert(postingTable.end(), tag.second.begin(), tag.second.end());
+        tags.push_back(t);
+    }
+
+    // Everything after the header, as checksummed.
+    std::vector<unsigned char> body(stringsOffset - entriesOffset + strings.size());
+    unsigned char* at = body.data();
+    auto put = [&at](const void* p, std::size_t n) {
+        if (n) std::memcpy(at, p, n);
+        at += n;
+    };
+    put(entries.data(), entries.size() * sizeof(CatalogEntry));
+    put(tags.data(), tags.size() * sizeof(CatalogTag));
+    put(postingTable.data(), postingTable.size() * sizeof(std::uint32_t));
+    put(strings.data(), strings.size());
+
+    CatalogHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kCatalogMagic, sizeof(kCatalogMagic));
+    header.version = kLUTCatalogVersion;
+    header.entryCount = static_cast<std::uint32_t>(entries.size());
+    header.tagCount = static_cast<std::uint32_t>(tags.size());
+    header.postingCount = static_cast<std::uint32_t>(postingTable.size());
+    header.entriesOffset = entriesOffset;
+    header.tagsOffset = tagsOffset;
+    header.postingsOffset = postingsOffset;
+    header.fileBytes = sizeof(header) + body.size();
+    header.checksum = Crc32(body.data(), body.size());
+
+    std::string tmp;
+    std::FILE* f = CreateTempFile(path, tmp);
+    if (!f) return fail(error, "cannot write " + tmp);
+    const bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+                    std::fwrite(body.data(), 1, body.size(), f) == body.size();
+    if (std::fclose(f) != 0 || !ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return fail(error, "cannot write " + path);
+    }
+    return true;
+}
+
+}  // namespace vtc
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "VTC_MappedFile.h"
+
+namespace vtc {
+
+enum class LUTTable : int;  // VTC_LUTLibrary.h
+
+// ── .vtccat catalog ──
+//
+// A prebuilt index of a large user LUT library, so the plugin enumerates
+// thousands of looks from one mapped file instead of listing folders and
+// opening every LUT. Built by Tools/vtc_catalog from the LUT folder; the
+// library reads kLUTCatalogFileName at the folder's top level in place of
+// the folder scan when it is there.
+//
+// Little-endian, all offsets absolute:
+//   header      64 bytes (magic "VTCLUTCT", version, counts, section
+//               offsets, CRC-32 of everything after the header)
+//   entries     72 bytes per LUT, sorted by table, then by name with ASCII
+//               case folded: content hash, payload offset, source stamp,
+//               name / category / tags / source location, dimension, table,
+//               pack index and id
+//   tags        16 bytes per distinct tag, sorted by folded name: name
+//               location and its run of postings
+//   postings    u32 entry indices, ascending within each tag
+//   strings     UTF-8, not terminated
+//
+// The file holds metadata only: opening it checks its bounds and checksum
+// and never touches a LUT. Entries are decoded from the mapping on access,
+// so Entry is constant time and both searches are binary searches over the
+// mapped tables.
+
+// Version 2 stamps sources to the nanosecond. A version 1 catalog does not
+// open, so the library scans the folder until it is rebuilt.
+constexpr std::uint32_t kLUTCatalogVersion = 2;
+constexpr const char* kLUTCatalogFileName = "Library.vtccat";
+
+struct LUTCatalogEntry {
+    LUTTable table{};
+    std::string_view name;      // as in the popup
+    std::string_view category;  // folder below the table folder, or the pack's name
+    std::string_view tags;      // comma-separated
+    std::string_view source;    // .cube or .vtclut, relative to the catalog's folder unless absolute
+    int packIndex = -1;         // entry in the pack; -1 for a .cube
+    std::uint32_t packId = 0;   // LUTPackEntry::id of that entry
+    std::uint64_t payloadOffset = 0;  // first lattice byte in `source`: pack payload or first .cube data row
+    int dimension = 0;
+    std::uint64_t contentHash = 0;  // LUTAnalysis::contentHash of the lattice
+    std::int64_t sourceSize = 0;    // of `source` when the catalog was built
+    std::int64_t sourceMtime = 0;   // nanoseconds since the epoch
+};
+
+class LUTCatalog {
+public:
+    // Maps `path` and validates the header, section bounds and checksum.
+    static std::shared_ptr<LUTCatalog> Open(const std::string& path, std::string* error = nullptr);
+
+    int Count() const { return static_cast<int>(entryCount_); }
+    LUTCatalogEntry Entry(int index) const;
+
+    // Entries [first, last) of `table` whose name starts with `prefix`,
+    // ASCII case folded; the empty prefix gives the whole table. In name
+    // order.
+    std::pair<int, int> PrefixRange(LUTTable table, std::string_view prefix) const;
+
+    // Entry called exactly `name` in `table`, or -1.
+    int Find(LUTTable table, std::string_view name) const;
+
+    // Entries carrying `tag` (case folded), ascending.
+    std::vector<int> Tagged(std::string_view tag) const;
+
+    // `entry`'s source resolved against the catalog's folder.
+    std::string SourcePath(const LUTCatalogEntry& entry) const;
+
+private:
+    std::string_view string(std::uint32_t offset, std::uint32_t length) const;
+    std::string_view tagName(std::uint32_t tag) const;
+
+    MappedFile file_;
+    std::string dir_;
+    std::uint32_t entryCount_ = 0;
+    std::uint32_t tagCount_ = 0;
+    std::uint64_t entriesOffset_ = 0;
+    std::uint64_t tagsOffset_ = 0;
+    std::uint64_t postingsOffset_ = 0;
+};
+
+struct LUTCatalogItem {
+    LUTTable table{};
+    std::string name;
+    std::string category;
+    std::vector<std::string> tags;  // commas are dropped
+    std::string source;
+    int packIndex = -1;
+    std::uint32_t packId = 0;
+    std::uint64_t payloadOffset = 0;
+    int dimension = 0;
+    std::uint64_t contentHash = 0;
+    std::int64_t sourceSize = 0;
+    std::int64_t sourceMtime = 0;
+};
+
+// Sorts `items`, indexes their tags and writes the catalog to `path` through
+// a temporary file renamed into place, so the library never maps a partial
+// one.
+bool WriteLUTCatalog(const std::string& path, std::vector<LUTCatalogItem> items, std::string* error = nullptr);
+
+}  // namespace vtc
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+
+#include "../Shared/VTC_LUTData.h"
+
+namespace vtc {
+
+struct RGB {
+    float r, g, b;
+};
+
+inline float clamp01(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+inline float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+// One lattice ready for sampling: the LUT plus the per-layer constants the
+// kernels would otherwise recompute per pixel.
+struct ResolvedLayer {
+    const float* data;
+    int dimension;
+    float scale;
+    float intensity;
+    const float* shaper;  // nullptr for a uniform lattice
+    int shaperSize;
+};
+
+inline ResolvedLayer ResolveLayer(const LUT3D& lut, float intensity) {
+    const bool shaped = lut.shaper && lut.shaperSize >= 2;
+    return {lut.data, lut.dimension, static_cast<float>(lut.dimension - 1), clamp01(intensity),
+            shaped ? lut.shaper : nullptr, shaped ? lut.shaperSize : 0};
+}
+
+// ── 1D shaper ──
+//
+// A shaped LUT stores, per channel, `size` samples of a non-decreasing curve
+// over [0,1] input; the lattice is indexed by the curve's output, so nodes
+// cluster where the curve is steep.
+
+inline float ApplyShaper(const float* curve, int size, float v) {
+    const float x = clamp01(v) * static_cast<float>(size - 1);
+    const int i0 = static_cast<int>(x);
+    const int i1 = std::min(i0 + 1, size - 1);
+    return lerp(curve[i0], curve[i1], x - i0);
+}
+
+// Input that ApplyShaper maps to `u`: where a lattice node sits in input space.
+inline float InvertShaper(const float* curve, int size, float u) {
+    const float* hi = std::lower_bound(curve, curve + size, u);
+    if (hi == curve) return 0.0f;
+    if (hi == curve + size) return 1.0f;
+    const float* lo = hi - 1;
+    const float t = *hi > *lo ? (u - *lo) / (*hi - *lo) : 0.0f;
+    return (static_cast<float>(lo - curve) + t) / static_cast<float>(size - 1);
+}
+
+// Lattice sizes the bakers keep as they are and the CPU engine has a
+// dedicated kernel for. Other sizes are baked up to the next one of these
+// (user LUTs keep theirs and run the generic kernel).
+constexpr int kNativeLUTDims[] = {17, 33, 65, 129};
+
+inline int NativeLUTDim(int dim) {
+    for (int native : kNativeLUTDims) {
+        if (dim <= native) return native;
+    }
+    return kNativeLUTDims[sizeof(kNativeLUTDims) / sizeof(kNativeLUTDims[0]) - 1];
+}
+
+// Trilinear lookup. Lattice layout is r-fastest (index = (b * dim + g) * dim + r),
+// matching the .cube ordering the baker writes. With `Dim` set the lattice
+// size is a compile-time constant and the strides fold into the addressing;
+// it must equal layer.dimension. A shaped layer runs its input through the
+// shaper first.
+template <int Dim = 0>
+inline RGB sampleLUT(const ResolvedLayer& layer, float r, float g, float b) {
+    if (layer.shaper) {
+        const int n = layer.shaperSize;
+        r = ApplyShaper(layer.shaper, n, r);
+        g = ApplyShaper(layer.shaper + n, n, g);
+        b = ApplyShaper(layer.shaper + 2 * n, n, b);
+    }
+
+    const int dim = Dim > 0 ? Dim : layer.dimension;
+    const int dimM1 = dim - 1;
+    const float scale = Dim > 0 ? static_cast<float>(Dim - 1) : layer.scale;
+
+    const float x = clamp01(r) * scale;
+    const float y = clamp01(g) * scale;
+    const float z = clamp01(b) * scale;
+
+    const int x0 = static_cast<int>(x);
+    const int y0 = static_cast<int>(y);
+    const int z0 = static_cast<int>(z);
+    const int x1 = std::min(x0 + 1, dimM1);
+    const int y1 = std::min(y0 + 1, dimM1);
+    const int z1 = std::min(z0 + 1, dimM1);
+
+    const float fx = x - x0;
+    const float fy = y - y0;
+    const float fz = z - z0;
+
+    const int dim2 = dim * dim;
+    const float* lut = layer.data;
+
+    const int z0Base = z0 * dim2;
+    const int z1Base = z1 * dim2;
+    const int z0y0 = (z0Base + y0 * dim) * 3;
+    const int z0y1 = (z0Base + y1 * dim) * 3;
+    const int z1y0 = (z1Base + y0 * dim) * 3;
+    const int z1y1 = (z1Base + y1 * dim) * 3;
+
+    const int i000 = z0y0 + x0 * 3;
+    const int i100 = z0y0 + x1 * 3;
+    const int i010 = z0y1 + x0 * 3;
+    const int i110 = z0y1 + x1 * 3;
+    const int i001 = z1y0 + x0 * 3;
+    const int i101 = z1y0 + x1 * 3;
+    const int i011 = z1y1 + x0 * 3;
+    const int i111 = z1y1 + x1 * 3;
+
+    const RGB c000{lut[i000], lut[i000 + 1], lut[i000 + 2]};
+    const RGB c100{lut[i100], lut[i100 + 1], lut[i100 + 2]};
+    const RGB c010{lut[i010], lut[i010 + 1], lut[i010 + 2]};
+    const RGB c110{lut[i110], lut[i110 + 1], lut[i110 + 2]};
+    const RGB c001{lut[i001], lut[i001 + 1], lut[i001 + 2]};
+    const RGB c101{lut[i101], lut[i101 + 1], lut[i101 + 2]};
+    const RGB c011{lut[i011], lut[i011 + 1], lut[i011 + 2]};
+    const RGB c111{lut[i111], lut[i111 + 1], lut[i111 + 2]};
+
+    const RGB c00{lerp(c000.r, c100.r, fx), lerp(c000.g, c100.g, fx), lerp(c000.b, c100.b, fx)};
+    const RGB c10{lerp(c010.r, c110.r, fx), lerp(c010.g, c110.g, fx), lerp(c010.b, c110.b, fx)};
+    const RGB c01{lerp(c001.r, c101.r, fx), lerp(c001.g, c101.g, fx), lerp(c001.b, c101.b, fx)};
+    const RGB c11{lerp(c011.r, c111.r, fx), lerp(c011.g, c111.g, fx), lerp(c011.b, c111.b, fx)};
+
+    const RGB c0{lerp(c00.r, c10.r, fy), lerp(c00.g, c10.g, fy), lerp(c00.b, c10.b, fy)};
+    const RGB c1{lerp(c01.r, c11.r, fy), lerp(c01.g, c11.g, fy), lerp(c01.b, c11.b, fy)};
+
+    return {lerp(c0.r, c1.r, fz), lerp(c0.g, c1.g, fz), lerp(c0.b, c1.b, fz)};
+}
+
+// Trilinear blend inside one cell of a `dim`^3 lattice: (x0, y0, z0) is the
+// cell's low corner, f* the position within it. `T` is float, or the integer
+// codes of a quantized lattice.
+template <typename T>
+inline RGB TrilinearCell(const T* lut, int dim, int x0, int y0, int z0, float fx, float fy, float fz) {
+    const int dx = 3;
+    const int dy = dim * 3;
+    const int dz = dim * dim * 3;
+    const T* p = lut + z0 * dz + y0 * dy + x0 * dx;
+    auto channel = [&](int c) {
+        const float c00 = lerp(p[c], p[dx + c], fx);
+        const float c10 = lerp(p[dy + c], p[dy + dx + c], fx);
+        const float c01 = lerp(p[dz + c], p[dz + dx + c], fx);
+        const float c11 = lerp(p[dz + dy + c], p[dz + dy + dx + c], fx);
+        return lerp(lerp(c00, c10, fy), lerp(c01, c11, fy), fz);
+    };
+    return {channel(0), channel(1), channel(2)};
+}
+
+inline RGB sampleLUTFast(const ResolvedLayer& layer, float r, float g, float b) {
+    return sampleLUT(layer, r, g, b);
+}
+
+}  // namespace vtc
@@ -0,0 +1,682 @@
+#include "VTC_LUTLibrary.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+#include "VTC_Diag.h"
+#include "VTC_LogTransforms.h"
+#include "VTC_StackBake.h"
+
+namespace vtc {
+
+namespace {
+
+const char* const kTableFolders[] = {"Log", "Rec 709"};
+
+std::string homeDir() {
+    const char* home = std::getenv("HOME");
+    return home ? home : "";
+}
+
+std::string userLUTDir() {
+    if (const char* dir = std::getenv("VTC_USER_LUT_DIR")) return dir;
+    const std::string home = homeDir();
+    return home.empty() ? std::string() : home + "/Library/Application Support/VTC Looks/LUTs";
+}
+
+std::string cacheDir() {
+    if (const char* dir = std::getenv("VTC_LUT_CACHE_DIR")) return dir;
+    const std::string home = homeDir();
+    return home.empty() ? std::string() : home + "/Library/Caches/VTC Looks";
+}
+
+// mkdir -p; returns false if the directory is not there afterwards.
+bool makeDirs(const std::string& path) {
+    for (std::size_t pos = 1; pos <= path.size(); ++pos) {
+        if (pos == path.size() || path[pos] == '/') {
+            ::mkdir(path.substr(0, pos).c_str(), 0755);
+        }
+    }
+    struct stat st {};
+    return ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool hasExtension(const std::string& file, const char* ext) {
+    const std::size_t n = std::strlen(ext);
+    return file.size() > n && strcasecmp(file.c_str() + file.size() - n, ext) == 0;
+}
+
+// Files in `dir` with extension `ext`, sorted so popup positions do not
+// depend on directory order.
+std::vector<std::string> listFiles(const std::string& dir, const char* ext) {
+    std::vector<std::string> files;
+    DIR* d = ::opendir(dir.c_str());
+    if (!d) return files;
+    while (dirent* e = ::readdir(d)) {
+        const std::string file = e->d_name;
+        if (file[0] != '.' && hasExtension(file, ext)) {
+            files.push_back(file);
+        }
+    }
+    ::closedir(d);
+    std::sort(files.begin(), files.end(),
+              [](const std::string& a, const std::string& b) { return strcasecmp(a.c_str(), b.c_str()) < 0; });
+    return files;
+}
+
+// ── Built-in name perfect hash ──
+//
+// Seeded FNV-1a into a power-of-two table at least 8x the name count; the
+// first seed that places every name in its own slot is found at compile time.
+
+constexpr std::uint32_t nameHash(const char* s, std::uint32_t seed) {
+    std::uint32_t h = 2166136261u ^ seed;
+    for (; *s; ++s) {
+        h ^= static_cast<unsigned char>(*s);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr std::size_t hashSlots(std::size_t names) {
+    std::size_t n = 8;
+    while (n < names * 8) n *= 2;
+    return n;
+}
+
+template <std::size_t N>
+struct NameHash {
+    static constexpr std::size_t kSlots = hashSlots(N);
+    static constexpr std::uint32_t kMaxSeed = 1u << 16;
+
+    std::uint32_t seed = kMaxSeed;  // kMaxSeed: no seed found
+    std::int16_t slots[kSlots] = {};
+
+    int find(const char* const (&names)[N], const char* name) const {
+        const int i = slots[nameHash(name, seed) & (kSlots - 1)];
+        return i >= 0 && std::strcmp(names[i], name) == 0 ? i : -1;
+    }
+};
+
+template <std::size_t N>
+constexpr NameHash<N> buildNameHash(const char* const (&names)[N]) {
+    NameHash<N> hash;
+    for (std::uint32_t seed = 0; seed < NameHash<N>::kMaxSeed; ++seed) {
+        for (std::size_t s = 0; s < NameHash<N>::kSlots; ++s) hash.slots[s] = -1;
+        bool placed = true;
+        for (std::size_t i = 0; i < N && placed; ++i) {
+            std::int16_t& slot = hash.slots[nameHash(names[i], seed) & (NameHash<N>::kSlots - 1)];
+            placed = slot < 0;
+            slot = static_cast<std::int16_t>(i);
+        }
+        if (placed) {
+            hash.seed = seed;
+            return hash;
+        }
+    }
+    return hash;
+}
+
+constexpr auto kLogNameHash = buildNameHash(kLogLUTNames);
+constexpr auto kRec709NameHash = buildNameHash(kRec709LUTNames);
+static_assert(kLogNameHash.seed != decltype(kLogNameHash)::kMaxSeed, "no perfect hash for kLogLUTNames");
+static_assert(kRec709NameHash.seed != decltype(kRec709NameHash)::kMaxSeed, "no perfect hash for kRec709LUTNames");
+
+int findBuiltin(LUTTable t, const char* name) {
+    return t == LUTTable::kLog ? kLogNameHash.find(kLogLUTNames, name) : kRec709NameHash.find(kRec709LUTNames, name);
+}
+
+// ── Lattice metadata ──
+
+// Built-in tables carry the baker's analysis; user LUTs are analyzed here,
+// once, when first loaded.
+void describeLattice(const LUT3D& lut, LUTInfo& info) {
+    info.dimension = lut.dimension;
+    info.shaperSize = lut.shaper ? lut.shaperSize : 0;
+    info.layout = LUTLayout::kRGBF32RFastest;
+    info.analysis = lut.analysis ? *lut.analysis : AnalyzeLattice(lut);
+    info.contentHash = info.analysis.contentHash;
+    info.structure = StructureFromAnalysis(lut, info.analysis, LUTLibrary::kStructureTolerance);
+}
+
+// ── Folder scan ──
+
+// A user LUT present on disk.
+struct FoundLUT {
+    std::string name;
+    std::string source;
+    std::string path;
+    std::shared_ptr<LUTPack> pack;
+    int packIndex = -1;
+    std::uint32_t packId = 0;
+    FileStamp stamp;  // no inode when catalogued
+    bool catalogued = false;
+};
+
+// Derived from the file state rather than counted, so every render process
+// gives the same file the same revision.
+std::uint32_t fileRevision(const FileStamp& stamp) {
+    std::uint64_t h = 1469598103934665603ull;
+    for (std::uint64_t v : {static_cast<std::uint64_t>(stamp.size), static_cast<std::uint64_t>(stamp.mtimeNs),
+                            stamp.inode}) {
+        for (int i = 0; i < 8; ++i) {
+            h ^= static_cast<std::uint64_t>(v >> (8 * i)) & 0xFF;
+            h *= 1099511628211ull;
+        }
+    }
+    return static_cast<std::uint32_t>(h ^ (h >> 32)) | 1u;  // 0 is for built-ins
+}
+
+// Lists the looks in the catalog at the top of `root` into `found`: names
+// and stamps only, nothing else on disk is touched. nullptr, with `found`
+// untouched, when there is no catalog or it fails to open; the caller then
+// scans the folder.
+std::shared_ptr<const LUTCatalog> readCatalog(const std::string& root, std::vector<FoundLUT> (&found)[2]) {
+    const std::string path = root + "/" + kLUTCatalogFileName;
+    FileStamp stamp;
+    if (!StatFile(path, stamp)) return nullptr;
+    std::string error;
+    std::shared_ptr<const LUTCatalog> catalog = LUTCatalog::Open(path, &error);
+    if (!catalog) {
+        VTC_LUT_LOG("cannot open %s: %s, scanning the folder", kLUTCatalogFileName, error.c_str());
+        return nullptr;
+    }
+    for (int i = 0; i < catalog->Count(); ++i) {
+        const LUTCatalogEntry e = catalog->Entry(i);
+        FoundLUT f;
+        f.name = std::string(e.name);
+        f.path = catalog->SourcePath(e);
+        f.source = e.packIndex < 0 ? f.path : f.path + "#" + std::to_string(e.packId);  // as the folder scan keys it
+        f.packIndex = e.packIndex;
+        f.packId = e.packId;
+        f.stamp.size = e.sourceSize;
+        f.stamp.mtimeNs = e.sourceMtime;
+        f.catalogued = true;
+        found[static_cast<int>(e.table)].push_back(std::move(f));
+    }
+    return catalog;
+}
+
+// ── Slot map ──
+//
+// Saved projects store popup values, and compute keys hash LUT ids, so a
+// user LUT must keep its index across sessions and processes, not only
+// within one scan. The slot each source was given is kept in the cache
+// folder, one map per LUT folder, and every process using that folder reads
+// it: a new source is appended after the last slot, a removed one keeps its
+// slot, empty. Lines are "<table>\t<slot>\t<key>\t<name>", the key being
+// the source relative to the LUT folder.
+
+struct SlotMap {
+    std::vector<std::pair<std::string, std::string>> slots[2];  // by slot: key, name
+};
+
+std::string slotMapPath(const std::string& cacheDir, const std::string& root) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : root) h = (h ^ c) * 0x100000001b3ull;
+    char name[48];
+    std::snprintf(name, sizeof(name), "UserLUTSlots-%016llx.txt", static_cast<unsigned long long>(h));
+    return cacheDir + "/" + name;
+}
+
+std::string slotKey(const std::string& root, const std::string& source) {
+    return source.compare(0, root.size() + 1, root + "/") == 0 ? source.substr(root.size() + 1) : source;
+}
+
+// Serialises slot assignment between processes; unlocked when destroyed.
+// Does nothing for an empty path.
+class FileLock {
+public:
+    explicit FileLock(const std::string& path) {
+        if (path.empty()) return;
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ >= 0) ::flock(fd_, LOCK_EX);
+    }
+    ~FileLock() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    int fd_ = -1;
+};
+
+// A missing or unreadable map reads as empty.
+SlotMap readSlotMap(const std::string& path) {
+    SlotMap map;
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return map;
+    std::string text;
+    char buf[4096];
+    for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) text.append(buf, n);
+    std::fclose(f);
+    for (std::size_t line = 0; line < text.size();) {
+        std::size_t end = text.find('\n', line);
+        if (end == std::string::npos) end = text.size();
+        const std::string row = text.substr(line, end - line);
+        line = end + 1;
+        const std::size_t a = row.find('\t');
+        const std::size_t b = a == std::string::npos ? a : row.find('\t', a + 1);
+        const std::size_t c = b == std::string::npos ? b : row.find('\t', b + 1);
+        if (c == std::string::npos) continue;
+        const int table = std::atoi(row.c_str());
+        const long slot = std::atol(row.c_str() + a + 1);
+        if (table < 0 || table > 1 || slot < 0 || slot > 0xFFFF) continue;
+        auto& slots = map.slots[table];
+        if (slots.size() <= static_cast<std::size_t>(slot)) slots.resize(static_cast<std::size_t>(slot) + 1);
+        slots[static_cast<std::size_t>(slot)] = {row.substr(b + 1, c - b - 1), row.substr(c + 1)};
+    }
+    return map;
+}
+
+// Through a unique temporary file renamed into place, so a reader never
+// sees a partial map.
+void writeSlotMap(const std::string& path, const SlotMap& map) {
+    std::string tmp;
+    std::FILE* f = CreateTempFile(path, tmp);
+    if (!f) return;
+    bool ok = true;
+    for (int t = 0; t < 2; ++t) {
+        for (std::size_t i = 0; i < map.slots[t].size(); ++i) {
+            const auto& slot = map.slots[t][i];
+            if (slot.first.empty()) continue;
+            ok = ok && std::fprintf(f, "%d\t%zu\t%s\t%s\n", t, i, slot.first.c_str(), slot.second.c_str()) > 0;
+        }
+    }
+    if (std::fclose(f) != 0 || !ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+    }
+}
+
+bool watchEnabled() {
+    const char* v = std::getenv("VTC_LUT_WATCH");
+    return !(v && std::strcmp(v, "0") == 0);
+}
+
+bool analyticConvertEnabled() {
+    const char* v = std::getenv("VTC_ANALYTIC_CONVERT");
+    return !(v && std::strcmp(v, "0") == 0);
+}
+
+// Swaps a built-in camera conversion's lattice for its closed form when the
+// two agree at every node; the lattice stays in use otherwise.
+void attachAnalytic(const char* name, const LUT3D& lut, LUTInfo& info) {
+    LUTStructure analytic;
+    if (info.structure.fast() || !AnalyticLogConversion(name, analytic)) return;
+    const float err = StructureNodeError(analytic, lut);
+    if (err > LUTLibrary::kAnalyticTolerance) {
+        VTC_LUT_LOG("analytic \"%s\" differs from its LUT by %g, using the LUT", name, err);
+        return;
+    }
+    if (!analyticConvertEnabled()) return;
+    analytic.maxError = err;
+    info.structure = std::move(analytic);
+}
+
+}  // namespace
+
+LUTLibrary& LUTLibrary::Shared() {
+    static LUTLibrary library;
+    return library;
+}
+
+LUTLibrary::LUTLibrary() {
+    Table& log = table(LUTTable::kLog);
+    log.builtins = kLogLUTs;
+    log.builtinCount = kLogLUTCount;
+    log.builtinNames = kLogLUTNames;
+
+    Table& rec709 = table(LUTTable::kRec709);
+    rec709.builtins = kRec709LUTs;
+    rec709.builtinCount = kRec709LUTCount;
+    rec709.builtinNames = kRec709LUTNames;
+
+    for (Table& tab : tables_) {
+        tab.builtinInfo = std::make_unique<InfoSlot[]>(tab.builtinCount);
+    }
+
+    root_ = userLUTDir();
+    scan(false);
+
+    if (!root_.empty() && watchEnabled()) {
+        watcher_ = std::make_unique<DirectoryWatcher>(
+            std::vector<std::string>{root_, root_ + "/" + kTableFolders[0], root_ + "/" + kTableFolders[1]},
+            [this] { Reload(); });
+    }
+}
+
+LUTLibrary::~LUTLibrary() = default;
+
+void LUTLibrary::Reload() {
+    scan(true);
+}
+
+// Diffs the folder (or its catalog) against the published sets and publishes
+// a new set for each table that changed. With `eager`, new and rewritten LUTs are loaded
+// here, before the swap, so no render thread ends up parsing them.
+void LUTLibrary::scan(bool eager) {
+    std::lock_guard<std::mutex> lock(scanMutex_);
+
+    std::vector<FoundLUT> found[2];
+    std::shared_ptr<const LUTCatalog> catalog = root_.empty() ? nullptr : readCatalog(root_, found);
+    if (!root_.empty() && !catalog) {
+        for (int t = 0; t < 2; ++t) {
+            const std::string dir = root_ + "/" + kTableFolders[t];
+            for (const std::string& file : listFiles(dir, ".cube")) {
+                FoundLUT f;
+                f.name = file.substr(0, file.size() - 5);
+                f.path = f.source = dir + "/" + file;
+                if (StatFile(f.path, f.stamp)) found[t].push_back(std::move(f));
+            }
+        }
+        for (const std::string& file : listFiles(root_, ".vtclut")) {
+            const std::string path = root_ + "/" + file;
+            FileStamp stamp;
+            if (!StatFile(path, stamp)) continue;
+            std::string error;
+            std::shared_ptr<LUTPack> pack = LUTPack::Open(path, &error);
+            if (!pack) {
+                VTC_LUT_LOG("cannot open %s: %s", file.c_str(), error.c_str());
+                continue;
+            }
+            for (int i = 0; i < pack->Count(); ++i) {
+                const std::uint32_t id = pack->Entry(i).id;
+                if ((id >> 16) >= 2) continue;
+                FoundLUT f;
+                f.name = pack->Entry(i).name;
+                f.source = path + "#" + std::to_string(id);
+                f.path = path;
+                f.pack = pack;
+                f.packIndex = i;
+                f.packId = id;
+                f.stamp = stamp;
+                found[id >> 16].push_back(std::move(f));
+            }
+        }
+    }
+
+    // Fixed before the first user entry is published; load() reads it
+    // without the lock. It holds the slot map and the .cube caches.
+    if (!cacheDirChecked_ && (!found[0].empty() || !found[1].empty())) {
+        cacheDirChecked_ = true;
+        cacheDir_ = cacheDir();
+        if (!cacheDir_.empty() && !makeDirs(cacheDir_)) {
+            cacheDir_.clear();  // parse every session, number within it
+        }
+    }
+
+    // Slot of every found LUT, appending the new ones; prev's slots stand
+    // in for the map when there is no cache folder.
+    std::vector<const FoundLUT*> foundAt[2];
+    SlotMap map;
+    {
+        const std::string mapPath = cacheDir_.empty() ? std::string() : slotMapPath(cacheDir_, root_);
+        FileLock mapLock(mapPath.empty() ? std::string() : mapPath + ".lock");
+        if (!mapPath.empty()) map = readSlotMap(mapPath);
+        bool mapChanged = false;
+        for (int t = 0; t < 2; ++t) {
+            auto& slots = map.slots[t];
+            const std::shared_ptr<const UserSet> prev = std::atomic_load(&tables_[t].users);
+            for (std::size_t i = 0; prev && i < prev->luts.size(); ++i) {
+                if (slots.size() <= i) slots.resize(i + 1);
+                if (slots[i].first.empty()) {
+                    slots[i] = {prev->luts[i]->key, prev->luts[i]->name};
+                    mapChanged = true;
+                }
+            }
+            std::unordered_map<std::string, std::size_t> slotOf;
+            for (std::size_t i = 0; i < slots.size(); ++i) {
+                if (!slots[i].first.empty()) slotOf.emplace(slots[i].first, i);
+            }
+            foundAt[t].assign(slots.size(), nullptr);
+            for (const FoundLUT& f : found[t]) {
+                const std::string key = slotKey(root_, f.source);
+                auto it = slotOf.find(key);
+                if (it == slotOf.end()) {
+                    if (slots.size() > 0xFFFFu - static_cast<std::size_t>(tables_[t].builtinCount)) continue;
+                    it = slotOf.emplace(key, slots.size()).first;
+                    slots.emplace_back(key, f.name);
+                    foundAt[t].push_back(nullptr);
+                    mapChanged = true;
+                } else if (slots[it->second].second != f.name) {
+                    slots[it->second].second = f.name;
+                    mapChanged = true;
+                }
+                foundAt[t][it->second] = &f;
+            }
+        }
+        if (mapChanged && !mapPath.empty()) writeSlotMap(mapPath, map);
+    }
+
+    // Replaced LUTs stay alive until their cached lattices are dropped, so
+    // no new LUT can reuse an address still used as a cache key meanwhile.
+    std::vector<std::shared_ptr<const UserLUT>> stale;
+    for (int t = 0; t < 2; ++t) {
+        Table& tab = tables_[t];
+        const std::shared_ptr<const UserSet> prev = std::atomic_load(&tab.users);
+        const auto& slots = map.slots[t];
+        auto next = std::make_shared<UserSet>();
+        next->luts.resize(slots.size());
+
+        std::vector<UserLUT*> fresh;
+        bool changed = !prev || prev->luts.size() != slots.size();
+        auto replace = [&](std::shared_ptr<UserLUT>& slot, const std::shared_ptr<UserLUT>& old,
+                           std::shared_ptr<UserLUT> lut) {
+            if (old && old->resolved.load()) stale.push_back(old);
+            slot = std::move(lut);
+            changed = true;
+        };
+        auto make = [&](const FoundLUT& f) {
+            auto lut = std::make_shared<UserLUT>();
+            lut->name = f.name;
+            lut->key = slotKey(root_, f.source);
+            lut->source = f.source;
+            lut->path = f.path;
+            lut->pack = f.pack;
+            lut->packIndex = f.packIndex;
+            lut->packId = f.packId;
+            lut->catalogued = f.catalogued;
+            lut->file = f.stamp;
+            lut->revision = fileRevision(f.stamp);
+            fresh.push_back(lut.get());
+            return lut;
+        };
+
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            std::shared_ptr<UserLUT>& slot = next->luts[i];
+            std::shared_ptr<UserLUT> old;
+            if (prev && i < prev->luts.size() && prev->luts[i]->key == slots[i].first) old = prev->luts[i];
+            if (const FoundLUT* f = foundAt[t][i]) {
+                if (old && old->file == f->stamp) {
+                    slot = old;
+                } else {
+                    replace(slot, old, make(*f));
+                }
+            } else if (old && old->file.size < 0) {
+                slot = old;
+            } else {
+                auto gone = std::make_shared<UserLUT>();
+                gone->name = slots[i].second;
+                gone->key = slots[i].first;
+                replace(slot, old, std::move(gone));
+            }
+        }
+        if (!changed) continue;
+
+        for (int i = static_cast<int>(next->luts.size()) - 1; i >= 0; --i) {
+            next->index[next->luts[i]->name] = tab.builtinCount + i;  // first of a name wins
+        }
+        // '|' separates popup items; keep user names from splitting one.
+        const int count = tab.builtinCount + static_cast<int>(next->luts.size());
+        next->popup = "None";
+        for (int i = 0; i < count; ++i) {
+            std::string name = i < tab.builtinCount ? tab.builtinNames[i] : next->luts[i - tab.builtinCount]->name;
+            std::replace(name.begin(), name.end(), '|', '/');
+            next->popup += "|" + name;
+        }
+        for (int i = 0; i <= count; ++i) {
+            if (i) next->selectedPopup += "|";
+            next->selectedPopup += std::to_string(i) + "/" + std::to_string(count);
+        }
+
+        if (eager) {
+            for (UserLUT* lut : fresh) (void)load(*lut);
+        }
+        if (prev) {
+            VTC_LUT_LOG("%s folder changed: %zu user LUTs", kTableFolders[t], next->luts.size());
+        }
+        std::atomic_store(&tab.users, std::shared_ptr<const UserSet>(std::move(next)));
+    }
+
+    std::atomic_store(&catalog_, catalog);
+
+    for (const std::shared_ptr<const UserLUT>& lut : stale) {
+        InvalidateComposites(lut->resolved.load());
+    }
+}
+
+// Renders may still hold looks from a pack that has since been rewritten, so
+// a pack is shared only within one revision of its file.
+std::shared_ptr<LUTPack> LUTLibrary::openPack(const std::string& path, std::uint32_t revision) {
+    std::lock_guard<std::mutex> lock(packMutex_);
+    std::weak_ptr<LUTPack>& slot = packs_[path + "#" + std::to_string(revision)];
+    std::shared_ptr<LUTPack> pack = slot.lock();
+    if (pack) return pack;
+    std::string error;
+    pack = LUTPack::Open(path, &error);
+    if (!pack) {
+        VTC_LUT_LOG("cannot open %s: %s", path.c_str(), error.c_str());
+        return nullptr;
+    }
+    slot = pack;
+    return pack;
+}
+
+const LUT3D* LUTLibrary::load(UserLUT& user) {
+    if (user.file.size < 0) return nullptr;
+    std::call_once(user.loadOnce, [&] {
+        FileStamp now;  // the catalog records no inode
+        if (user.catalogued &&
+            (!StatFile(user.path, now) || now.size != user.file.size || now.mtimeNs != user.file.mtimeNs)) {
+            VTC_LUT_LOG("%s changed since %s was built; rebuild it with vtc_catalog",
+                        user.path.c_str(), kLUTCatalogFileName);
+        }
+        if (user.packIndex >= 0) {
+            if (!user.pack) user.pack = openPack(user.path, user.revision);
+            if (!user.pack) return;
+            int index = user.packIndex;
+            if (index >= user.pack->Count() || user.pack->Entry(index).id != user.packId) {
+                index = user.pack->Find(user.packId);  // the pack was rebuilt after the catalog
+            }
+            if (index < 0) {
+                VTC_LUT_LOG("%s has no look %u", user.path.c_str(), user.packId);
+                return;
+            }
+            user.resolved.store(user.pack->Get(index));
+            return;
+        }
+        std::string error;
+        user.loaded = LoadCubeFile(user.path, cacheDir_, &error);
+        if (!user.loaded) {
+            VTC_LUT_LOG("cannot load %s: %s", user.path.c_str(), error.c_str());
+            return;
+        }
+        user.resolved.store(&user.loaded->lut());
+    });
+    return user.resolved.load();
+}
+
+int LUTLibrary::Count(LUTTable t) const {
+    return table(t).builtinCount + static_cast<int>(users(t)->luts.size());
+}
+
+int LUTLibrary::BuiltinCount(LUTTable t) const {
+    return table(t).builtinCount;
+}
+
+std::string LUTLibrary::Name(LUTTable t, int index) const {
+    const Table& tab = table(t);
+    if (index < 0) return std::string();
+    if (index < tab.builtinCount) return tab.builtinNames[index];
+    const std::shared_ptr<const UserSet> set = users(t);
+    const std::size_t user = static_cast<std::size_t>(index - tab.builtinCount);
+    return user < set->luts.size() ? set->luts[user]->name : std::string();
+}
+
+const LUT3D* LUTLibrary::Get(LUTTable t, int index, std::uint32_t* revision, std::shared_ptr<const void>* owner) {
+    Table& tab = table(t);
+    if (revision) *revision = 0;
+    if (owner) owner->reset();
+    if (index < 0) return nullptr;
+    if (index < tab.builtinCount) return &tab.builtins[index];
+
+    const std::shared_ptr<const UserSet> set = users(t);
+    const std::size_t user = static_cast<std::size_t>(index - tab.builtinCount);
+    if (user >= set->luts.size()) return nullptr;
+    const std::shared_ptr<UserLUT>& lut = set->luts[user];
+    if (revision) *revision = lut->revision;
+    if (owner) *owner = lut;
+    return load(*lut);
+}
+
+int LUTLibrary::Find(LUTTable t, const char* name) const {
+    if (!name) return -1;
+    const int builtin = findBuiltin(t, name);
+    if (builtin >= 0) return builtin;
+    const std::shared_ptr<const UserSet> set = users(t);
+    auto it = set->index.find(name);
+    return it != set->index.end() ? it->second : -1;
+}
+
+const LUTInfo* LUTLibrary::Info(LUTTable t, int index, std::shared_ptr<const void>* owner) {
+    Table& tab = table(t);
+    if (owner) owner->reset();
+    if (index < 0) return nullptr;
+
+    std::shared_ptr<UserLUT> pinned;  // keeps a user entry alive meanwhile
+    UserLUT* user = nullptr;
+    InfoSlot* slot = nullptr;
+    if (index < tab.builtinCount) {
+        slot = &tab.builtinInfo[index];
+    } else {
+        const std::shared_ptr<const UserSet> set = users(t);
+        const std::size_t i = static_cast<std::size_t>(index - tab.builtinCount);
+        if (i >= set->luts.size()) return nullptr;
+        pinned = set->luts[i];
+        user = pinned.get();
+        slot = &user->info;
+        if (owner) *owner = pinned;
+    }
+    std::call_once(slot->once, [&] {
+        const LUT3D* lut = user ? load(*user) : &tab.builtins[index];
+        if (!lut) return;
+        slot->info.id = LUTId(t, index);
+        slot->info.builtin = !user;
+        describeLattice(*lut, slot->info);
+        if (!user && t == LUTTable::kLog) {
+            attachAnalytic(tab.builtinNames[index], *lut, slot->info);
+        }
+        slot->valid = true;
+    });
+    return slot->valid ? &slot->info : nullptr;
+}
+
+std::string LUTLibrary::PopupString(LUTTable t) const {
+    return users(t)->popup;
+}
+
+std::string LUTLibrary::SelectedPopupString(LUTTable t) const {
+    return users(t)->selectedPopup;
+}
+
+}  // namespace vtc
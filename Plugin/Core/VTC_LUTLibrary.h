@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Shared/VTC_LUTData.h"
+#include "VTC_CubeLoader.h"
+#include "VTC_DirectoryWatcher.h"
+#include "VTC_LUTCatalog.h"
+#include "VTC_LUTPack.h"
+#include "VTC_LUTStructure.h"
+
+namespace vtc {
+
+enum class LUTTable : int {
+    kLog = 0,     // log-to-Rec.709 conversions (Log Convert group)
+    kRec709,      // creative looks (Creative / Secondary / Accent groups)
+};
+
+// Memory layout of a resolved lattice.
+enum class LUTLayout : std::uint8_t {
+    kRGBF32RFastest,  // dim^3 RGB float triplets, r varying fastest (LUT3D)
+};
+
+struct LUTInfo {
+    std::uint32_t id = 0;
+    int dimension = 0;
+    int shaperSize = 0;  // 1D shaper entries per channel; 0 for a uniform lattice
+    LUTLayout layout = LUTLayout::kRGBF32RFastest;
+    LUTStructure structure;  // structure.kind: kUnknown until loaded
+    bool builtin = false;
+    std::uint64_t contentHash = 0;  // FNV-1a over lattice and shaper; equal LUTs, equal hash
+    LUTAnalysis analysis = {};      // baked for built-ins, measured on load for user LUTs
+};
+
+// Every LUT a layer can pick: the embedded tables first, then the user LUT
+// folder (VTC_USER_LUT_DIR, default ~/Library/Application Support/VTC
+// Looks/LUTs): .cube files in its "Log" and "Rec 709" subfolders, then the
+// entries of any .vtclut pack at its top level, each filed under the table
+// its id names.
+//
+// The folder is scanned for names at startup; a user LUT is parsed (or its
+// pack pages mapped) the first time a layer resolves it. A large library
+// can ship a prebuilt catalog instead (kLUTCatalogFileName at the folder's
+// top level, from Tools/vtc_catalog): the names then come from that one
+// mapped index, with no directory listing, stat or pack open per LUT, and
+// each pack is opened when one of its looks is first resolved. The embedded tables
+// stay the fallback when a file is missing or malformed. Lookups by index,
+// id and name are constant time: built-in names go through a perfect hash
+// generated at compile time, user names through a map filled by the scan.
+//
+// The folder is then watched (unless VTC_LUT_WATCH=0). Files added or
+// rewritten during a session are parsed on the watcher thread and the new
+// user table is published in one atomic swap, so renders never wait on a
+// rescan. Indices are stable, across sessions and render processes too: a
+// changed file keeps its slot under a new revision, a removed one leaves an
+// empty slot, new ones are appended. The slots are kept in the cache folder
+// (VTC_LUT_CACHE_DIR, default ~/Library/Caches/VTC Looks); without one they
+// hold for the session only. Thread-safe.
+class LUTLibrary {
+public:
+    // Largest node error a fast structural form may have: half a 12-bit code.
+    static constexpr float kStructureTolerance = 1.0f / 8192.0f;
+    // Largest node error for a closed-form camera conversion. Looser: the
+    // shipped lattice went through .cube text and another implementation's
+    // float math, so it is the oracle only to within that rounding.
+    static constexpr float kAnalyticTolerance = 1.0f / 1024.0f;
+
+    static LUTLibrary& Shared();
+    ~LUTLibrary();
+
+    int Count(LUTTable table) const;
+    int BuiltinCount(LUTTable table) const;
+    // Empty when `index` is out of range.
+    std::string Name(LUTTable table, int index) const;
+
+    // nullptr when `index` is out of range or the user file failed to load.
+    // `revision` receives the revision of the LUT returned. A user LUT is
+    // freed once a rescan has replaced it and nothing holds its `owner`
+    // (null for built-ins, which live as long as the process): pass one for
+    // as long as the pointer is in use.
+    const LUT3D* Get(LUTTable table, int index, std::uint32_t* revision = nullptr,
+                     std::shared_ptr<const void>* owner = nullptr);
+    const LUT3D* Get(std::uint32_t id, std::shared_ptr<const void>* owner = nullptr) {
+        return (id >> 16) < 2 ? Get(TableOf(id), IndexOf(id), nullptr, owner) : nullptr;
+    }
+
+    // Index of the LUT called `name` in `table`, or -1. Built-ins win over a
+    // user LUT of the same name.
+    int Find(LUTTable table, const char* name) const;
+
+    // Metadata for a LUT; loads it on first use to classify the lattice
+    // (identity, affine, separable within kStructureTolerance) from its
+    // analysis, which built-ins carry from the bake and user LUTs get by
+    // hashing and scanning the lattice once. A
+    // built-in camera conversion gets its closed form (kAnalytic) instead
+    // when that matches the lattice within kAnalyticTolerance and
+    // VTC_ANALYTIC_CONVERT is not 0.
+    // nullptr under the same conditions as Get, and pinned by `owner` the
+    // same way.
+    const LUTInfo* Info(LUTTable table, int index, std::shared_ptr<const void>* owner = nullptr);
+
+    // Identifies a look across renders, sessions and processes sharing the
+    // same LUT folder and cache folder, unlike the LUT's address.
+    static std::uint32_t LUTId(LUTTable table, int index) {
+        return (static_cast<std::uint32_t>(table) << 16) | static_cast<std::uint32_t>(index);
+    }
+    static LUTTable TableOf(std::uint32_t id) { return static_cast<LUTTable>(id >> 16); }
+    static int IndexOf(std::uint32_t id) { return static_cast<int>(id & 0xFFFFu); }
+
+    // "None|<look>|..." and "0/N|...|N/N" strings for the host popups. Hosts
+    // fix a popup's length when they register it: After Effects once per
+    // session, so LUTs added later appear after a restart; OFX hosts when
+    // the plugin is next described. Next/Prev step within the registered
+    // length (the popup's num_choices / option count), not Count().
+    std::string PopupString(LUTTable table) const;
+    std::string SelectedPopupString(LUTTable table) const;
+
+    // The catalog the user LUTs were last read from; nullptr when the folder
+    // was scanned. Its search results map to library indices through Find.
+    std::shared_ptr<const LUTCatalog> Catalog() const { return std::atomic_load(&catalog_); }
+
+    // Rescans the user folder now and publishes what changed. The watcher
+    // calls this; blocking, so never from a render thread.
+    void Reload();
+
+private:
+    LUTLibrary();
+
+    struct InfoSlot {
+        std::once_flag once;
+        LUTInfo info;
+        bool valid = false;
+    };
+
+    struct UserLUT {
+        std::string name;
+        std::string key;                 // source relative to the folder; names the slot
+        std::string source;              // path, or pack path + '#' + id
+        std::string path;                // .cube source, or
+        std::shared_ptr<LUTPack> pack;   // the pack holding it; opened on load when catalogued
+        int packIndex = -1;
+        std::uint32_t packId = 0;
+        bool catalogued = false;         // listed by the catalog, not found on disk
+        FileStamp file{-1};              // size -1: file removed, slot kept
+        std::uint32_t revision = 0;      // of `file`
+        std::once_flag loadOnce;
+        std::shared_ptr<const LoadedLUT> loaded;
+        std::atomic<const LUT3D*> resolved{nullptr};
+        InfoSlot info;
+    };
+
+    // One table's user LUTs as published by a scan; never changed after. A
+    // replaced set goes with its last reader; a UserLUT it shares with the
+    // next set, or that a render has pinned, stays.
+    struct UserSet {
+        std::vector<std::shared_ptr<UserLUT>> luts;
+        std::unordered_map<std::string, int> index;  // name -> table index
+        std::string popup;
+        std::string selectedPopup;
+    };
+
+    struct Table {
+        const LUT3D* builtins = nullptr;
+        int builtinCount = 0;
+        const char* const* builtinNames = nullptr;
+        std::unique_ptr<InfoSlot[]> builtinInfo;
+        std::shared_ptr<const UserSet> users;  // std::atomic_load/store only
+    };
+
+    Table& table(LUTTable t) { return tables_[static_cast<int>(t)]; }
+    const Table& table(LUTTable t) const { return tables_[static_cast<int>(t)]; }
+    std::shared_ptr<const UserSet> users(LUTTable t) const { return std::atomic_load(&table(t).users); }
+
+    const LUT3D* load(UserLUT& lut);
+    void scan(bool eager);
+    std::shared_ptr<LUTPack> openPack(const std::string& path, std::uint32_t revision);
+
+    Table tables_[2];
+    std::string root_;
+    std::string cacheDir_;
+    bool cacheDirChecked_ = false;
+    std::mutex scanMutex_;
+    std::shared_ptr<const LUTCatalog> catalog_;  // std::atomic_load/store only
+    // Packs opened for catalogued looks, by path and revision, shared by
+    // every look they hold.
+    std::mutex packMutex_;
+    std::unordered_map<std::string, std::weak_ptr<LUTPack>> packs_;
+    std::unique_ptr<DirectoryWatcher> watcher_;  // last: stops before the rest goes
+};
+
+}  // namespace vtc
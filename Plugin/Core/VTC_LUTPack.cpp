@@ -0,0 +1,413 @@
+#include "VTC_LUTPack.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "VTC_Diag.h"
+
+namespace vtc {
+
+namespace {
+
+constexpr char kPackMagic[8] = {'V', 'T', 'C', 'L', 'U', 'T', 'P', 'K'};
+
+struct PackHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t lutCount;
+    std::uint64_t indexOffset;
+    std::uint64_t fileBytes;
+    std::uint64_t sourceSize;
+    std::int64_t sourceMtime;     // nanoseconds since the epoch
+    std::uint32_t indexChecksum;  // over the index and the name table
+    std::uint32_t namesBytes;
+    std::uint64_t sourceInode;
+};
+static_assert(sizeof(PackHeader) == 64, "pack header layout");
+
+struct PackIndexEntry {
+    std::uint32_t id;
+    std::uint16_t dimension;
+    std::uint8_t precision;
+    std::uint8_t reserved0;
+    float rangeMin;
+    float rangeMax;
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::uint64_t dataOffset;
+    std::uint32_t dataBytes;
+    std::uint32_t checksum;
+    std::uint32_t shaperSize;  // version 2; zero in version 1 packs
+    std::uint32_t reserved2;
+};
+static_assert(sizeof(PackIndexEntry) == 48, "pack index layout");
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+std::size_t bytesPerValue(LUTPrecision precision) {
+    switch (precision) {
+        case LUTPrecision::kF32:    return 4;
+        case LUTPrecision::kDelta8: return 1;
+        default:                    return 2;
+    }
+}
+
+// Identity lattice value behind flat sample `k` (r fastest, RGB interleaved).
+inline float identityAt(std::size_t k, int dim) {
+    const std::size_t point = k / 3;
+    const std::size_t d = static_cast<std::size_t>(dim);
+    std::size_t coord = point;
+    switch (k % 3) {
+        case 0: coord = point % d; break;
+        case 1: coord = (point / d) % d; break;
+        default: coord = point / (d * d); break;
+    }
+    return static_cast<float>(coord) / static_cast<float>(dim - 1);
+}
+
+template <typename Quantum>
+void decodeDelta(const unsigned char* payload, std::size_t count, int dim, float step, float* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        Quantum q;
+        std::memcpy(&q, payload + i * sizeof(q), sizeof(q));
+        out[i] = identityAt(i, dim) + step * static_cast<float>(q);
+    }
+}
+
+template <typename Quantum>
+float encodeDelta(const float* data, std::size_t count, int dim, unsigned char* payload) {
+    constexpr float kMaxQuantum = static_cast<float>(std::numeric_limits<Quantum>::max());
+    float maxResidual = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        maxResidual = std::max(maxResidual, std::fabs(data[i] - identityAt(i, dim)));
+    }
+    const float step = maxResidual > 0.0f ? maxResidual / kMaxQuantum : 1.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        const float q = std::round((data[i] - identityAt(i, dim)) / step);
+        const Quantum quantum = static_cast<Quantum>(std::max(-kMaxQuantum, std::min(kMaxQuantum, q)));
+        std::memcpy(payload + i * sizeof(quantum), &quantum, sizeof(quantum));
+    }
+    return step;
+}
+
+std::size_t alignUp(std::size_t v) {
+    return (v + kLUTPackAlignment - 1) & ~(kLUTPackAlignment - 1);
+}
+
+float halfToFloat(std::uint16_t h) {
+    const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000) << 16;
+    const std::uint32_t exp = (h >> 10) & 0x1F;
+    const std::uint32_t mant = h & 0x3FF;
+    std::uint32_t bits;
+    if (exp == 0) {
+        if (mant == 0) {
+            bits = sign;
+        } else {  // subnormal
+            float v = std::ldexp(static_cast<float>(mant), -24);
+            std::memcpy(&bits, &v, sizeof(bits));
+            bits |= sign;
+        }
+    } else if (exp == 31) {
+        bits = sign | 0x7F800000u | (mant << 13);
+    } else {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+std::uint16_t floatToHalf(float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    const float a = std::fabs(f);
+    if (!(a < 65520.0f)) {  // overflow, inf and nan
+        return static_cast<std::uint16_t>(sign | (a != a ? 0x7E00 : 0x7C00));
+    }
+    if (a < 6.103515625e-05f) {  // subnormal half
+        return static_cast<std::uint16_t>(sign | static_cast<std::uint16_t>(std::lrint(a * 16777216.0f)));
+    }
+    // Round to nearest even on the 13 dropped mantissa bits.
+    std::uint32_t abits = bits & 0x7FFFFFFFu;
+    abits += 0x00000FFFu + ((abits >> 13) & 1);
+    return static_cast<std::uint16_t>(sign | ((abits - (112u << 23)) >> 13));
+}
+
+}  // namespace
+
+std::uint32_t Crc32(const unsigned char* p, std::size_t n, std::uint32_t crc) {
+    static const auto table = [] {
+        std::vector<std::uint32_t> t(256);
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < n; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+std::shared_ptr<LUTPack> LUTPack::Open(const std::string& path, std::string* error) {
+    auto pack = std::shared_ptr<LUTPack>(new LUTPack());
+    if (!pack->file_.Open(path)) {
+        fail(error, "cannot map " + path);
+        return nullptr;
+    }
+    const unsigned char* base = pack->file_.data();
+    const std::size_t size = pack->file_.size();
+
+    PackHeader header;
+    if (size < sizeof(header)) {
+        fail(error, "truncated header");
+        return nullptr;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kPackMagic, sizeof(kPackMagic)) != 0) {
+        fail(error, "not a .vtclut pack");
+        return nullptr;
+    }
+    if (header.version < 1 || header.version > kLUTPackVersion) {
+        fail(error, "unsupported pack version " + std::to_string(header.version));
+        return nullptr;
+    }
+    const std::uint64_t tableBytes =
+        static_cast<std::uint64_t>(header.lutCount) * sizeof(PackIndexEntry) + header.namesBytes;
+    if (header.fileBytes != size || header.indexOffset > size || tableBytes > size - header.indexOffset) {
+        fail(error, "truncated index");
+        return nullptr;
+    }
+    if (Crc32(base + header.indexOffset, tableBytes) != header.indexChecksum) {
+        fail(error, "index checksum mismatch");
+        return nullptr;
+    }
+
+    pack->source_.size = static_cast<std::int64_t>(header.sourceSize);
+    pack->source_.mtimeNs = header.sourceMtime;
+    pack->source_.inode = header.sourceInode;
+    pack->entries_.reserve(header.lutCount);
+    for (std::uint32_t i = 0; i < header.lutCount; ++i) {
+        PackIndexEntry e;
+        std::memcpy(&e, base + header.indexOffset + i * sizeof(PackIndexEntry), sizeof(e));
+        const std::uint64_t dim = e.dimension;
+        if (dim < 2 || e.precision > static_cast<std::uint8_t>(LUTPrecision::kDelta16) || e.shaperSize == 1 ||
+            e.shaperSize > 0xFFFF) {
+            fail(error, "bad index entry " + std::to_string(i));
+            return nullptr;
+        }
+        const auto precision = static_cast<LUTPrecision>(e.precision);
+        const std::uint64_t shaperBytes = static_cast<std::uint64_t>(e.shaperSize) * 3 * sizeof(float);
+        if (e.dataBytes != dim * dim * dim * 3 * bytesPerValue(precision) + shaperBytes ||
+            e.dataOffset % kLUTPackAlignment != 0 ||
+            e.dataOffset > size || e.dataBytes > size - e.dataOffset ||
+            static_cast<std::uint64_t>(e.nameOffset) + e.nameLength > size) {
+            fail(error, "entry " + std::to_string(i) + " out of bounds");
+            return nullptr;
+        }
+
+        auto slot = std::make_unique<Slot>();
+        slot->info.id = e.id;
+        slot->info.name.assign(reinterpret_cast<const char*>(base + e.nameOffset), e.nameLength);
+        slot->info.dimension = e.dimension;
+        slot->info.shaperSize = static_cast<int>(e.shaperSize);
+        slot->info.precision = precision;
+        slot->dataOffset = e.dataOffset;
+        slot->dataBytes = e.dataBytes;
+        slot->checksum = e.checksum;
+        slot->rangeMin = e.rangeMin;
+        slot->rangeMax = e.rangeMax;
+        pack->entries_.push_back(std::move(slot));
+    }
+    return pack;
+}
+
+int LUTPack::Find(std::uint32_t id) const {
+    for (int i = 0; i < Count(); ++i) {
+        if (entries_[i]->info.id == id) return i;
+    }
+    return -1;
+}
+
+void LUTPack::materialize(Slot& slot) const {
+    const unsigned char* payload = file_.data() + slot.dataOffset;
+    if (Crc32(payload, slot.dataBytes) != slot.checksum) {
+        VTC_LUT_LOG("pack entry \"%s\" failed its checksum", slot.info.name.c_str());
+        return;
+    }
+
+    const int dim = slot.info.dimension;
+    const std::size_t count = static_cast<std::size_t>(dim) * dim * dim * 3;
+    const int shaperSize = slot.info.shaperSize;
+    const unsigned char* shaper = payload + count * bytesPerValue(slot.info.precision);
+    // After a 16- or 8-bit lattice the shaper may sit off a float boundary.
+    if (shaperSize > 0 && slot.info.precision != LUTPrecision::kF32) {
+        slot.shaper.resize(static_cast<std::size_t>(shaperSize) * 3);
+        std::memcpy(slot.shaper.data(), shaper, slot.shaper.size() * sizeof(float));
+    }
+    switch (slot.info.precision) {
+        case LUTPrecision::kF32:
+            slot.lut = {reinterpret_cast<const float*>(payload), dim,
+                        shaperSize > 0 ? reinterpret_cast<const float*>(shaper) : nullptr, shaperSize};
+            return;
+        case LUTPrecision::kF16: {
+            slot.widened.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                std::uint16_t h;
+                std::memcpy(&h, payload + i * 2, sizeof(h));
+                slot.widened[i] = halfToFloat(h);
+            }
+            break;
+        }
+        case LUTPrecision::kU16: {
+            slot.widened.resize(count);
+            const float step = (slot.rangeMax - slot.rangeMin) / 65535.0f;
+            for (std::size_t i = 0; i < count; ++i) {
+                std::uint16_t q;
+                std::memcpy(&q, payload + i * 2, sizeof(q));
+                slot.widened[i] = slot.rangeMin + step * q;
+            }
+            break;
+        }
+        case LUTPrecision::kDelta8:
+            slot.widened.resize(count);
+            decodeDelta<std::int8_t>(payload, count, dim, slot.rangeMax, slot.widened.data());
+            break;
+        case LUTPrecision::kDelta16:
+            slot.widened.resize(count);
+            decodeDelta<std::int16_t>(payload, count, dim, slot.rangeMax, slot.widened.data());
+            break;
+    }
+    slot.lut = {slot.widened.data(), dim, shaperSize > 0 ? slot.shaper.data() : nullptr, shaperSize};
+}
+
+const LUT3D* LUTPack::Get(int index) {
+    if (index < 0 || index >= Count()) return nullptr;
+    Slot& slot = *entries_[index];
+    std::call_once(slot.materializeOnce, [&] { materialize(slot); });
+    return slot.lut.data ? &slot.lut : nullptr;
+}
+
+bool WriteLUTPack(const std::string& path, const std::vector<LUTPackItem>& items, const FileStamp& source,
+                  std::string* error) {
+    const std::uint64_t indexOffset = sizeof(PackHeader);
+    std::uint64_t namesBytes = 0;
+    for (const LUTPackItem& item : items) namesBytes += item.name.size();
+
+    std::vector<PackIndexEntry> index(items.size());
+    std::uint64_t cursor = alignUp(indexOffset + items.size() * sizeof(PackIndexEntry) + namesBytes);
+    std::uint64_t nameCursor = indexOffset + items.size() * sizeof(PackIndexEntry);
+    std::vector<std::vector<unsigned char>> payloads(items.size());
+
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const LUTPackItem& item = items[i];
+        if (item.dimension < 2 || item.dimension > 0xFFFF || !item.data ||
+            (item.shaperSize != 0 && (item.shaperSize < 2 || item.shaperSize > 0xFFFF || !item.shaper))) {
+            return fail(error, "bad LUT \"" + item.name + "\"");
+        }
+        const std::size_t count = static_cast<std::size_t>(item.dimension) * item.dimension * item.dimension * 3;
+        PackIndexEntry& e = index[i];
+        std::memset(&e, 0, sizeof(e));
+        e.id = item.id;
+        e.dimension = static_cast<std::uint16_t>(item.dimension);
+        e.precision = static_cast<std::uint8_t>(item.precision);
+        e.rangeMin = 0.0f;
+        e.rangeMax = 1.0f;
+
+        std::vector<unsigned char>& bytes = payloads[i];
+        bytes.resize(count * bytesPerValue(item.precision));
+        switch (item.precision) {
+            case LUTPrecision::kF32:
+                std::memcpy(bytes.data(), item.data, bytes.size());
+                break;
+            case LUTPrecision::kF16:
+                for (std::size_t k = 0; k < count; ++k) {
+                    const std::uint16_t h = floatToHalf(item.data[k]);
+                    std::memcpy(bytes.data() + k * 2, &h, sizeof(h));
+                }
+                break;
+            case LUTPrecision::kU16: {
+                const auto range = std::minmax_element(item.data, item.data + count);
+                e.rangeMin = *range.first;
+                e.rangeMax = *range.second > *range.first ? *range.second : *range.first + 1.0f;
+                const float scale = 65535.0f / (e.rangeMax - e.rangeMin);
+                for (std::size_t k = 0; k < count; ++k) {
+                    const std::uint16_t q =
+                        static_cast<std::uint16_t>(std::lrint((item.data[k] - e.rangeMin) * scale));
+                    std::memcpy(bytes.data() + k * 2, &q, sizeof(q));
+                }
+                break;
+            }
+            case LUTPrecision::kDelta8:
+                e.rangeMax = encodeDelta<std::int8_t>(item.data, count, item.dimension, bytes.data());
+                break;
+            case LUTPrecision::kDelta16:
+                e.rangeMax = encodeDelta<std::int16_t>(item.data, count, item.dimension, bytes.data());
+                break;
+        }
+        if (item.shaperSize > 0) {
+            const std::size_t shaperBytes = static_cast<std::size_t>(item.shaperSize) * 3 * sizeof(float);
+            bytes.resize(bytes.size() + shaperBytes);
+            std::memcpy(bytes.data() + bytes.size() - shaperBytes, item.shaper, shaperBytes);
+            e.shaperSize = static_cast<std::uint32_t>(item.shaperSize);
+        }
+
+        e.nameOffset = static_cast<std::uint32_t>(nameCursor);
+        e.nameLength = static_cast<std::uint32_t>(item.name.size());
+        nameCursor += item.name.size();
+        e.dataOffset = cursor;
+        e.dataBytes = static_cast<std::uint32_t>(bytes.size());
+        e.checksum = Crc32(bytes.data(), bytes.size());
+        cursor = alignUp(cursor + bytes.size());
+    }
+
+    // Index, names, then zero padding up to the first payload.
+    std::vector<unsigned char> table(alignUp(indexOffset + index.size() * sizeof(PackIndexEntry) + namesBytes) -
+                                     indexOffset);
+    std::memcpy(table.data(), index.data(), index.size() * sizeof(PackIndexEntry));
+    std::size_t at = index.size() * sizeof(PackIndexEntry);
+    for (const LUTPackItem& item : items) {
+        std::memcpy(table.data() + at, item.name.data(), item.name.size());
+        at += item.name.size();
+    }
+
+    PackHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+    header.version = kLUTPackVersion;
+    header.lutCount = static_cast<std::uint32_t>(items.size());
+    header.indexOffset = indexOffset;
+    header.fileBytes = cursor;
+    header.sourceSize = static_cast<std::uint64_t>(source.size);
+    header.sourceMtime = source.mtimeNs;
+    header.sourceInode = source.inode;
+    header.namesBytes = static_cast<std::uint32_t>(namesBytes);
+    header.indexChecksum = Crc32(table.data(), at);
+
+    std::string tmp;
+    std::FILE* f = CreateTempFile(path, tmp);
+    if (!f) return fail(error, "cannot write " + tmp);
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(table.data(), 1, table.size(), f) == table.size();
+    static const unsigned char kZeros[kLUTPackAlignment] = {};
+    for (std::size_t i = 0; ok && i < payloads.size(); ++i) {
+        const std::size_t pad = alignUp(payloads[i].size()) - payloads[i].size();
+        ok = std::fwrite(payloads[i].data(), 1, payloads[i].size(), f) == payloads[i].size() &&
+             std::fwrite(kZeros, 1, pad, f) == pad;
+    }
+    if (std::fclose(f) != 0 || !ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return fail(error, "cannot write " + path);
+    }
+    return true;
+}
+
+}  // namespace vtc
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Shared/VTC_LUTData.h"
+#include "VTC_MappedFile.h"
+
+namespace vtc {
+
+// ── .vtclut pack ──
+//
+// Little-endian, all offsets absolute:
+//   header      64 bytes (magic "VTCLUTPK", version, counts, source stamp,
+//               CRC-32 of the index and name table)
+//   index       48 bytes per LUT: id, dimension, precision, value range,
+//               name and payload location, CRC-32 of the payload
+//   names       UTF-8, not terminated
+//   payloads    one lattice per LUT (r fastest, RGB interleaved), each
+//               starting on a 64-byte boundary, then the LUT's 1D shaper
+//               as f32 (r, g, b curves) if the entry has one
+//
+// Tools/bake_luts.py writes the same layout; bump kLUTPackVersion in both.
+// Version 1 packs predate shapers and still open.
+
+constexpr std::uint32_t kLUTPackVersion = 2;
+constexpr std::size_t kLUTPackAlignment = 64;
+
+enum class LUTPrecision : std::uint8_t {
+    kF32 = 0,
+    kF16 = 1,  // IEEE half
+    kU16 = 2,  // unorm over the entry's [rangeMin, rangeMax]
+    // Residual from identity in steps of the entry's rangeMax, for looks
+    // that stay close to identity.
+    kDelta8 = 3,
+    kDelta16 = 4,
+};
+
+struct LUTPackEntry {
+    std::uint32_t id = 0;  // LUTLibrary::LUTId of the look
+    std::string name;
+    int dimension = 0;
+    int shaperSize = 0;  // entries per channel, 0 without a shaper
+    LUTPrecision precision = LUTPrecision::kF32;
+};
+
+class LUTPack {
+public:
+    // Maps `path` and validates the header, index and name table. Payload
+    // checksums are checked when an entry is first accessed.
+    static std::shared_ptr<LUTPack> Open(const std::string& path, std::string* error = nullptr);
+
+    int Count() const { return static_cast<int>(entries_.size()); }
+    const LUTPackEntry& Entry(int index) const { return entries_[index]->info; }
+    // Where `index`'s payload starts in the file.
+    std::uint64_t PayloadOffset(int index) const { return entries_[index]->dataOffset; }
+    int Find(std::uint32_t id) const;  // -1 if absent
+
+    // f32 entries point straight into the mapping; the other precisions are
+    // decoded to floats once. nullptr if the payload fails its checksum.
+    const LUT3D* Get(int index);
+
+    // Stamp of the file the pack was built from, for single-LUT caches of a
+    // .cube; zero for baked packs.
+    const FileStamp& Source() const { return source_; }
+
+private:
+    struct Slot {
+        LUTPackEntry info;
+        std::uint64_t dataOffset = 0;
+        std::uint32_t dataBytes = 0;
+        std::uint32_t checksum = 0;
+        float rangeMin = 0.0f;
+        float rangeMax = 1.0f;
+        std::once_flag materializeOnce;
+        std::vector<float> widened;
+        std::vector<float> shaper;  // copy when the payload leaves it unaligned
+        LUT3D lut{nullptr, 0};
+    };
+
+    void materialize(Slot& slot) const;
+
+    MappedFile file_;
+    std::vector<std::unique_ptr<Slot>> entries_;
+    FileStamp source_;
+};
+
+struct LUTPackItem {
+    std::uint32_t id = 0;
+    std::string name;
+    const float* data = nullptr;
+    int dimension = 0;
+    LUTPrecision precision = LUTPrecision::kF32;
+    const float* shaper = nullptr;  // 3 * shaperSize values, always stored as f32
+    int shaperSize = 0;
+};
+
+// Writes `items` to `path` through a temporary file renamed into place, so a
+// concurrent Open never maps a partial pack.
+bool WriteLUTPack(const std::string& path, const std::vector<LUTPackItem>& items, const FileStamp& source = {},
+                  std::string* error = nullptr);
+
+// CRC-32 (IEEE) as stored in .vtclut and .vtccat files; `crc` continues an
+// earlier call.
+std::uint32_t Crc32(const unsigned char* p, std::size_t n, std::uint32_t crc = 0);
+
+}  // namespace vtc
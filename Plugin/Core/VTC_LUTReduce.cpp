@@ -0,0 +1,148 @@
+#include "VTC_LUTReduce.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vtc {
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+constexpr float kDegrees = kPi / 180.0f;
+
+float labF(float t) {
+    constexpr float kEpsilon = 216.0f / 24389.0f;  // (6/29)^3
+    return t > kEpsilon ? std::cbrt(t) : t * (24389.0f / 3132.0f) + 4.0f / 29.0f;
+}
+
+float hueAngle(float b, float a) {
+    if (a == 0.0f && b == 0.0f) return 0.0f;
+    const float h = std::atan2(b, a);
+    return h < 0.0f ? h + 2.0f * kPi : h;
+}
+
+int validationDim(int dim) {
+    return std::min(std::max(2 * (dim - 1) + 1, 65), 129);
+}
+
+}  // namespace
+
+Lab DisplayRGBToLab(RGB c) {
+    const float r = std::pow(clamp01(c.r), 2.4f);
+    const float g = std::pow(clamp01(c.g), 2.4f);
+    const float b = std::pow(clamp01(c.b), 2.4f);
+    const float x = (0.4123908f * r + 0.3575843f * g + 0.1804808f * b) / 0.9504559f;
+    const float y = 0.2126390f * r + 0.7151687f * g + 0.0721923f * b;
+    const float z = (0.0193308f * r + 0.1191948f * g + 0.9505322f * b) / 1.0890578f;
+    const float fx = labF(x), fy = labF(y), fz = labF(z);
+    return {116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz)};
+}
+
+float DeltaE2000(const Lab& x, const Lab& y) {
+    const float c1 = std::sqrt(x.a * x.a + x.b * x.b);
+    const float c2 = std::sqrt(y.a * y.a + y.b * y.b);
+    const float cMean7 = std::pow(0.5f * (c1 + c2), 7.0f);
+    const float g = 0.5f * (1.0f - std::sqrt(cMean7 / (cMean7 + 6103515625.0f)));  // 25^7
+    const float a1 = (1.0f + g) * x.a, a2 = (1.0f + g) * y.a;
+    const float cp1 = std::sqrt(a1 * a1 + x.b * x.b), cp2 = std::sqrt(a2 * a2 + y.b * y.b);
+    const float hp1 = hueAngle(x.b, a1), hp2 = hueAngle(y.b, a2);
+
+    const float dL = y.L - x.L;
+    const float dC = cp2 - cp1;
+    float dh = 0.0f;
+    if (cp1 * cp2 != 0.0f) {
+        dh = hp2 - hp1;
+        if (dh > kPi) dh -= 2.0f * kPi;
+        else if (dh < -kPi) dh += 2.0f * kPi;
+    }
+    const float dH = 2.0f * std::sqrt(cp1 * cp2) * std::sin(0.5f * dh);
+
+    const float lMean = 0.5f * (x.L + y.L);
+    const float cpMean = 0.5f * (cp1 + cp2);
+    float hMean = hp1 + hp2;
+    if (cp1 * cp2 != 0.0f) {
+        if (std::fabs(hp1 - hp2) > kPi) hMean += hMean < 2.0f * kPi ? 2.0f * kPi : -2.0f * kPi;
+        hMean *= 0.5f;
+    }
+    const float t = 1.0f - 0.17f * std::cos(hMean - 30.0f * kDegrees) + 0.24f * std::cos(2.0f * hMean) +
+                    0.32f * std::cos(3.0f * hMean + 6.0f * kDegrees) -
+                    0.20f * std::cos(4.0f * hMean - 63.0f * kDegrees);
+    const float l50 = (lMean - 50.0f) * (lMean - 50.0f);
+    const float sL = 1.0f + 0.015f * l50 / std::sqrt(20.0f + l50);
+    const float sC = 1.0f + 0.045f * cpMean;
+    const float sH = 1.0f + 0.015f * cpMean * t;
+    const float dTheta = 30.0f * kDegrees * std::exp(-std::pow((hMean / kDegrees - 275.0f) / 25.0f, 2.0f));
+    const float cpMean7 = std::pow(cpMean, 7.0f);
+    const float rT = -2.0f * std::sqrt(cpMean7 / (cpMean7 + 6103515625.0f)) * std::sin(2.0f * dTheta);
+
+    const float l = dL / sL, c = dC / sC, h = dH / sH;
+    return std::sqrt(l * l + c * c + h * h + rT * c * h);
+}
+
+LUTReduction ReduceLUT(const LUT3D& lut, float maxDeltaE) {
+    LUTReduction out;
+    out.sourceDimension = out.dimension = lut.dimension;
+    if (!lut.data || maxDeltaE <= 0.0f || lut.dimension <= kReducedLUTDims[0]) {
+        return out;
+    }
+    const bool shaped = lut.shaper && lut.shaperSize >= 2;
+
+    // Source output over the validation grid, once for every candidate.
+    const int grid = validationDim(lut.dimension);
+    const float gridStep = 1.0f / static_cast<float>(grid - 1);
+    const ResolvedLayer source = ResolveLayer(lut, 1.0f);
+    std::vector<Lab> reference(static_cast<std::size_t>(grid) * grid * grid);
+    Lab* ref = reference.data();
+    for (int b = 0; b < grid; ++b) {
+        for (int g = 0; g < grid; ++g) {
+            for (int r = 0; r < grid; ++r) {
+                *ref++ = DisplayRGBToLab(sampleLUTFast(source, r * gridStep, g * gridStep, b * gridStep));
+            }
+        }
+    }
+
+    // Candidates are resampled in lattice coordinates: for a shaped LUT that
+    // is behind its shaper, which they keep.
+    const ResolvedLayer lattice = ResolveLayer(LUT3D{lut.data, lut.dimension}, 1.0f);
+    for (int dim : kReducedLUTDims) {
+        if (dim >= lut.dimension) break;
+        std::vector<float> data(static_cast<std::size_t>(dim) * dim * dim * 3);
+        const float inv = 1.0f / static_cast<float>(dim - 1);
+        float* dst = data.data();
+        for (int b = 0; b < dim; ++b) {
+            for (int g = 0; g < dim; ++g) {
+                for (int r = 0; r < dim; ++r) {
+                    const RGB c = sampleLUTFast(lattice, r * inv, g * inv, b * inv);
+                    *dst++ = c.r;
+                    *dst++ = c.g;
+                    *dst++ = c.b;
+                }
+            }
+        }
+
+        const ResolvedLayer candidate =
+            ResolveLayer(LUT3D{data.data(), dim, shaped ? lut.shaper : nullptr, shaped ? lut.shaperSize : 0}, 1.0f);
+        float worst = 0.0f;
+        ref = reference.data();
+        for (int b = 0; b < grid && worst <= maxDeltaE; ++b) {
+            for (int g = 0; g < grid; ++g) {
+                for (int r = 0; r < grid; ++r) {
+                    const Lab c = DisplayRGBToLab(sampleLUTFast(candidate, r * gridStep, g * gridStep, b * gridStep));
+                    worst = std::max(worst, DeltaE2000(*ref++, c));
+                }
+            }
+        }
+        if (worst <= maxDeltaE) {
+            out.dimension = dim;
+            out.maxDeltaE = worst;
+            out.data = std::move(data);
+            if (shaped) {
+                out.shaper.assign(lut.shaper, lut.shaper + static_cast<std::size_t>(lut.shaperSize) * 3);
+            }
+            return out;
+        }
+    }
+    return out;
+}
+
+}  // namespace vtc
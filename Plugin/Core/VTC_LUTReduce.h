@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "../Shared/VTC_LUTData.h"
+#include "VTC_LUTKernel.h"
+
+namespace vtc {
+
+// CIELAB (D65) of a display-referred Rec.709 color: BT.1886 decode, then
+// Rec.709 primaries to XYZ.
+struct Lab {
+    float L, a, b;
+};
+
+Lab DisplayRGBToLab(RGB c);
+
+// CIEDE2000 color difference (kL = kC = kH = 1).
+float DeltaE2000(const Lab& x, const Lab& y);
+
+// A look's lattice resampled to the smallest size whose output stays within
+// a CIEDE2000 bound of the original, so interactive renders sample a lattice
+// that fits in a core's cache. Exports keep the original.
+struct LUTReduction {
+    int sourceDimension = 0;
+    int dimension = 0;       // == sourceDimension when no smaller size is within the bound
+    float maxDeltaE = 0.0f;  // of `data` against the source over the validation grid
+    std::vector<float> data;    // dimension^3 RGB, r fastest; empty when not reduced
+    std::vector<float> shaper;  // the source's, copied
+
+    bool reduced() const { return dimension < sourceDimension; }
+
+    LUT3D view() const {
+        return {data.data(), dimension, shaper.empty() ? nullptr : shaper.data(),
+                static_cast<int>(shaper.size() / 3)};
+    }
+
+    std::size_t Bytes() const { return (data.size() + shaper.size()) * sizeof(float); }
+};
+
+// Bound interactive renders use unless VTC_INTERACTIVE_DELTA_E overrides it:
+// about one just-noticeable difference.
+constexpr float kDefaultInteractiveDeltaE = 1.0f;
+
+// Sizes tried, smallest first; only those below the source's are.
+constexpr int kReducedLUTDims[] = {17, 21, 25, 33, 49};
+
+// Tries kReducedLUTDims in order and keeps the first whose largest
+// CIEDE2000 against `lut` over a dense input grid (twice the source's
+// resolution, 65^3 to 129^3) is at most `maxDeltaE`. A shaped LUT keeps its
+// shaper and is resampled in lattice coordinates.
+LUTReduction ReduceLUT(const LUT3D& lut, float maxDeltaE);
+
+}  // namespace vtc
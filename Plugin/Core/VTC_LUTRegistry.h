@@ -1,10 +0,0 @@
-#pragma once
-
-#include "../Shared/VTC_LUTData.h"
-
-namespace vtc {
-
-const LUT3D* GetLogLUT(int index);
-const LUT3D* GetRec709LUT(int index);
-
-}  // namespace vtc
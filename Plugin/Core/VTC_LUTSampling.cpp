@@ -3,18 +3,16 @@
 #include <algorithm>
 #include <cstdint>
 
+#include "VTC_AdaptiveLUT.h"
+#include "VTC_ComputeCache.h"
+#include "VTC_LUTReduce.h"
+#include "VTC_LUTStructure.h"
+#include "VTC_ProgressiveBake.h"
+
 namespace vtc {
 
 namespace {
 
-inline float clamp01(float v) {
-    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
-}
-
-inline float lerp(float a, float b, float t) {
-    return a + (b - a) * t;
-}
-
 struct Pixel8 {
     std::uint8_t r, g, b, a;
 };
@@ -25,73 +23,9 @@ struct Pixel32f {
     float r, g, b, a;
 };
 
-struct ResolvedLayer {
-    const float* data;
-    int dimension;
-    float scale;
-    float intensity;
-};
-
-inline RGB sampleLUTFast(const ResolvedLayer& layer, float r, float g, float b) {
-    const int dim = layer.dimension;
-    const int dimM1 = dim - 1;
-
-    const float x = clamp01(r) * layer.scale;
-    const float y = clamp01(g) * layer.scale;
-    const float z = clamp01(b) * layer.scale;
-
-    const int x0 = static_cast<int>(x);
-    const int y0 = static_cast<int>(y);
-    const int z0 = static_cast<int>(z);
-    const int x1 = std::min(x0 + 1, dimM1);
-    const int y1 = std::min(y0 + 1, dimM1);
-    const int z1 = std::min(z0 + 1, dimM1);
-
-    const float fx = x - x0;
-    const float fy = y - y0;
-    const float fz = z - z0;
-
-    const int dim2 = dim * dim;
-    const float* lut = layer.data;
-
-    const int z0Base = z0 * dim2;
-    const int z1Base = z1 * dim2;
-    const int z0y0 = (z0Base + y0 * dim) * 3;
-    const int z0y1 = (z0Base + y1 * dim) * 3;
-    const int z1y0 = (z1Base + y0 * dim) * 3;
-    const int z1y1 = (z1Base + y1 * dim) * 3;
-
-    const int i000 = z0y0 + x0 * 3;
-    const int i100 = z0y0 + x1 * 3;
-    const int i010 = z0y1 + x0 * 3;
-    const int i110 = z0y1 + x1 * 3;
-    const int i001 = z1y0 + x0 * 3;
-    const int i101 = z1y0 + x1 * 3;
-    const int i011 = z1y1 + x0 * 3;
-    const int i111 = z1y1 + x1 * 3;
-
-    const RGB c000{lut[i000], lut[i000 + 1], lut[i000 + 2]};
-    const RGB c100{lut[i100], lut[i100 + 1], lut[i100 + 2]};
-    const RGB c010{lut[i010], lut[i010 + 1], lut[i010 + 2]};
-    const RGB c110{lut[i110], lut[i110 + 1], lut[i110 + 2]};
-    const RGB c001{lut[i001], lut[i001 + 1], lut[i001 + 2]};
-    const RGB c101{lut[i101], lut[i101 + 1], lut[i101 + 2]};
-    const RGB c011{lut[i011], lut[i011 + 1], lut[i011 + 2]};
-    const RGB c111{lut[i111], lut[i111 + 1], lut[i111 + 2]};
-
-    const RGB c00{lerp(c000.r, c100.r, fx), lerp(c000.g, c100.g, fx), lerp(c000.b, c100.b, fx)};
-    const RGB c10{lerp(c010.r, c110.r, fx), lerp(c010.g, c110.g, fx), lerp(c010.b, c110.b, fx)};
-    const RGB c01{lerp(c001.r, c101.r, fx), lerp(c001.g, c101.g, fx), lerp(c001.b, c101.b, fx)};
-    const RGB c11{lerp(c011.r, c111.r, fx), lerp(c011.g, c111.g, fx), lerp(c011.b, c111.b, fx)};
-
-    const RGB c0{lerp(c00.r, c10.r, fy), lerp(c00.g, c10.g, fy), lerp(c00.b, c10.b, fy)};
-    const RGB c1{lerp(c01.r, c11.r, fy), lerp(c01.g, c11.g, fy), lerp(c01.b, c11.b, fy)};
-
-    return {lerp(c0.r, c1.r, fz), lerp(c0.g, c1.g, fz), lerp(c0.b, c1.b, fz)};
-}
-
+template <int Dim = 0>
 inline RGB applyLayer(const ResolvedLayer& layer, RGB color) {
-    const RGB lutRGB = sampleLUTFast(layer, color.r, color.g, color.b);
+    const RGB lutRGB = sampleLUT<Dim>(layer, color.r, color.g, color.b);
     if (layer.intensity >= 0.9999f) {
         return lutRGB;
     }
@@ -134,31 +68,70 @@ inline Pixel32f fromFloat32(const RGB& c, float a) {
     return {clamp01(c.r), clamp01(c.g), clamp01(c.b), a};
 }
 
+// ── Premultiplied alpha ──
+//
+// The conversions above wrapped for a premultiplied frame: color is divided
+// by alpha on the way in and multiplied by it on the way out, so every
+// kernel below handles both modes in one pass. Color is clamped before it is
+// premultiplied so it never exceeds alpha. A transparent pixel unpremultiplies
+// to black (a select, not a branch) and stays transparent black on the way out.
+
+inline float alphaScale(std::uint8_t a) { return a * (1.0f / 255.0f); }
+inline float alphaScale(std::uint16_t a) { return a * (1.0f / 32768.0f); }
+inline float alphaScale(float a) { return clamp01(a); }
+
+template <typename ToFloatFn>
+auto unpremultiplied(ToFloatFn toFloat) {
+    return [toFloat](const auto& p) {
+        const float a = alphaScale(p.a);
+        const float scale = a > 0.0f ? 1.0f / a : 0.0f;
+        const RGB c = toFloat(p);
+        return RGB{c.r * scale, c.g * scale, c.b * scale};
+    };
+}
+
+template <typename FromFloatFn>
+auto premultiplied(FromFloatFn fromFloat) {
+    return [fromFloat](const RGB& c, auto a) {
+        const float scale = alphaScale(a);
+        return fromFloat(RGB{clamp01(c.r) * scale, clamp01(c.g) * scale, clamp01(c.b) * scale}, a);
+    };
+}
+
+// Calls fn(PixelType{}, toFloat, fromFloat) for `format` and `mode`.
+template <typename Fn>
+void dispatchFormat(FrameFormat format, AlphaMode mode, Fn&& fn) {
+    const bool premul = mode == AlphaMode::kPremultiplied;
+    switch (format) {
+        case FrameFormat::kRGBA_8u:
+            if (premul) fn(Pixel8{}, unpremultiplied(toFloat8), premultiplied(fromFloat8));
+            else fn(Pixel8{}, toFloat8, fromFloat8);
+            break;
+        case FrameFormat::kRGBA_16u:
+            if (premul) fn(Pixel16{}, unpremultiplied(toFloat16), premultiplied(fromFloat16));
+            else fn(Pixel16{}, toFloat16, fromFloat16);
+            break;
+        case FrameFormat::kRGBA_32f:
+            if (premul) fn(Pixel32f{}, unpremultiplied(toFloat32), premultiplied(fromFloat32));
+            else fn(Pixel32f{}, toFloat32, fromFloat32);
+            break;
+    }
+}
+
 struct ActiveLayers {
     ResolvedLayer layers[4];
     int count = 0;
 
-    void tryAdd(const LayerParams& lp, const LUT3D* table, int tableCount) {
-        if (!lp.enabled || lp.lutIndex < 0 || lp.lutIndex >= tableCount || lp.intensity <= 0.0001f) {
-            return;
-        }
-        const LUT3D& lut = table[lp.lutIndex];
-        ResolvedLayer& rl = layers[count++];
-        rl.data = lut.data;
-        rl.dimension = lut.dimension;
-        rl.scale = static_cast<float>(lut.dimension - 1);
-        rl.intensity = clamp01(lp.intensity);
-    }
-
-    bool any() const {
-        return count > 0;
+    void add(const LUT3D& lut, float intensity) {
+        layers[count++] = ResolveLayer(lut, intensity);
     }
 };
 
-template <int LayerCount>
+// `Dim` (0 = any) is the size of the first layer's lattice.
+template <int LayerCount, int Dim>
 inline RGB processPixelN(RGB color, const ActiveLayers& al) {
     if constexpr (LayerCount >= 1) {
-        color = applyLayer(al.layers[0], color);
+        color = applyLayer<Dim>(al.layers[0], color);
     }
     if constexpr (LayerCount >= 2) {
         color = applyLayer(al.layers[1], color);
@@ -172,7 +145,7 @@ inline RGB processPixelN(RGB color, const ActiveLayers& al) {
     return color;
 }
 
-template <int LayerCount, typename PixelType, typename ToFloatFn, typename FromFloatFn>
+template <int LayerCount, int Dim, typename PixelType, typename ToFloatFn, typename FromFloatFn>
 void processTypedN(const ActiveLayers& al, const FrameDesc& src, FrameDesc& dst, ToFloatFn toFloat, FromFloatFn fromFloat) {
     const auto* srcBytes = static_cast<const std::uint8_t*>(src.data);
     auto* dstBytes = static_cast<std::uint8_t*>(dst.data);
@@ -181,81 +154,190 @@ void processTypedN(const ActiveLayers& al, const FrameDesc& src, FrameDesc& dst,
         auto* dstRow = reinterpret_cast<PixelType*>(dstBytes + y * dst.rowBytes);
         for (int x = 0; x < src.width; ++x) {
             const PixelType& s = srcRow[x];
-            RGB color = processPixelN<LayerCount>(toFloat(s), al);
+            RGB color = processPixelN<LayerCount, Dim>(toFloat(s), al);
             dstRow[x] = fromFloat(color, s.a);
         }
     }
 }
 
+// A single lattice (one layer, or the composite of several) is what nearly
+// every frame runs, so its native sizes get their own kernel.
+template <typename PixelType, typename ToFloatFn, typename FromFloatFn>
+void processTyped(const ActiveLayers& al, const FrameDesc& src, FrameDesc& dst, ToFloatFn toFloat,
+                  FromFloatFn fromFloat) {
+    switch (al.count) {
+        case 1:
+            switch (al.layers[0].dimension) {
+                case 17:
+                    processTypedN<1, 17, PixelType>(al, src, dst, toFloat, fromFloat);
+                    break;
+                case 33:
+                    processTypedN<1, 33, PixelType>(al, src, dst, toFloat, fromFloat);
+                    break;
+                case 65:
+                    processTypedN<1, 65, PixelType>(al, src, dst, toFloat, fromFloat);
+                    break;
+                case 129:
+                    processTypedN<1, 129, PixelType>(al, src, dst, toFloat, fromFloat);
+                    break;
+                default:
+                    processTypedN<1, 0, PixelType>(al, src, dst, toFloat, fromFloat);
+                    break;
+            }
+            break;
+        case 2:
+            processTypedN<2, 0, PixelType>(al, src, dst, toFloat, fromFloat);
+            break;
+        case 3:
+            processTypedN<3, 0, PixelType>(al, src, dst, toFloat, fromFloat);
+            break;
+        default:
+            processTypedN<4, 0, PixelType>(al, src, dst, toFloat, fromFloat);
+            break;
+    }
+}
+
+// One lattice held as an AdaptiveLUT.
+template <typename PixelType, typename ToFloatFn, typename FromFloatFn>
+void processAdaptive(const AdaptiveLUT& lut, float intensity, const FrameDesc& src, FrameDesc& dst, ToFloatFn toFloat,
+                     FromFloatFn fromFloat) {
+    const auto* srcBytes = static_cast<const std::uint8_t*>(src.data);
+    auto* dstBytes = static_cast<std::uint8_t*>(dst.data);
+    const bool full = intensity >= 0.9999f;
+    for (int y = 0; y < src.height; ++y) {
+        const auto* srcRow = reinterpret_cast<const PixelType*>(srcBytes + y * src.rowBytes);
+        auto* dstRow = reinterpret_cast<PixelType*>(dstBytes + y * dst.rowBytes);
+        for (int x = 0; x < src.width; ++x) {
+            const PixelType& s = srcRow[x];
+            const RGB color = toFloat(s);
+            RGB lutRGB = lut.Sample(color.r, color.g, color.b);
+            if (!full) {
+                lutRGB = {lerp(color.r, lutRGB.r, intensity), lerp(color.g, lutRGB.g, intensity),
+                          lerp(color.b, lutRGB.b, intensity)};
+            }
+            dstRow[x] = fromFloat(lutRGB, s.a);
+        }
+    }
+}
+
+// A LUT that is an affine map, per-channel curves or a closed-form camera
+// conversion: no lattice lookups.
+template <LUTClass Kind, typename PixelType, typename ToFloatFn, typename FromFloatFn>
+void processStructuredN(const LUTStructure& s, float intensity, const FrameDesc& src, FrameDesc& dst,
+                        ToFloatFn toFloat, FromFloatFn fromFloat) {
+    const auto* srcBytes = static_cast<const std::uint8_t*>(src.data);
+    auto* dstBytes = static_cast<std::uint8_t*>(dst.data);
+    const bool full = intensity >= 0.9999f;
+    for (int y = 0; y < src.height; ++y) {
+        const auto* srcRow = reinterpret_cast<const PixelType*>(srcBytes + y * src.rowBytes);
+        auto* dstRow = reinterpret_cast<PixelType*>(dstBytes + y * dst.rowBytes);
+        for (int x = 0; x < src.width; ++x) {
+            const PixelType& p = srcRow[x];
+            const RGB color = toFloat(p);
+            RGB out = ApplyStructure<Kind>(s, color.r, color.g, color.b);
+            if (!full) {
+                out = {lerp(color.r, out.r, intensity), lerp(color.g, out.g, intensity),
+                       lerp(color.b, out.b, intensity)};
+            }
+            dstRow[x] = fromFloat(out, p.a);
+        }
+    }
+}
+
+template <typename PixelType, typename ToFloatFn, typename FromFloatFn>
+void processStructured(const LUTStructure& s, float intensity, const FrameDesc& src, FrameDesc& dst,
+                       ToFloatFn toFloat, FromFloatFn fromFloat) {
+    if (s.kind == LUTClass::kAffine) {
+        processStructuredN<LUTClass::kAffine, PixelType>(s, intensity, src, dst, toFloat, fromFloat);
+    } else if (s.kind == LUTClass::kAnalytic) {
+        processStructuredN<LUTClass::kAnalytic, PixelType>(s, intensity, src, dst, toFloat, fromFloat);
+    } else {
+        processStructuredN<LUTClass::kSeparable, PixelType>(s, intensity, src, dst, toFloat, fromFloat);
+    }
+}
+
 }  // namespace
 
-void ProcessFrameCPU(const ParamsSnapshot& params, const FrameDesc& src, FrameDesc& dst) {
+void ProcessFrameCPU(const ParamsSnapshot& params, const FrameDesc& src, FrameDesc& dst,
+                     const RenderHints& hints) {
     if (!IsSupported(src) || !IsSupported(dst) || !SameGeometry(src, dst)) {
         CopyFrame(src, dst);
         return;
     }
 
-    ActiveLayers al;
-    al.tryAdd(params.logConvert, kLogLUTs, kLogLUTCount);
-    al.tryAdd(params.creative, kRec709LUTs, kRec709LUTCount);
-    al.tryAdd(params.secondary, kRec709LUTs, kRec709LUTCount);
-    al.tryAdd(params.accent, kRec709LUTs, kRec709LUTCount);
-
-    if (!al.any()) {
+    const ResolvedStack stack = ResolveStack(params);
+    if (stack.Empty()) {
         CopyFrame(src, dst);
         return;
     }
 
-    switch (src.format) {
-        case FrameFormat::kRGBA_8u:
-            switch (al.count) {
-                case 1:
-                    processTypedN<1, Pixel8>(al, src, dst, toFloat8, fromFloat8);
-                    break;
-                case 2:
-                    processTypedN<2, Pixel8>(al, src, dst, toFloat8, fromFloat8);
-                    break;
-                case 3:
-                    processTypedN<3, Pixel8>(al, src, dst, toFloat8, fromFloat8);
-                    break;
-                default:
-                    processTypedN<4, Pixel8>(al, src, dst, toFloat8, fromFloat8);
-                    break;
-            }
-            break;
-        case FrameFormat::kRGBA_16u:
-            switch (al.count) {
-                case 1:
-                    processTypedN<1, Pixel16>(al, src, dst, toFloat16, fromFloat16);
-                    break;
-                case 2:
-                    processTypedN<2, Pixel16>(al, src, dst, toFloat16, fromFloat16);
-                    break;
-                case 3:
-                    processTypedN<3, Pixel16>(al, src, dst, toFloat16, fromFloat16);
-                    break;
-                default:
-                    processTypedN<4, Pixel16>(al, src, dst, toFloat16, fromFloat16);
-                    break;
-            }
-            break;
-        case FrameFormat::kRGBA_32f:
-            switch (al.count) {
-                case 1:
-                    processTypedN<1, Pixel32f>(al, src, dst, toFloat32, fromFloat32);
-                    break;
-                case 2:
-                    processTypedN<2, Pixel32f>(al, src, dst, toFloat32, fromFloat32);
-                    break;
-                case 3:
-                    processTypedN<3, Pixel32f>(al, src, dst, toFloat32, fromFloat32);
-                    break;
-                default:
-                    processTypedN<4, Pixel32f>(al, src, dst, toFloat32, fromFloat32);
-                    break;
-            }
-            break;
+    // An affine or separable stack needs no lattice: one layer's structure
+    // (analytic included), or all of them composed with the trims.
+    LUTStructure collapsed;
+    const LUTStructure* structure = nullptr;
+    float structureIntensity = 1.0f;
+    if (stack.count == 1 && !stack.NeedsComposite()) {
+        structure = stack.layers[0].structure;
+        structureIntensity = stack.layers[0].intensity;
+    } else if (CollapseStructured(stack, collapsed)) {
+        structure = &collapsed;
+    }
+    const AlphaMode alphaMode = params.alphaMode;
+    if (structure) {
+        dispatchFormat(src.format, alphaMode, [&](auto pixel, auto toFloat, auto fromFloat) {
+            processStructured<decltype(pixel)>(*structure, structureIntensity, src, dst, toFloat, fromFloat);
+        });
+        return;
+    }
+
+    // Two or more layers, a layer and its trims, or a transition between two
+    // stacks, collapse into one baked lattice: one lookup per pixel. The
+    // composite is held for the whole frame so eviction cannot free it.
+    std::shared_ptr<const CompositeLUT> composite;
+    if (stack.NeedsComposite()) {
+        if (hints.cache && !hints.interactive) {
+            composite = hints.cache->AcquireComposite(params);
+        } else {
+            composite = AcquireRenderComposite(stack, hints.interactive ? CompositeQuality::kProgressive
+                                                                        : CompositeQuality::kFinal);
+        }
     }
+
+    // An interactive render of a single look samples its reduced lattice
+    // once one is built; exports always take the full one.
+    std::shared_ptr<const LUTReduction> reduced =
+        !composite && hints.interactive ? AcquireReduced(stack.layers[0]) : nullptr;
+
+    // Above 65^3 the lattice no longer stays in cache; sample its adaptive
+    // form once one is built.
+    std::shared_ptr<const AdaptiveLUT> adaptive;
+    if (composite) {
+        adaptive = composite->adaptive;
+    } else if (!reduced) {
+        adaptive = AcquireAdaptive(stack.layers[0]);
+    }
+    if (adaptive) {
+        const float intensity = composite ? 1.0f : stack.layers[0].intensity;
+        dispatchFormat(src.format, alphaMode, [&](auto pixel, auto toFloat, auto fromFloat) {
+            processAdaptive<decltype(pixel)>(*adaptive, intensity, src, dst, toFloat, fromFloat);
+        });
+        return;
+    }
+
+    ActiveLayers al;
+    if (composite) {
+        al.add(composite->view(), 1.0f);
+    } else if (reduced) {
+        al.add(reduced->view(), stack.layers[0].intensity);
+    } else {
+        for (int i = 0; i < stack.count; ++i) {
+            al.add(*stack.layers[i].lut, stack.layers[i].intensity);
+        }
+    }
+
+    dispatchFormat(src.format, alphaMode, [&](auto pixel, auto toFloat, auto fromFloat) {
+        processTyped<decltype(pixel)>(al, src, dst, toFloat, fromFloat);
+    });
 }
 
 }  // namespace vtc
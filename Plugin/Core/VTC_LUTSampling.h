@@ -4,13 +4,24 @@
 #include "../Shared/VTC_Frame.h"
 #include "../Shared/VTC_LUTData.h"
 #include "VTC_CopyUtils.h"
+#include "VTC_LUTKernel.h"
 
 namespace vtc {
 
-struct RGB {
-    float r, g, b;
+class ComputeCache;
+
+struct RenderHints {
+    // Interactive renders may use a draft composite while the full one bakes
+    // in the background (see VTC_ProgressiveBake.h). Exports leave this off.
+    bool interactive = false;
+
+    // Where final-quality composites come from when the host shares derived
+    // data between render threads (see VTC_ComputeCache.h). Null bakes
+    // locally.
+    ComputeCache* cache = nullptr;
 };
 
-void ProcessFrameCPU(const ParamsSnapshot& params, const FrameDesc& src, FrameDesc& dst);
+void ProcessFrameCPU(const ParamsSnapshot& params, const FrameDesc& src, FrameDesc& dst,
+                     const RenderHints& hints = RenderHints{});
 
 }  // namespace vtc
@@ -0,0 +1,280 @@
+#include "VTC_LUTStructure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vtc {
+
+namespace {
+
+constexpr float kRangeSlack = 1e-6f;
+
+bool inUnitRange(float v) {
+    return v >= -kRangeSlack && v <= 1.0f + kRangeSlack;
+}
+
+// An affine map keeps the unit cube inside it iff all eight corners land in it.
+bool affineInUnitCube(const LUTStructure& s) {
+    for (int corner = 0; corner < 8; ++corner) {
+        const RGB c = ApplyAffine(s, static_cast<float>(corner & 1), static_cast<float>((corner >> 1) & 1),
+                                  static_cast<float>((corner >> 2) & 1));
+        if (!inUnitRange(c.r) || !inUnitRange(c.g) || !inUnitRange(c.b)) return false;
+    }
+    return true;
+}
+
+bool curvesInUnitRange(const LUTStructure& s) {
+    return std::all_of(s.curves.begin(), s.curves.end(), inUnitRange);
+}
+
+bool isAffine(const LUTStructure& s) {
+    return s.kind == LUTClass::kIdentity || s.kind == LUTClass::kAffine;
+}
+
+// Each output channel depends on its own input channel only.
+bool isDiagonal(const LUTStructure& s) {
+    if (s.kind != LUTClass::kAffine) return s.kind == LUTClass::kIdentity || s.kind == LUTClass::kSeparable;
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            if (row != col && s.matrix[row][col] != 0.0f) return false;
+        }
+    }
+    return true;
+}
+
+// Channel `c` of lerp(x, S(x), t) for a diagonal structure.
+float blendedChannel(const LUTStructure& s, float t, int c, float x) {
+    float y = x;
+    if (s.kind == LUTClass::kAffine) {
+        y = s.matrix[c][c] * x + s.offset[c];
+    } else if (s.kind == LUTClass::kSeparable) {
+        y = SampleCurve(s.curves.data() + c * s.curveSize, s.curveSize, x);
+    }
+    return lerp(x, y, t);
+}
+
+// lerp(x, S(x), t) = ((1 - t) I + t M) x + t offset.
+void blendedAffine(const LUTStructure& s, float t, float m[3][3], float o[3]) {
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            m[row][col] = t * s.matrix[row][col] + (row == col ? 1.0f - t : 0.0f);
+        }
+        o[row] = t * s.offset[row];
+    }
+}
+
+}  // namespace
+
+LUTAnalysis AnalyzeLattice(const LUT3D& lut) {
+    LUTAnalysis a = {};
+    const int n = lut.dimension;
+    std::uint64_t h = 1469598103934665603ull;
+    auto hash = [&h](const float* values, std::size_t count) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+        for (std::size_t i = 0; i < count * sizeof(float); ++i) {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+    };
+    if (lut.data && n > 0) hash(lut.data, static_cast<std::size_t>(n) * n * n * 3);
+    if (lut.shaper) hash(lut.shaper, static_cast<std::size_t>(lut.shaperSize) * 3);
+    a.contentHash = h;
+    if (!lut.data || n < 2) return a;
+
+    auto node = [&](int x, int y, int z) {
+        return lut.data + ((static_cast<std::size_t>(z) * n + y) * n + x) * 3;
+    };
+    const float inv = 1.0f / static_cast<float>(n - 1);
+
+    // First pass: everything but the affine error, plus the sums for the
+    // least-squares fit. On the full grid the three inputs are uncorrelated
+    // with equal variance, so each slope is a covariance over that variance.
+    double sum[3] = {}, sumU[3][3] = {};
+    for (int c = 0; c < 3; ++c) {
+        a.outputMin[c] = node(0, 0, 0)[c];
+        a.outputMax[c] = a.outputMin[c];
+    }
+    const float* axis[3] = {node(0, 0, 0), node(0, 0, 0), node(0, 0, 0)};
+    const std::size_t stride[3] = {3, static_cast<std::size_t>(n) * 3, static_cast<std::size_t>(n) * n * 3};
+    for (int z = 0; z < n; ++z) {
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                const float* p = node(x, y, z);
+                const int i[3] = {x, y, z};
+                for (int c = 0; c < 3; ++c) {
+                    const float u = i[c] * inv;
+                    a.identityError = std::max(a.identityError, std::fabs(p[c] - u));
+                    a.separableError = std::max(a.separableError, std::fabs(p[c] - axis[c][i[c] * stride[c] + c]));
+                    a.outputMin[c] = std::min(a.outputMin[c], p[c]);
+                    a.outputMax[c] = std::max(a.outputMax[c], p[c]);
+                    sum[c] += p[c];
+                    for (int col = 0; col < 3; ++col) sumU[c][col] += static_cast<double>(p[c]) * i[col];
+                    if (i[c] + 1 < n) {
+                        for (int out = 0; out < 3; ++out) {
+                            const float step = std::fabs(p[stride[c] + out] - p[out]) * (n - 1);
+                            a.maxGradient = std::max(a.maxGradient, step);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    const double count = static_cast<double>(n) * n * n;
+    const double meanI = 0.5 * (n - 1);
+    const double varI = (static_cast<double>(n) * n - 1.0) / 12.0;  // of 0..n-1
+    for (int row = 0; row < 3; ++row) {
+        const double mean = sum[row] / count;
+        double offset = mean;
+        for (int col = 0; col < 3; ++col) {
+            const double slope = (sumU[row][col] / count - mean * meanI) / varI * (n - 1);
+            a.matrix[row][col] = static_cast<float>(slope);
+            offset -= slope * 0.5;
+        }
+        a.offset[row] = static_cast<float>(offset);
+    }
+
+    LUTStructure fit;
+    std::copy(&a.matrix[0][0], &a.matrix[0][0] + 9, &fit.matrix[0][0]);
+    std::copy(a.offset, a.offset + 3, fit.offset);
+    for (int z = 0; z < n; ++z) {
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                const float* p = node(x, y, z);
+                const RGB f = ApplyAffine(fit, x * inv, y * inv, z * inv);
+                a.affineError = std::max({a.affineError, std::fabs(p[0] - f.r), std::fabs(p[1] - f.g),
+                                          std::fabs(p[2] - f.b)});
+            }
+        }
+    }
+    return a;
+}
+
+LUTStructure StructureFromAnalysis(const LUT3D& lut, const LUTAnalysis& a, float tolerance) {
+    LUTStructure s;
+    const int n = lut.dimension;
+    if (!lut.data || n < 2) {
+        s.kind = LUTClass::kGeneral;
+        return s;
+    }
+    const bool shaped = lut.shaper && lut.shaperSize >= 2;
+    if (!shaped && a.identityError <= tolerance) {
+        s.kind = LUTClass::kIdentity;
+        s.maxError = a.identityError;
+        s.unitRange = true;
+        return s;
+    }
+
+    if (a.affineError <= tolerance) {
+        s.kind = LUTClass::kAffine;
+        s.maxError = a.affineError;
+        std::copy(&a.matrix[0][0], &a.matrix[0][0] + 9, &s.matrix[0][0]);
+        std::copy(a.offset, a.offset + 3, s.offset);
+        s.unitRange = affineInUnitCube(s);
+    } else if (a.separableError <= tolerance) {
+        // The curves are the lattice's axes through black: n nodes each.
+        s.kind = LUTClass::kSeparable;
+        s.maxError = a.separableError;
+        s.curveSize = n;
+        s.curves.resize(static_cast<std::size_t>(n) * 3);
+        const std::size_t stride[3] = {3, static_cast<std::size_t>(n) * 3, static_cast<std::size_t>(n) * n * 3};
+        for (int c = 0; c < 3; ++c) {
+            for (int i = 0; i < n; ++i) {
+                s.curves[c * n + i] = lut.data[i * stride[c] + c];
+            }
+        }
+        s.unitRange = curvesInUnitRange(s);
+    } else {
+        s.kind = LUTClass::kGeneral;
+        return s;
+    }
+    if (shaped) {
+        s.shaperSize = lut.shaperSize;
+        s.shaper.assign(lut.shaper, lut.shaper + static_cast<std::size_t>(lut.shaperSize) * 3);
+    }
+    return s;
+}
+
+LUTStructure AnalyzeStructure(const LUT3D& lut, float tolerance) {
+    return StructureFromAnalysis(lut, lut.analysis ? *lut.analysis : AnalyzeLattice(lut), tolerance);
+}
+
+LUTStructure AffineStructure(const float matrix[3][3], const float offset[3]) {
+    LUTStructure s;
+    s.kind = LUTClass::kAffine;
+    std::copy(&matrix[0][0], &matrix[0][0] + 9, &s.matrix[0][0]);
+    std::copy(offset, offset + 3, s.offset);
+    s.unitRange = affineInUnitCube(s);
+    return s;
+}
+
+float StructureNodeError(const LUTStructure& s, const LUT3D& lut) {
+    const int n = lut.dimension;
+    if (!lut.data || n < 2 || (lut.shaper && lut.shaperSize >= 2) || !s.fast()) {
+        return std::numeric_limits<float>::infinity();
+    }
+    auto apply = [&s](float r, float g, float b) {
+        switch (s.kind) {
+            case LUTClass::kIdentity: return ApplyStructure<LUTClass::kIdentity>(s, r, g, b);
+            case LUTClass::kAffine: return ApplyStructure<LUTClass::kAffine>(s, r, g, b);
+            case LUTClass::kSeparable: return ApplyStructure<LUTClass::kSeparable>(s, r, g, b);
+            default: return ApplyStructure<LUTClass::kAnalytic>(s, r, g, b);
+        }
+    };
+    const float inv = 1.0f / static_cast<float>(n - 1);
+    float worst = 0.0f;
+    const float* p = lut.data;
+    for (int z = 0; z < n; ++z) {
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x, p += 3) {
+                const RGB c = apply(x * inv, y * inv, z * inv);
+                worst = std::max({worst, std::fabs(c.r - p[0]), std::fabs(c.g - p[1]), std::fabs(c.b - p[2])});
+            }
+        }
+    }
+    return worst;
+}
+
+bool ComposeStructures(const LUTStructure& inner, float innerIntensity, const LUTStructure& outer,
+                       float outerIntensity, LUTStructure& out) {
+    if (!inner.fast() || !outer.fast() || inner.shaperSize || outer.shaperSize || !inner.unitRange) {
+        return false;
+    }
+
+    LUTStructure result;
+    result.maxError = inner.maxError + outer.maxError;
+    if (isAffine(inner) && isAffine(outer)) {
+        float mi[3][3], oi[3], mo[3][3], oo[3];
+        blendedAffine(inner, innerIntensity, mi, oi);
+        blendedAffine(outer, outerIntensity, mo, oo);
+        result.kind = LUTClass::kAffine;
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                result.matrix[row][col] = mo[row][0] * mi[0][col] + mo[row][1] * mi[1][col] + mo[row][2] * mi[2][col];
+            }
+            result.offset[row] = mo[row][0] * oi[0] + mo[row][1] * oi[1] + mo[row][2] * oi[2] + oo[row];
+        }
+        result.unitRange = affineInUnitCube(result);
+    } else if (isDiagonal(inner) && isDiagonal(outer)) {
+        // Composed curves have the breakpoints of both; a fine table keeps
+        // them to within resampling error.
+        const int size = LUTStructure::kComposedCurveSize;
+        const float inv = 1.0f / static_cast<float>(size - 1);
+        result.kind = LUTClass::kSeparable;
+        result.curveSize = size;
+        result.curves.resize(static_cast<std::size_t>(size) * 3);
+        for (int c = 0; c < 3; ++c) {
+            for (int i = 0; i < size; ++i) {
+                const float mid = clamp01(blendedChannel(inner, innerIntensity, c, i * inv));
+                result.curves[c * size + i] = blendedChannel(outer, outerIntensity, c, mid);
+            }
+        }
+        result.unitRange = curvesInUnitRange(result);
+    } else {
+        return false;
+    }
+    out = std::move(result);
+    return true;
+}
+
+}  // namespace vtc
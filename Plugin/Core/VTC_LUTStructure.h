@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../Shared/VTC_LUTData.h"
+#include "VTC_LUTKernel.h"
+
+namespace vtc {
+
+// What a LUT does to its input, as far as the library has looked.
+enum class LUTClass : std::uint8_t {
+    kUnknown,    // not loaded yet
+    kIdentity,   // every node maps to itself
+    kAffine,     // out = matrix * in + offset
+    kSeparable,  // each output channel is a curve of the same input channel
+    kAnalytic,   // closed-form camera log conversion (VTC_LogTransforms.h)
+    kGeneral,
+};
+
+// A LUT in the cheapest form that reproduces its lattice within a
+// tolerance. Trilinear interpolation of an affine or separable lattice is
+// exactly that affine map or those linear curves, so the error is only the
+// fit at the nodes.
+//
+// Matrix and curves act on the lattice coordinate: the clamped input, or its
+// shaper output for a shaped LUT.
+struct LUTStructure {
+    static constexpr int kComposedCurveSize = 1025;
+
+    LUTClass kind = LUTClass::kUnknown;
+    float maxError = 0.0f;  // largest node deviation from the lattice
+    bool unitRange = false;  // maps [0,1]^3 into [0,1]^3, so a later layer's clamp is a no-op
+
+    float matrix[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};  // kIdentity, kAffine
+    float offset[3] = {};
+
+    std::vector<float> curves;  // kSeparable: curveSize samples per channel, r then g then b
+    int curveSize = 0;
+
+    std::vector<float> shaper;  // copied from the LUT; empty when uniform
+    int shaperSize = 0;
+
+    // kAnalytic: encode(clamp01(matrix * decode(in))), one decode (log code
+    // to linear) and one encode (linear to display) table for all channels.
+    // tableSize samples over [0,1], each stored with the slope to the next
+    // (0 for the last) so a lookup is one load and a multiply-add.
+    std::vector<float> decode;
+    std::vector<float> encode;
+    int tableSize = 0;
+
+    bool fast() const { return kind != LUTClass::kUnknown && kind != LUTClass::kGeneral; }
+};
+
+// Measures `lut` in one pass over its nodes plus one for the affine error.
+// The baker stores the result with each built-in table (LUT3D::analysis).
+LUTAnalysis AnalyzeLattice(const LUT3D& lut);
+
+// Classifies `lut` from its analysis, with every node within `tolerance` of
+// the fast form; kGeneral when none fits. Reads only the n nodes along each
+// axis (for separable curves), never the whole lattice.
+LUTStructure StructureFromAnalysis(const LUT3D& lut, const LUTAnalysis& analysis, float tolerance);
+
+// Same, from the baked analysis when `lut` has one and AnalyzeLattice
+// otherwise.
+LUTStructure AnalyzeStructure(const LUT3D& lut, float tolerance);
+
+// `matrix * in + offset` as a kAffine structure, with unitRange set.
+LUTStructure AffineStructure(const float matrix[3][3], const float offset[3]);
+
+// Largest difference between `s` and the lattice at its nodes; how a
+// structure built elsewhere is checked against the LUT it replaces. Only
+// uniform lattices have nodes on the input grid: a shaped one reports
+// infinity.
+float StructureNodeError(const LUTStructure& s, const LUT3D& lut);
+
+// `outer` applied after `inner` as one structure, each first blended with
+// its input by its intensity as a layer would be. False when the pair has no
+// closed form: a general, analytic or shaped member, an inner that leaves
+// the unit cube (the outer layer would clamp it), or a matrix that mixes
+// channels next to a curve.
+bool ComposeStructures(const LUTStructure& inner, float innerIntensity, const LUTStructure& outer,
+                       float outerIntensity, LUTStructure& out);
+
+// ── Kernels ──
+
+inline RGB ApplyAffine(const LUTStructure& s, float r, float g, float b) {
+    return {s.matrix[0][0] * r + s.matrix[0][1] * g + s.matrix[0][2] * b + s.offset[0],
+            s.matrix[1][0] * r + s.matrix[1][1] * g + s.matrix[1][2] * b + s.offset[1],
+            s.matrix[2][0] * r + s.matrix[2][1] * g + s.matrix[2][2] * b + s.offset[2]};
+}
+
+inline float SampleCurve(const float* curve, int size, float v) {
+    const float x = v * static_cast<float>(size - 1);
+    const int i = std::min(static_cast<int>(x), size - 2);
+    return lerp(curve[i], curve[i + 1], x - i);
+}
+
+inline RGB ApplySeparable(const LUTStructure& s, float r, float g, float b) {
+    const float* curve = s.curves.data();
+    const int n = s.curveSize;
+    return {SampleCurve(curve, n, r), SampleCurve(curve + n, n, g), SampleCurve(curve + 2 * n, n, b)};
+}
+
+// `table` holds (value, slope) pairs; `scale` is their count less one.
+inline float SampleSlopeTable(const float* table, float scale, float v) {
+    const float x = clamp01(v) * scale;
+    const int i = static_cast<int>(x);
+    return table[2 * i] + table[2 * i + 1] * (x - static_cast<float>(i));
+}
+
+// The decode table covers log code values [0,1]; its output is scene linear
+// and may exceed 1.
+inline RGB ApplyAnalytic(const LUTStructure& s, float r, float g, float b) {
+    const float* decode = s.decode.data();
+    const float* encode = s.encode.data();
+    const float scale = static_cast<float>(s.tableSize - 1);
+    const RGB lin = ApplyAffine(s, SampleSlopeTable(decode, scale, r), SampleSlopeTable(decode, scale, g),
+                                SampleSlopeTable(decode, scale, b));
+    return {SampleSlopeTable(encode, scale, lin.r), SampleSlopeTable(encode, scale, lin.g),
+            SampleSlopeTable(encode, scale, lin.b)};
+}
+
+// Same result as sampleLUT on the lattice `s` was built from, to within
+// s.maxError. `Kind` is s.kind, hoisted out of the pixel loop.
+template <LUTClass Kind>
+inline RGB ApplyStructure(const LUTStructure& s, float r, float g, float b) {
+    if (Kind == LUTClass::kIdentity) {
+        return {clamp01(r), clamp01(g), clamp01(b)};
+    }
+    if (Kind == LUTClass::kAnalytic) {
+        return ApplyAnalytic(s, r, g, b);
+    }
+    r = clamp01(r);
+    g = clamp01(g);
+    b = clamp01(b);
+    if (s.shaperSize) {
+        const float* curve = s.shaper.data();
+        r = ApplyShaper(curve, s.shaperSize, r);
+        g = ApplyShaper(curve + s.shaperSize, s.shaperSize, g);
+        b = ApplyShaper(curve + 2 * s.shaperSize, s.shaperSize, b);
+    }
+    return Kind == LUTClass::kAffine ? ApplyAffine(s, r, g, b) : ApplySeparable(s, r, g, b);
+}
+
+}  // namespace vtc
@@ -0,0 +1,157 @@
+#include "VTC_LogTransforms.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace vtc {
+
+namespace {
+
+// Fine enough that linear interpolation of either curve stays orders of
+// magnitude under the lattice's error; 64 KB per conversion.
+constexpr int kTableSize = 4096;
+
+using Mat3 = double[3][3];
+
+struct Primaries {
+    double rx, ry, gx, gy, bx, by;
+};
+
+constexpr double kD65x = 0.3127;
+constexpr double kD65y = 0.3290;
+
+constexpr Primaries kRec709 = {0.64, 0.33, 0.30, 0.60, 0.15, 0.06};
+constexpr Primaries kSGamut3Cine = {0.766, 0.275, 0.225, 0.800, 0.089, -0.087};
+constexpr Primaries kCinemaGamut = {0.74, 0.27, 0.17, 1.14, 0.08, -0.10};
+constexpr Primaries kRec2020 = {0.708, 0.292, 0.170, 0.797, 0.131, 0.046};
+constexpr Primaries kREDWideGamut = {0.780308, 0.304253, 0.121595, 1.493994, 0.095612, -0.084589};
+
+// ── Log curves: code value [0,1] to scene linear (0.18 = mid grey) ──
+
+double sLog3ToLinear(double x) {
+    const double cv = x * 1023.0;
+    if (cv >= 171.2102946929) {
+        return std::pow(10.0, (cv - 420.0) / 261.5) * (0.18 + 0.01) - 0.01;
+    }
+    return (cv - 95.0) * 0.01125 / (171.2102946929 - 95.0);
+}
+
+double canonLogToLinear(double x) {
+    // 0.9: Canon's published transforms scale Canon Log linear to reflectance.
+    const double t = (x - 0.0730597) / 0.529136;
+    const double v = t < 0.0 ? -(std::pow(10.0, -t) - 1.0) / 10.1596 : (std::pow(10.0, t) - 1.0) / 10.1596;
+    return v * 0.9;
+}
+
+double fLogToLinear(double x) {
+    if (x >= 0.100537775223865) {
+        return (std::pow(10.0, (x - 0.790453) / 0.344676) - 0.009468) / 0.555556;
+    }
+    return (x - 0.092864) / 8.735631;
+}
+
+double log3G10ToLinear(double x) {
+    if (x < 0.0) {
+        return x / 15.1927 - 0.01;
+    }
+    return (std::pow(10.0, x / 0.224282) - 1.0) / 155.975327 - 0.01;
+}
+
+double rec709Encode(double v) {
+    return v < 0.018 ? 4.5 * v : 1.099 * std::pow(v, 0.45) - 0.099;
+}
+
+// ── Gamut ──
+
+bool invert(const Mat3 m, Mat3 out) {
+    const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                       m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                       m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    if (std::fabs(det) < 1e-12) return false;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            // Cofactor of (c, r), for the transpose.
+            const int r0 = (c + 1) % 3, r1 = (c + 2) % 3, c0 = (r + 1) % 3, c1 = (r + 2) % 3;
+            out[r][c] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / det;
+        }
+    }
+    return true;
+}
+
+// RGB to XYZ for primaries with a D65 white.
+void rgbToXYZ(const Primaries& p, Mat3 out) {
+    const double xy[3][2] = {{p.rx, p.ry}, {p.gx, p.gy}, {p.bx, p.by}};
+    Mat3 prim;
+    for (int c = 0; c < 3; ++c) {
+        prim[0][c] = xy[c][0] / xy[c][1];
+        prim[1][c] = 1.0;
+        prim[2][c] = (1.0 - xy[c][0] - xy[c][1]) / xy[c][1];
+    }
+    const double white[3] = {kD65x / kD65y, 1.0, (1.0 - kD65x - kD65y) / kD65y};
+    Mat3 inv;
+    invert(prim, inv);
+    for (int c = 0; c < 3; ++c) {
+        const double scale = inv[c][0] * white[0] + inv[c][1] * white[1] + inv[c][2] * white[2];
+        for (int r = 0; r < 3; ++r) {
+            out[r][c] = prim[r][c] * scale;
+        }
+    }
+}
+
+// kTableSize (value, slope) pairs of `f` over [0,1]; see LUTStructure::decode.
+void fillSlopeTable(double (*f)(double), std::vector<float>& out) {
+    out.resize(static_cast<std::size_t>(kTableSize) * 2);
+    for (int i = 0; i < kTableSize; ++i) {
+        const double x = static_cast<double>(i) / (kTableSize - 1);
+        out[2 * i] = static_cast<float>(f(x));
+    }
+    for (int i = 0; i < kTableSize; ++i) {
+        out[2 * i + 1] = i + 1 < kTableSize ? out[2 * i + 2] - out[2 * i] : 0.0f;
+    }
+}
+
+struct Conversion {
+    const char* name;
+    double (*toLinear)(double);
+    const Primaries* gamut;
+};
+
+const Conversion kConversions[] = {
+    {"Convert Sony", sLog3ToLinear, &kSGamut3Cine},
+    {"Convert Canon", canonLogToLinear, &kCinemaGamut},
+    {"Convert Fujifilm", fLogToLinear, &kRec2020},
+    {"Convert RED", log3G10ToLinear, &kREDWideGamut},
+};
+
+}  // namespace
+
+bool AnalyticLogConversion(const char* name, LUTStructure& out) {
+    if (!name) return false;
+    for (const Conversion& conv : kConversions) {
+        if (std::strcmp(conv.name, name) != 0) continue;
+
+        Mat3 camera, rec709, toRec709;
+        rgbToXYZ(*conv.gamut, camera);
+        rgbToXYZ(kRec709, rec709);
+        invert(rec709, toRec709);
+
+        LUTStructure s;
+        s.kind = LUTClass::kAnalytic;
+        s.unitRange = true;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                s.matrix[r][c] = static_cast<float>(toRec709[r][0] * camera[0][c] + toRec709[r][1] * camera[1][c] +
+                                                    toRec709[r][2] * camera[2][c]);
+            }
+            s.offset[r] = 0.0f;
+        }
+        s.tableSize = kTableSize;
+        fillSlopeTable(conv.toLinear, s.decode);
+        fillSlopeTable(rec709Encode, s.encode);
+        out = std::move(s);
+        return true;
+    }
+    return false;
+}
+
+}  // namespace vtc
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "VTC_LUTStructure.h"
+
+namespace vtc {
+
+// Closed-form versions of the built-in "Convert ..." LUTs: the camera's log
+// curve decoded to scene linear, its gamut converted to Rec.709 primaries
+// (all D65, so no adaptation), clipped and encoded with the Rec.709 OETF.
+//
+//   Convert Sony      S-Log3 / S-Gamut3.Cine
+//   Convert Canon     Canon Log / Cinema Gamut
+//   Convert Fujifilm  F-Log / F-Gamut (Rec.2020 primaries)
+//   Convert RED       Log3G10 / REDWideGamutRGB
+//
+// Fills `out` with a kAnalytic structure for the LUT called `name`; false
+// for any other name. The library only uses it where it reproduces the
+// shipped lattice (see LUTLibrary::kAnalyticTolerance).
+bool AnalyticLogConversion(const char* name, LUTStructure& out);
+
+}  // namespace vtc
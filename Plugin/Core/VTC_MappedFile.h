@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace vtc {
+
+// Read-only memory map of a whole file. Pages are faulted in by the OS on
+// first touch, so mapping a large file costs nothing until it is read.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false (and stays empty) if the file is missing or empty.
+    bool Open(const std::string& path);
+    void Close();
+
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool valid() const { return data_ != nullptr; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// A file's state as stat reports it. The mtime is kept to the nanosecond and
+// the inode is part of it, so a rewrite within the same second or another
+// file renamed over the path still changes the stamp.
+struct FileStamp {
+    std::int64_t size = 0;
+    std::int64_t mtimeNs = 0;  // since the epoch
+    std::uint64_t inode = 0;
+
+    bool operator==(const FileStamp& o) const { return size == o.size && mtimeNs == o.mtimeNs && inode == o.inode; }
+    bool operator!=(const FileStamp& o) const { return !(*this == o); }
+};
+
+// false, leaving `stamp` untouched, if `path` cannot be stat'ed.
+bool StatFile(const std::string& path, FileStamp& stamp);
+
+// Creates a new file with a unique name beside `path` and opens it for
+// writing, for writers that rename it over `path` once complete: concurrent
+// writers of the same path each get their own. nullptr on failure; `tmp`
+// receives the name either way.
+std::FILE* CreateTempFile(const std::string& path, std::string& tmp);
+
+}  // namespace vtc
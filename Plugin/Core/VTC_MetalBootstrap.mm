@@ -1,6 +1,7 @@
 #import <Metal/Metal.h>
 #import <Foundation/Foundation.h>
 #include "VTC_RenderBackend.h"
+#include "VTC_CacheBudget.h"
 #include <dispatch/dispatch.h>
 #include <unordered_map>
 #include <mutex>
@@ -58,6 +59,113 @@ static id<MTLBuffer> g_cachedDstBuf = nil;
 static NSUInteger    g_cachedDstCap = 0;
 // Serialize full dispatch to avoid MFR races on shared buffers/LUTs.
 static std::mutex    g_dispatchMutex;
+// Combined LUT buffer reused (single shared, grows as needed), guarded by mutex.
+static id<MTLBuffer> g_combinedLutBuf = nil;
+static NSUInteger    g_combinedLutCap = 0;
+static std::mutex    g_combinedBufMutex;
+
+// ── LUT cache (thread-safe with mutex; bytes charged to CacheBudget) ──
+enum class LUTPathMode : uint8_t { kBuffer = 0, kTexture = 1 };
+struct LUTCacheKey {
+    const float* ptr;
+    uint16_t     dim;
+    uint8_t      path;
+    uint8_t      pixelFmt; // only used for texture
+    bool operator==(const LUTCacheKey& o) const {
+        return ptr == o.ptr && dim == o.dim && path == o.path && pixelFmt == o.pixelFmt;
+    }
+};
+struct LUTKeyHash {
+    std::size_t operator()(const LUTCacheKey& k) const noexcept {
+        return (std::hash<const float*>()(k.ptr) ^ (std::hash<uint16_t>()(k.dim) << 1)) ^
+               (std::hash<uint8_t>()(k.path) << 2) ^ (std::hash<uint8_t>()(k.pixelFmt) << 3);
+    }
+};
+template <typename Obj>
+struct CachedLUT {
+    Obj        obj = nil;   // cache owns one retain
+    NSUInteger bytes = 0;
+    uint64_t   lastUse = 0;
+};
+
+static std::unordered_map<LUTCacheKey, CachedLUT<id<MTLTexture>>, LUTKeyHash> g_texLUTCache;
+static std::unordered_map<LUTCacheKey, CachedLUT<id<MTLBuffer>>,  LUTKeyHash> g_bufLUTCache;
+static std::mutex g_lutCacheMutex;
+
+// LUT textures/buffers are evicted LRU against the shared budget. Staging
+// buffers are per-frame working memory, so they are not charged, but a
+// purge drops them too. A dispatch in flight holds its own retains.
+class MetalCaches final : public BudgetedCache {
+public:
+    bool OldestUse(uint64_t& tick) override {
+        std::lock_guard<std::mutex> lock(g_lutCacheMutex);
+        bool found = false;
+        for (const auto& kv : g_texLUTCache) {
+            if (!found || kv.second.lastUse < tick) { tick = kv.second.lastUse; found = true; }
+        }
+        for (const auto& kv : g_bufLUTCache) {
+            if (!found || kv.second.lastUse < tick) { tick = kv.second.lastUse; found = true; }
+        }
+        return found;
+    }
+
+    std::size_t EvictOldest() override {
+        std::lock_guard<std::mutex> lock(g_lutCacheMutex);
+        auto tex = oldest(g_texLUTCache);
+        auto buf = oldest(g_bufLUTCache);
+        if (tex != g_texLUTCache.end() &&
+            (buf == g_bufLUTCache.end() || tex->second.lastUse <= buf->second.lastUse)) {
+            return erase(g_texLUTCache, tex);
+        }
+        return buf != g_bufLUTCache.end() ? erase(g_bufLUTCache, buf) : 0;
+    }
+
+    void Purge() override {
+        std::lock_guard<std::mutex> dispatchLock(g_dispatchMutex);
+        {
+            std::lock_guard<std::mutex> lock(g_lutCacheMutex);
+            while (!g_texLUTCache.empty()) erase(g_texLUTCache, g_texLUTCache.begin());
+            while (!g_bufLUTCache.empty()) erase(g_bufLUTCache, g_bufLUTCache.begin());
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_ioBufMutex);
+            if (g_cachedSrcBuf) { [g_cachedSrcBuf release]; g_cachedSrcBuf = nil; }
+            if (g_cachedDstBuf) { [g_cachedDstBuf release]; g_cachedDstBuf = nil; }
+            g_cachedSrcCap = g_cachedDstCap = 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_combinedBufMutex);
+            if (g_combinedLutBuf) { [g_combinedLutBuf release]; g_combinedLutBuf = nil; }
+            g_combinedLutCap = 0;
+        }
+        MLOG("caches purged");
+    }
+
+private:
+    template <typename Map>
+    static typename Map::iterator oldest(Map& map) {
+        auto victim = map.end();
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            if (victim == map.end() || it->second.lastUse < victim->second.lastUse) victim = it;
+        }
+        return victim;
+    }
+
+    template <typename Map>
+    static std::size_t erase(Map& map, typename Map::iterator it) {
+        const std::size_t bytes = it->second.bytes;
+        [it->second.obj release];
+        map.erase(it);
+        CacheBudget::Shared().Release(bytes);
+        return bytes;
+    }
+};
+
+void registerCachesWithBudget() {
+    static MetalCaches caches;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{ CacheBudget::Shared().Register(&caches); });
+}
 // ── Debug: GPU path selection override ───────────────────────────────
 // Controls which GPU LUT path is attempted when Metal is enabled.
 // Auto (default): try texture3d first, fall back to buffer, then CPU.
@@ -682,10 +790,9 @@ bool IsAvailable() {
     return g_available;
 }
 
-bool TryDispatch(const GPUDispatchDesc& desc,
-                 const void* srcData, void* dstData,
-                 int srcRowBytes, int dstRowBytes) {
-    std::lock_guard<std::mutex> dispatchLock(g_dispatchMutex);
+static bool TryDispatchLocked(const GPUDispatchDesc& desc,
+                              const void* srcData, void* dstData,
+                              int srcRowBytes, int dstRowBytes) {
 
     if (!g_available) {
         MLOG("dispatch skip: context unavailable");
@@ -763,28 +870,7 @@ bool TryDispatch(const GPUDispatchDesc& desc,
          (unsigned long long)tid, w, h, desc.bytesPerPixel, srcRowBytes, dstRowBytes);
 #endif
 
-    // ── LUT cache (process lifetime; thread-safe with mutex) ──
-    enum class LUTPathMode : uint8_t { kBuffer = 0, kTexture = 1 };
-    struct LUTCacheKey {
-        const float* ptr;
-        uint16_t     dim;
-        uint8_t      path;
-        uint8_t      pixelFmt; // only used for texture
-        bool operator==(const LUTCacheKey& o) const {
-            return ptr == o.ptr && dim == o.dim && path == o.path && pixelFmt == o.pixelFmt;
-        }
-    };
-    struct LUTKeyHash {
-        std::size_t operator()(const LUTCacheKey& k) const noexcept {
-            return (std::hash<const float*>()(k.ptr) ^ (std::hash<uint16_t>()(k.dim) << 1)) ^
-                   (std::hash<uint8_t>()(k.path) << 2) ^ (std::hash<uint8_t>()(k.pixelFmt) << 3);
-        }
-    };
-
-    static std::unordered_map<LUTCacheKey, id<MTLTexture>, LUTKeyHash> g_texLUTCache;
-    static std::unordered_map<LUTCacheKey, id<MTLBuffer>,  LUTKeyHash> g_bufLUTCache;
-    static std::mutex g_lutCacheMutex;
-
+    // ── LUT cache (budgeted; see MetalCaches) ──
     auto getOrCreateLUTTexture = [&](const GPUDispatchDesc::Layer& L) -> id<MTLTexture> {
         LUTCacheKey key{L.lutData, (uint16_t)L.dimension, (uint8_t)LUTPathMode::kTexture,
                         (uint8_t)MTLPixelFormatRGBA32Float};
@@ -792,7 +878,8 @@ bool TryDispatch(const GPUDispatchDesc& desc,
             std::lock_guard<std::mutex> lock(g_lutCacheMutex);
             auto it = g_texLUTCache.find(key);
             if (it != g_texLUTCache.end()) {
-                return [it->second retain]; // caller releases; cache keeps its own retain
+                it->second.lastUse = CacheBudget::Shared().Tick();
+                return [it->second.obj retain]; // caller releases; cache keeps its own retain
             }
         }
 
@@ -828,7 +915,11 @@ bool TryDispatch(const GPUDispatchDesc& desc,
 
         {
             std::lock_guard<std::mutex> lock(g_lutCacheMutex);
-            g_texLUTCache[key] = [tex retain]; // cache owns one retain
+            const NSUInteger texBytes = n * 4 * sizeof(float);
+            auto& slot = g_texLUTCache[key];
+            if (slot.obj) { [slot.obj release]; CacheBudget::Shared().Release(slot.bytes); }
+            slot = {[tex retain], texBytes, CacheBudget::Shared().Tick()}; // cache owns one retain
+            CacheBudget::Shared().Charge(texBytes);
         }
         return tex; // caller owns this retain and must release
     };
@@ -839,7 +930,8 @@ bool TryDispatch(const GPUDispatchDesc& desc,
             std::lock_guard<std::mutex> lock(g_lutCacheMutex);
             auto it = g_bufLUTCache.find(key);
             if (it != g_bufLUTCache.end()) {
-                return [it->second retain]; // caller releases; cache retains
+                it->second.lastUse = CacheBudget::Shared().Tick();
+                return [it->second.obj retain]; // caller releases; cache retains
             }
         }
 
@@ -851,16 +943,15 @@ bool TryDispatch(const GPUDispatchDesc& desc,
 
         {
             std::lock_guard<std::mutex> lock(g_lutCacheMutex);
-            g_bufLUTCache[key] = [buf retain]; // cache owns
+            const NSUInteger bufBytes = layerFloats * sizeof(float);
+            auto& slot = g_bufLUTCache[key];
+            if (slot.obj) { [slot.obj release]; CacheBudget::Shared().Release(slot.bytes); }
+            slot = {[buf retain], bufBytes, CacheBudget::Shared().Tick()}; // cache owns
+            CacheBudget::Shared().Charge(bufBytes);
         }
         return buf; // caller owns this retain and must release
     };
 
-    // Combined LUT buffer reused (single shared, grows as needed), guarded by mutex.
-    static id<MTLBuffer> g_combinedLutBuf = nil;
-    static NSUInteger    g_combinedLutCap = 0;
-    static std::mutex    g_combinedBufMutex;
-
     auto AcquireSharedBuffer = [&](id<MTLBuffer>& cached,
                                    NSUInteger& cap,
                                    NSUInteger neededBytes,
@@ -1064,6 +1155,21 @@ bool TryDispatch(const GPUDispatchDesc& desc,
     }
 }
 
+bool TryDispatch(const GPUDispatchDesc& desc,
+                 const void* srcData, void* dstData,
+                 int srcRowBytes, int dstRowBytes) {
+    registerCachesWithBudget();
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> dispatchLock(g_dispatchMutex);
+        ok = TryDispatchLocked(desc, srcData, dstData, srcRowBytes, dstRowBytes);
+    }
+    // Outside the dispatch lock: PurgeAll holds the budget lock and then
+    // takes the dispatch lock.
+    CacheBudget::Shared().Enforce();
+    return ok;
+}
+
 #if VTC_METAL_LOG
 #undef MLOG
 #define MLOG(fmt, ...) std::fprintf(stderr, "[VTC Metal] " fmt "\n", ##__VA_ARGS__)
@@ -0,0 +1,55 @@
+#include "VTC_Prefetch.h"
+
+#include "VTC_BackgroundQueue.h"
+#include "VTC_StackBake.h"
+
+namespace vtc {
+
+namespace {
+
+LayerParams& layerAt(ParamsSnapshot& params, LayerSlot slot) {
+    switch (slot) {
+        case LayerSlot::kLogConvert: return params.logConvert;
+        case LayerSlot::kCreative:   return params.creative;
+        case LayerSlot::kSecondary:  return params.secondary;
+        case LayerSlot::kAccent:     return params.accent;
+    }
+    return params.creative;
+}
+
+// Same wraparound as the Next/Prev buttons: None (-1) sits between the last
+// and the first look.
+int stepLook(int lutIndex, int lutCount, int step) {
+    const int span = lutCount + 1;
+    const int pos = (lutIndex < 0 ? 0 : lutIndex + 1) + step;
+    return ((pos % span) + span) % span - 1;
+}
+
+}  // namespace
+
+void PrefetchNeighbourLooks(const ParamsSnapshot& params, LayerSlot slot, int lookCount, std::uint64_t key) {
+    BackgroundQueue& queue = BackgroundQueue::Shared();
+    queue.Cancel(TaskLane::kPrefetch, key);
+
+    ParamsSnapshot neighbour = params;
+    LayerParams& layer = layerAt(neighbour, slot);
+    if (!layer.enabled) {
+        return;
+    }
+
+    const int current = layer.lutIndex;
+    for (int step : {1, -1}) {
+        layer.lutIndex = stepLook(current, lookCount, step);
+        // Resolving may load the neighbour's LUT, so it runs on the queue
+        // too, not on the caller's (UI) thread.
+        queue.Submit(TaskLane::kPrefetch, [neighbour] {
+            const ResolvedStack stack = ResolveStack(neighbour);
+            // Untrimmed single-layer stacks render straight from the embedded LUT.
+            if (stack.NeedsComposite()) {
+                (void)AcquireComposite(stack, 0, BakeOrigin::kSpeculative);
+            }
+        }, key);
+    }
+}
+
+}  // namespace vtc
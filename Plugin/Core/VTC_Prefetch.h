@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../Shared/VTC_Params.h"
+
+namespace vtc {
+
+// Speculatively bakes the stacks reached by Next and Prev on `slot`, so
+// browsing looks one step at a time finds its composite already cached.
+// `lookCount` is the looks the slot's popup offers, as the host registered
+// it, which a hot reload may have left behind the library's count.
+// Runs on the background queue behind any refine work; a newer call with the
+// same `key` (the effect instance's) drops prefetches that have not started. Speculative composites never evict ones
+// a render has used (see BakeOrigin), and GetPrefetchStats() reports how
+// many were picked up.
+void PrefetchNeighbourLooks(const ParamsSnapshot& params, LayerSlot slot, int lookCount,
+                            std::uint64_t key = 0);
+
+}  // namespace vtc
@@ -0,0 +1,119 @@
+#include "VTC_ProgressiveBake.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include "VTC_BackgroundQueue.h"
+
+namespace vtc {
+
+namespace {
+
+// Intermediate rungs between the draft and the full composite.
+constexpr int kRefineRungs[] = {33, 65};
+
+std::atomic<CompositeRefinedListener> g_refinedListener{nullptr};
+
+// Background queue key of `stack`'s refines: FNV-1a over what its composite
+// is keyed by. A collision only lets one stack's refine replace the other's.
+std::uint64_t refineKey(const ResolvedStack& stack) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    auto add = [&h](const void* data, std::size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            h = (h ^ p[i]) * 0x100000001b3ull;
+        }
+    };
+    for (const ResolvedStack* s = &stack; s; s = s->to.get()) {
+        add(&s->count, sizeof(s->count));
+        for (int i = 0; i < s->count; ++i) {
+            add(&s->layers[i].lut->data, sizeof(s->layers[i].lut->data));
+            add(&s->layers[i].intensity, sizeof(s->layers[i].intensity));
+        }
+        for (const StackTrim* trim : {&s->input, &s->output}) {
+            add(&trim->active, sizeof(trim->active));
+            add(trim->matrix, sizeof(trim->matrix));
+            add(trim->offset, sizeof(trim->offset));
+        }
+        add(&s->mix, sizeof(s->mix));
+    }
+    return h ? h : 1;  // 0 is the queue's "no key"
+}
+
+}  // namespace
+
+bool IsFullCompositeReady(const ResolvedStack& stack) {
+    return !stack.NeedsComposite() || HasComposite(stack);
+}
+
+void ScheduleCompositeRefine(const ResolvedStack& stack) {
+    if (!stack.NeedsComposite()) {
+        return;
+    }
+    // Restart this stack's ladder; every other stack keeps its place.
+    BackgroundQueue& queue = BackgroundQueue::Shared();
+    const std::uint64_t key = refineKey(stack);
+    queue.Cancel(TaskLane::kRefine, key);
+
+    const int full = FullCompositeDimension(stack);
+    for (int dim : kRefineRungs) {
+        if (dim > kDraftCompositeDim && dim < full) {
+            queue.Submit(TaskLane::kRefine, [stack, dim] { (void)AcquireComposite(stack, dim); }, key);
+        }
+    }
+    queue.Submit(TaskLane::kRefine, [stack] {
+        // Only a composite that was missing can have been drawn as a draft.
+        const bool ready = HasComposite(stack);
+        if (!AcquireComposite(stack) || ready) {
+            return;
+        }
+        if (CompositeRefinedListener listener = g_refinedListener.load()) {
+            listener(stack);
+        }
+    }, key);
+}
+
+void SetCompositeRefinedListener(CompositeRefinedListener listener) {
+    g_refinedListener.store(listener);
+}
+
+std::shared_ptr<const CompositeLUT> AcquireRenderComposite(const ResolvedStack& stack,
+                                                           CompositeQuality quality,
+                                                           bool* isDraft) {
+    if (isDraft) {
+        *isDraft = false;
+    }
+    if (!stack.NeedsComposite()) {
+        return nullptr;
+    }
+
+    const int full = FullCompositeDimension(stack);
+    if (quality == CompositeQuality::kFinal || full <= kDraftCompositeDim) {
+        return AcquireComposite(stack);
+    }
+
+    if (auto ready = FindComposite(stack)) {
+        return ready;
+    }
+
+    // Finest intermediate rung that is already baked, else a fresh draft.
+    std::shared_ptr<const CompositeLUT> draft;
+    for (int i = static_cast<int>(sizeof(kRefineRungs) / sizeof(kRefineRungs[0])) - 1; i >= 0 && !draft; --i) {
+        if (kRefineRungs[i] < full) {
+            draft = FindComposite(stack, kRefineRungs[i]);
+        }
+    }
+    if (!draft) {
+        draft = AcquireComposite(stack, kDraftCompositeDim);
+    }
+    // Also when a rung is ready: a purge may have cancelled the full bake.
+    if (!BackgroundQueue::Shared().Pending(TaskLane::kRefine, refineKey(stack))) {
+        ScheduleCompositeRefine(stack);
+    }
+    if (isDraft) {
+        *isDraft = true;
+    }
+    return draft;
+}
+
+}  // namespace vtc
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+
+#include "VTC_StackBake.h"
+
+namespace vtc {
+
+// Lattice baked synchronously for an interactive frame whose full composite
+// is not ready yet.
+constexpr int kDraftCompositeDim = 17;
+
+enum class CompositeQuality {
+    kFinal,        // always render with the full composite (exports)
+    kProgressive,  // best ready composite; draft + background refine if none
+};
+
+// Composite to render `stack` with. `isDraft` is set when the result is
+// coarser than the full composite; the refine is then queued unless it
+// already is, so a stack whose full bake was cancelled still gets there.
+std::shared_ptr<const CompositeLUT> AcquireRenderComposite(const ResolvedStack& stack,
+                                                           CompositeQuality quality,
+                                                           bool* isDraft = nullptr);
+
+// True when a kProgressive render of `stack` would not be a draft.
+bool IsFullCompositeReady(const ResolvedStack& stack);
+
+// Queues the draft-to-full refinement ladder on the background queue, e.g.
+// right after the user picks a new look and before the host asks for a frame.
+// Replaces a refine of the same stack that has not started; refines of other
+// stacks (other instances, other comps) are left alone.
+void ScheduleCompositeRefine(const ResolvedStack& stack);
+
+// Called on the background thread when a refine has baked the full composite
+// of `stack`, which renders until then drew from a draft. Hosts use it to
+// redraw viewers that would otherwise keep showing the draft; it must not
+// block. nullptr removes it.
+using CompositeRefinedListener = void (*)(const ResolvedStack& stack);
+void SetCompositeRefinedListener(CompositeRefinedListener listener);
+
+}  // namespace vtc
@@ -0,0 +1,64 @@
+#include "VTC_SequencePrebake.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "VTC_BackgroundQueue.h"
+#include "VTC_StackBake.h"
+
+namespace vtc {
+
+std::vector<double> PrebakeSampleTimes(double first, double last, double step,
+                                       std::vector<double> keyTimes, bool interpolated) {
+    std::vector<double> times;
+    if (last < first) {
+        return times;
+    }
+    if (interpolated && step > 0.0) {
+        const double frames = std::floor((last - first) / step) + 1.0;
+        const int n = static_cast<int>(std::min(frames, static_cast<double>(kMaxPrebakeFrames)));
+        times.reserve(static_cast<std::size_t>(n));
+        for (int i = 0; i < n; ++i) {
+            times.push_back(first + i * step);
+        }
+        return times;
+    }
+
+    times.push_back(first);
+    std::sort(keyTimes.begin(), keyTimes.end());
+    for (double t : keyTimes) {
+        if (t > times.back() && t <= last && static_cast<int>(times.size()) < kMaxPrebakeFrames) {
+            times.push_back(t);
+        }
+    }
+    return times;
+}
+
+void PrebakeSequence(const std::vector<ParamsSnapshot>& frames, std::uint64_t key) {
+    std::vector<ResolvedStack> stacks;
+    for (const ParamsSnapshot& snap : frames) {
+        const ResolvedStack stack = ResolveStack(snap);
+        // Single-layer stacks render straight from the embedded LUT.
+        if (!stack.NeedsComposite() || std::find(stacks.begin(), stacks.end(), stack) != stacks.end()) {
+            continue;
+        }
+        stacks.push_back(stack);
+        if (static_cast<int>(stacks.size()) >= kMaxPrebakeStacks) {
+            break;
+        }
+    }
+
+    BackgroundQueue& queue = BackgroundQueue::Shared();
+    queue.Cancel(TaskLane::kPrebake, key);
+    // An empty task still starts the worker thread.
+    queue.Submit(TaskLane::kPrebake, [] {}, key);
+    for (const ResolvedStack& stack : stacks) {
+        queue.Submit(TaskLane::kPrebake, [stack] { (void)AcquireComposite(stack); }, key);
+    }
+}
+
+void CancelSequencePrebake(std::uint64_t key) {
+    BackgroundQueue::Shared().Cancel(TaskLane::kPrebake, key);
+}
+
+}  // namespace vtc
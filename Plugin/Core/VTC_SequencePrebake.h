@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../Shared/VTC_Params.h"
+
+namespace vtc {
+
+// Upper bounds for one sequence, so a long animated export cannot flood the
+// queue or the cache budget before its first frame.
+constexpr int kMaxPrebakeFrames = 1024;
+constexpr int kMaxPrebakeStacks = 32;
+
+// Times in [first, last] whose parameters can differ: `first`, then every
+// key in range. Enable and Look are stepped, so keys are enough for them; an
+// animated intensity interpolates between keys, so `interpolated` samples
+// every `step` instead.
+std::vector<double> PrebakeSampleTimes(double first, double last, double step,
+                                       std::vector<double> keyTimes, bool interpolated);
+
+// Queues a full bake of every distinct multi-layer stack in `frames`, in
+// order, on the background queue. Replaces the previous prebake submitted
+// with the same `key` (e.g. the effect instance's), leaving other instances'
+// alone. Also starts the worker so the first frame does not pay for it.
+void PrebakeSequence(const std::vector<ParamsSnapshot>& frames, std::uint64_t key = 0);
+
+// The export ended or was cancelled; drops bakes for `key` that have not
+// started.
+void CancelSequencePrebake(std::uint64_t key = 0);
+
+}  // namespace vtc
@@ -0,0 +1,1006 @@
+#include "VTC_StackBake.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+
+#include "VTC_AdaptiveLUT.h"
+#include "VTC_BackgroundQueue.h"
+#include "VTC_CacheBudget.h"
+#include "VTC_Diag.h"
+#include "VTC_LUTKernel.h"
+#include "VTC_LUTLibrary.h"
+#include "VTC_LUTReduce.h"
+#include "VTC_LUTStructure.h"
+
+namespace vtc {
+
+namespace {
+
+using Lattice = std::vector<float>;
+// Owners (StackLayer::owner) of the LUTs behind an entry's key. While the
+// entry is cached no other LUT can be loaded at those addresses.
+using Owners = std::vector<std::shared_ptr<const void>>;
+
+// Identifies the delta of layer `depth`: its own LUT plus everything that
+// shapes its input (input trim, upstream LUTs and their intensities).
+struct DeltaKey {
+    const float* luts[ResolvedStack::kMaxLayers] = {};
+    float upstream[ResolvedStack::kMaxLayers] = {};
+    StackTrim input;
+    int depth = 0;
+    int dimension = 0;
+
+    bool operator==(const DeltaKey& o) const {
+        if (depth != o.depth || dimension != o.dimension || !(input == o.input)) return false;
+        for (int i = 0; i <= depth; ++i) {
+            if (luts[i] != o.luts[i]) return false;
+        }
+        for (int i = 0; i < depth; ++i) {
+            if (upstream[i] != o.upstream[i]) return false;
+        }
+        return true;
+    }
+};
+
+struct DeltaEntry {
+    DeltaKey key;
+    Owners owners;
+    std::shared_ptr<const Lattice> base;   // stack output feeding this layer
+    std::shared_ptr<const Lattice> delta;  // L(base) - base
+    std::size_t bytes = 0;
+    std::uint64_t lastUse = 0;
+    bool speculative = false;  // baked ahead of demand, not used yet
+};
+
+struct CompositeKey {
+    const float* luts[ResolvedStack::kMaxLayers] = {};
+    float intensity[ResolvedStack::kMaxLayers] = {};
+    StackTrim input;
+    StackTrim output;
+    int count = 0;
+    int dimension = 0;
+    // A transition's far end and mix; toCount is -1 outside one. Both ends
+    // resolve from the same trim params and log layer, so share the trims.
+    const float* toLuts[ResolvedStack::kMaxLayers] = {};
+    float toIntensity[ResolvedStack::kMaxLayers] = {};
+    int toCount = -1;
+    float mix = 0.0f;
+
+    bool operator==(const CompositeKey& o) const {
+        if (count != o.count || dimension != o.dimension || !(input == o.input) || !(output == o.output) ||
+            toCount != o.toCount || mix != o.mix) {
+            return false;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (luts[i] != o.luts[i] || intensity[i] != o.intensity[i]) return false;
+        }
+        for (int i = 0; i < toCount; ++i) {
+            if (toLuts[i] != o.toLuts[i] || toIntensity[i] != o.toIntensity[i]) return false;
+        }
+        return true;
+    }
+};
+
+struct CompositeEntry {
+    CompositeKey key;
+    Owners owners;
+    std::shared_ptr<const CompositeLUT> lut;
+    std::size_t bytes = 0;
+    std::uint64_t lastUse = 0;
+    bool speculative = false;
+    bool keepDense = false;  // a GPU path uploads it: never swapped for the adaptive form
+};
+
+// Keyed by the dense lattice. Null while the build is queued, or when the
+// LUT has no worthwhile adaptive form.
+struct AdaptiveEntry {
+    const float* key = nullptr;
+    std::shared_ptr<const void> owner;
+    std::shared_ptr<const AdaptiveLUT> lut;
+    std::size_t bytes = 0;
+    std::uint64_t lastUse = 0;
+    bool speculative = false;
+};
+
+// Keyed by the full lattice. Null while the reduction is queued, or when no
+// smaller size is within the bound.
+struct ReducedEntry {
+    const float* key = nullptr;
+    std::shared_ptr<const void> owner;
+    std::shared_ptr<const LUTReduction> lut;
+    std::size_t bytes = 0;
+    std::uint64_t lastUse = 0;
+    bool speculative = false;
+};
+
+std::mutex g_cacheMutex;
+std::vector<DeltaEntry> g_deltas;
+std::vector<CompositeEntry> g_composites;
+std::vector<AdaptiveEntry> g_adaptives;
+std::vector<ReducedEntry> g_reduced;
+PrefetchStats g_prefetchStats;
+
+inline std::uint64_t evictionRank(bool speculative, std::uint64_t lastUse) {
+    // Unused speculative entries go before anything a render has touched.
+    return speculative ? 0 : lastUse;
+}
+
+template <typename Entry>
+typename std::vector<Entry>::iterator oldestEntry(std::vector<Entry>& entries, bool speculativeOnly) {
+    auto victim = entries.end();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (speculativeOnly && !it->speculative) continue;
+        if (victim == entries.end() ||
+            evictionRank(it->speculative, it->lastUse) < evictionRank(victim->speculative, victim->lastUse)) {
+            victim = it;
+        }
+    }
+    return victim;
+}
+
+template <typename Entry>
+std::size_t eraseEntry(std::vector<Entry>& entries, typename std::vector<Entry>::iterator it) {
+    const std::size_t bytes = it->bytes;
+    entries.erase(it);
+    CacheBudget::Shared().Release(bytes);
+    return bytes;
+}
+
+// Caller holds g_cacheMutex and runs CacheBudget::Enforce() after unlocking.
+// A speculative insert only takes free budget or budget held by other
+// speculative entries: speculation never pushes out data a render has asked
+// for. Returns false if the entry was dropped.
+template <typename Entry>
+bool insertLRU(std::vector<Entry>& entries, Entry entry, BakeOrigin origin) {
+    CacheBudget& budget = CacheBudget::Shared();
+    entry.lastUse = budget.Tick();
+    entry.speculative = origin == BakeOrigin::kSpeculative;
+    if (entry.speculative) {
+        while (!budget.HasRoom(entry.bytes)) {
+            auto victim = oldestEntry(entries, true);
+            if (victim == entries.end()) return false;
+            eraseEntry(entries, victim);
+        }
+    }
+    budget.Charge(entry.bytes);
+    entries.push_back(std::move(entry));
+    return true;
+}
+
+template <typename Entry, typename Key>
+Entry* findLRU(std::vector<Entry>& entries, const Key& key, BakeOrigin origin) {
+    for (Entry& e : entries) {
+        if (e.key == key) {
+            if (origin == BakeOrigin::kDemand) {
+                e.lastUse = CacheBudget::Shared().Tick();
+                e.speculative = false;
+            }
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+// Caller holds g_cacheMutex. A demand hit on a speculative entry is a
+// prefetch hit.
+CompositeEntry* findComposite(const CompositeKey& key, BakeOrigin origin) {
+    CompositeEntry* hit = findLRU(g_composites, key, BakeOrigin::kSpeculative);
+    if (hit && origin == BakeOrigin::kDemand) {
+        if (hit->speculative) {
+            ++g_prefetchStats.hits;
+        }
+        findLRU(g_composites, key, BakeOrigin::kDemand);
+    }
+    return hit;
+}
+
+// Exposes the caches to the process-wide budget.
+class StackBakeCache final : public BudgetedCache {
+public:
+    bool OldestUse(std::uint64_t& tick) override {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        bool found = false;
+        auto consider = [&](bool speculative, std::uint64_t lastUse) {
+            const std::uint64_t rank = evictionRank(speculative, lastUse);
+            if (!found || rank < tick) {
+                tick = rank;
+                found = true;
+            }
+        };
+        for (const DeltaEntry& e : g_deltas) consider(e.speculative, e.lastUse);
+        for (const CompositeEntry& e : g_composites) consider(e.speculative, e.lastUse);
+        for (const AdaptiveEntry& e : g_adaptives) consider(e.speculative, e.lastUse);
+        for (const ReducedEntry& e : g_reduced) consider(e.speculative, e.lastUse);
+        return found;
+    }
+
+    std::size_t EvictOldest() override {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        auto composite = oldestEntry(g_composites, false);
+        auto delta = oldestEntry(g_deltas, false);
+        auto adaptive = oldestEntry(g_adaptives, false);
+        auto reduced = oldestEntry(g_reduced, false);
+        // Oldest across the caches; ties go to the one considered first.
+        int victim = -1;
+        std::uint64_t oldest = 0;
+        auto consider = [&](int which, const auto& entries, const auto& it) {
+            if (it == entries.end()) return;
+            const std::uint64_t rank = evictionRank(it->speculative, it->lastUse);
+            if (victim < 0 || rank < oldest) {
+                victim = which;
+                oldest = rank;
+            }
+        };
+        consider(0, g_composites, composite);
+        consider(1, g_deltas, delta);
+        consider(2, g_adaptives, adaptive);
+        consider(3, g_reduced, reduced);
+        switch (victim) {
+            case 0: return eraseEntry(g_composites, composite);
+            case 1: return eraseEntry(g_deltas, delta);
+            case 2: return eraseEntry(g_adaptives, adaptive);
+            case 3: return eraseEntry(g_reduced, reduced);
+            default: return 0;
+        }
+    }
+
+    // Renders keep their shared_ptr; memory goes when the last one finishes.
+    void Purge() override {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        std::size_t bytes = 0;
+        for (const DeltaEntry& e : g_deltas) bytes += e.bytes;
+        for (const CompositeEntry& e : g_composites) bytes += e.bytes;
+        for (const AdaptiveEntry& e : g_adaptives) bytes += e.bytes;
+        for (const ReducedEntry& e : g_reduced) bytes += e.bytes;
+        g_deltas.clear();
+        g_composites.clear();
+        g_adaptives.clear();
+        g_reduced.clear();
+        CacheBudget::Shared().Release(bytes);
+    }
+};
+
+void registerWithBudget() {
+    static StackBakeCache cache;
+    static std::once_flag once;
+    std::call_once(once, [] { CacheBudget::Shared().Register(&cache); });
+}
+
+// Lattices up to this size sample faster dense than adaptive.
+constexpr int kMaxDenseDim = 65;
+
+float adaptiveTolerance() {
+    static const float tolerance = [] {
+        const char* v = std::getenv("VTC_ADAPTIVE_LUT_TOLERANCE");
+        if (!v || !*v) return 1.0f / 2048.0f;
+        char* end = nullptr;
+        const float t = std::strtof(v, &end);
+        return end == v || t < 0.0f ? 1.0f / 2048.0f : t;
+    }();
+    return tolerance;
+}
+
+// Only worth keeping when it cuts the lattice to a quarter or less.
+std::shared_ptr<const AdaptiveLUT> makeAdaptive(const LUT3D& lut) {
+    if (lut.dimension <= kMaxDenseDim || adaptiveTolerance() <= 0.0f) {
+        return nullptr;
+    }
+    auto adaptive = AdaptiveLUT::Build(lut, adaptiveTolerance());
+    const std::size_t denseBytes = static_cast<std::size_t>(lut.dimension) * lut.dimension * lut.dimension * 3 *
+                                   sizeof(float);
+    if (!adaptive || adaptive->Bytes() * 4 > denseBytes) {
+        return nullptr;
+    }
+    return adaptive;
+}
+
+float interactiveDeltaE() {
+    static const float bound = [] {
+        const char* v = std::getenv("VTC_INTERACTIVE_DELTA_E");
+        if (!v || !*v) return kDefaultInteractiveDeltaE;
+        char* end = nullptr;
+        const float e = std::strtof(v, &end);
+        return end == v || e < 0.0f ? kDefaultInteractiveDeltaE : e;
+    }();
+    return bound;
+}
+
+inline float effectiveIntensity(float t) {
+    // Same snap as the per-pixel path: near-full intensity is treated as full.
+    return t >= 0.9999f ? 1.0f : t;
+}
+
+// Input value behind each lattice coordinate, per channel: the grid itself,
+// or its preimage under the first layer's shaper.
+std::vector<float> nodePositions(int dim, const LUT3D* first) {
+    std::vector<float> nodes(static_cast<std::size_t>(dim) * 3);
+    const float inv = 1.0f / static_cast<float>(dim - 1);
+    const bool shaped = first && first->shaper;
+    for (int c = 0; c < 3; ++c) {
+        for (int i = 0; i < dim; ++i) {
+            const float u = i * inv;
+            nodes[c * dim + i] = shaped ? InvertShaper(first->shaper + c * first->shaperSize, first->shaperSize, u)
+                                        : u;
+        }
+    }
+    return nodes;
+}
+
+void applyTrim(const StackTrim& trim, Lattice& lattice) {
+    const float (*m)[3] = trim.matrix;
+    const float* o = trim.offset;
+    for (std::size_t i = 0; i < lattice.size(); i += 3) {
+        const float r = lattice[i], g = lattice[i + 1], b = lattice[i + 2];
+        lattice[i] = m[0][0] * r + m[0][1] * g + m[0][2] * b + o[0];
+        lattice[i + 1] = m[1][0] * r + m[1][1] * g + m[1][2] * b + o[1];
+        lattice[i + 2] = m[2][0] * r + m[2][1] * g + m[2][2] * b + o[2];
+    }
+}
+
+// What the first layer samples at each node: the node's input value, through
+// the input trim.
+std::shared_ptr<const Lattice> makeBase(int dim, const LUT3D* first, const StackTrim& input) {
+    auto lattice = std::make_shared<Lattice>(static_cast<std::size_t>(dim) * dim * dim * 3);
+    const std::vector<float> nodes = nodePositions(dim, first);
+    const float* rs = nodes.data();
+    const float* gs = rs + dim;
+    const float* bs = gs + dim;
+    float* out = lattice->data();
+    for (int b = 0; b < dim; ++b) {
+        for (int g = 0; g < dim; ++g) {
+            for (int r = 0; r < dim; ++r) {
+                *out++ = rs[r];
+                *out++ = gs[g];
+                *out++ = bs[b];
+            }
+        }
+    }
+    if (input.active) {
+        applyTrim(input, *lattice);
+    }
+    return lattice;
+}
+
+template <typename SampleFn>
+std::shared_ptr<const Lattice> makeDeltaWith(const Lattice& base, SampleFn sample) {
+    auto delta = std::make_shared<Lattice>(base.size());
+    const float* in = base.data();
+    float* out = delta->data();
+    for (std::size_t i = 0; i < base.size(); i += 3) {
+        const RGB s = sample(in[i], in[i + 1], in[i + 2]);
+        out[i] = s.r - in[i];
+        out[i + 1] = s.g - in[i + 1];
+        out[i + 2] = s.b - in[i + 2];
+    }
+    return delta;
+}
+
+// The only step that samples a LUT: evaluates L at every point of `base`,
+// through its structural form when it has one.
+std::shared_ptr<const Lattice> makeDelta(const StackLayer& layer, const Lattice& base) {
+    const LUTStructure* s = layer.structure;
+    if (s && s->kind == LUTClass::kAffine) {
+        return makeDeltaWith(base, [s](float r, float g, float b) {
+            return ApplyStructure<LUTClass::kAffine>(*s, r, g, b);
+        });
+    }
+    if (s && s->kind == LUTClass::kSeparable) {
+        return makeDeltaWith(base, [s](float r, float g, float b) {
+            return ApplyStructure<LUTClass::kSeparable>(*s, r, g, b);
+        });
+    }
+    if (s && s->kind == LUTClass::kAnalytic) {
+        return makeDeltaWith(base, [s](float r, float g, float b) {
+            return ApplyStructure<LUTClass::kAnalytic>(*s, r, g, b);
+        });
+    }
+    const ResolvedLayer resolved = ResolveLayer(*layer.lut, 1.0f);
+    return makeDeltaWith(base, [&resolved](float r, float g, float b) { return sampleLUTFast(resolved, r, g, b); });
+}
+
+CompositeKey makeCompositeKey(const ResolvedStack& stack, int dim) {
+    CompositeKey key;
+    key.count = stack.count;
+    key.dimension = dim;
+    key.input = stack.input;
+    key.output = stack.output;
+    for (int i = 0; i < stack.count; ++i) {
+        key.luts[i] = stack.layers[i].lut->data;
+        key.intensity[i] = effectiveIntensity(stack.layers[i].intensity);
+    }
+    if (stack.to) {
+        key.toCount = stack.to->count;
+        key.mix = stack.mix;
+        for (int i = 0; i < stack.to->count; ++i) {
+            key.toLuts[i] = stack.to->layers[i].lut->data;
+            key.toIntensity[i] = effectiveIntensity(stack.to->layers[i].intensity);
+        }
+    }
+    return key;
+}
+
+// Owners of every user LUT in `stack`, both ends of a transition included.
+Owners ownersOf(const ResolvedStack& stack) {
+    Owners owners;
+    for (const ResolvedStack* s = &stack; s; s = s->to.get()) {
+        for (int i = 0; i < s->count; ++i) {
+            if (s->layers[i].owner) owners.push_back(s->layers[i].owner);
+        }
+    }
+    return owners;
+}
+
+// ── Trims ──
+
+constexpr float kLuma[3] = {0.2126f, 0.7152f, 0.0722f};
+// Code values per stop of the common camera log curves (S-Log3 0.077, LogC
+// 0.074, Log3G10 0.067).
+constexpr float kLogCodePerStop = 0.075f;
+constexpr float kDisplayGamma = 2.4f;
+// White balance at +-100: half a stop on each of the two channels it moves.
+constexpr float kWhiteBalanceStops = 0.5f;
+
+// (1 - s) * luma + s * c, after the diagonal `gain` and `offset`.
+StackTrim makeTrim(const float gain[3], const float offset[3], float saturation) {
+    StackTrim trim;
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            const float sat = (1.0f - saturation) * kLuma[col] + (row == col ? saturation : 0.0f);
+            trim.matrix[row][col] = sat * gain[col];
+            trim.offset[row] += sat * offset[col];
+        }
+    }
+    trim.active = true;
+    return trim;
+}
+
+StackTrim inputTrim(const TrimParams& t, bool logInput) {
+    const float temperature = std::min(std::max(t.temperature / 100.0f, -1.0f), 1.0f);
+    const float tint = std::min(std::max(t.tint / 100.0f, -1.0f), 1.0f);
+    const float saturation = std::max(t.saturation, 0.0f);
+    if (t.exposure == 0.0f && temperature == 0.0f && tint == 0.0f && saturation == 1.0f) {
+        return {};
+    }
+    // Linear-light stops per channel; white balance keeps grey's luminance.
+    float stops[3] = {kWhiteBalanceStops * temperature, -kWhiteBalanceStops * tint,
+                      -kWhiteBalanceStops * temperature};
+    const float grey = kLuma[0] * std::exp2(stops[0]) + kLuma[1] * std::exp2(stops[1]) +
+                       kLuma[2] * std::exp2(stops[2]);
+    float gain[3], offset[3];
+    for (int c = 0; c < 3; ++c) {
+        stops[c] += t.exposure - std::log2(grey);
+        gain[c] = logInput ? 1.0f : std::exp2(stops[c] / kDisplayGamma);
+        offset[c] = logInput ? stops[c] * kLogCodePerStop : 0.0f;
+    }
+    return makeTrim(gain, offset, saturation);
+}
+
+StackTrim outputTrim(const TrimParams& t) {
+    const float gain = std::max(t.outputGain, 0.0f);
+    const float saturation = std::max(t.outputSaturation, 0.0f);
+    if (gain == 1.0f && saturation == 1.0f) {
+        return {};
+    }
+    const float gains[3] = {gain, gain, gain};
+    const float offsets[3] = {};
+    return makeTrim(gains, offsets, saturation);
+}
+
+std::shared_ptr<Lattice> reweight(const Lattice& base, const Lattice& delta, float t) {
+    auto out = std::make_shared<Lattice>(base.size());
+    float* dst = out->data();
+    for (std::size_t i = 0; i < base.size(); ++i) {
+        dst[i] = base[i] + t * delta[i];
+    }
+    return out;
+}
+
+ResolvedStack resolveLayers(const ParamsSnapshot& params) {
+    ResolvedStack stack;
+    LUTLibrary& library = LUTLibrary::Shared();
+    auto tryAdd = [&stack, &library](const LayerParams& lp, LUTTable table) {
+        if (!lp.enabled || lp.intensity <= 0.0001f) {
+            return;
+        }
+        // Pages a user LUT in on first use; a file that fails to load drops
+        // the layer like an unassigned one.
+        std::uint32_t revision = 0;
+        std::shared_ptr<const void> owner;
+        std::shared_ptr<const void> infoOwner;
+        const LUT3D* lut = library.Get(table, lp.lutIndex, &revision, &owner);
+        const LUTInfo* info = lut ? library.Info(table, lp.lutIndex, &infoOwner) : nullptr;
+        if (infoOwner != owner) {
+            info = nullptr;  // a rescan replaced the file in between; that info is the new file's
+        }
+        if (!lut || (info && info->structure.kind == LUTClass::kIdentity)) {
+            return;
+        }
+        StackLayer& layer = stack.layers[stack.count++];
+        layer.lut = lut;
+        layer.lutId = LUTLibrary::LUTId(table, lp.lutIndex);
+        layer.revision = revision;
+        layer.intensity = clamp01(lp.intensity);
+        layer.structure = info && info->structure.fast() ? &info->structure : nullptr;
+        layer.owner = std::move(owner);
+    };
+    tryAdd(params.logConvert, LUTTable::kLog);
+    const bool logInput = stack.count > 0;
+    tryAdd(params.creative, LUTTable::kRec709);
+    tryAdd(params.secondary, LUTTable::kRec709);
+    tryAdd(params.accent, LUTTable::kRec709);
+    stack.input = inputTrim(params.trim, logInput);
+    stack.output = outputTrim(params.trim);
+    return stack;
+}
+
+// Walks the stack through the delta cache; `current` is the stack output
+// after layer i.
+std::shared_ptr<CompositeLUT> bakeLayers(const ResolvedStack& stack, const CompositeKey& compositeKey, int dim,
+                                         BakeOrigin origin) {
+    const LUT3D* first = stack.count > 0 ? stack.layers[0].lut : nullptr;
+    std::shared_ptr<const Lattice> current = stack.count > 0 ? nullptr : makeBase(dim, nullptr, stack.input);
+    DeltaKey deltaKey;
+    deltaKey.dimension = dim;
+    deltaKey.input = stack.input;
+    for (int i = 0; i < stack.count; ++i) {
+        deltaKey.depth = i;
+        deltaKey.luts[i] = compositeKey.luts[i];
+
+        std::shared_ptr<const Lattice> base;
+        std::shared_ptr<const Lattice> delta;
+        {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+            if (DeltaEntry* hit = findLRU(g_deltas, deltaKey, origin)) {
+                base = hit->base;
+                delta = hit->delta;
+            }
+        }
+
+        if (!delta) {
+            base = current ? current : makeBase(dim, first, stack.input);
+            delta = makeDelta(stack.layers[i], *base);
+            DeltaEntry entry;
+            entry.key = deltaKey;
+            for (int j = 0; j <= i; ++j) {
+                if (stack.layers[j].owner) entry.owners.push_back(stack.layers[j].owner);
+            }
+            entry.base = base;
+            entry.delta = delta;
+            entry.bytes = (base->size() + delta->size()) * sizeof(float);
+            {
+                std::lock_guard<std::mutex> lock(g_cacheMutex);
+                insertLRU(g_deltas, std::move(entry), origin);
+            }
+            CacheBudget::Shared().Enforce();
+        }
+
+        current = reweight(*base, *delta, compositeKey.intensity[i]);
+        deltaKey.upstream[i] = compositeKey.intensity[i];
+    }
+
+    auto composite = std::make_shared<CompositeLUT>();
+    composite->dimension = dim;
+    composite->data = *current;
+    if (stack.output.active) {
+        applyTrim(stack.output, composite->data);
+    }
+    if (first && first->shaper) {
+        composite->shaper.assign(first->shaper, first->shaper + static_cast<std::size_t>(first->shaperSize) * 3);
+    }
+    return composite;
+}
+
+// Both ends of a transition at `dim`, lerped node by node. The lattice is
+// laid out like the first end that has one; an end without layers or trims
+// (the identity) or with another shaper is sampled at those nodes instead.
+std::shared_ptr<CompositeLUT> blendTransition(const ResolvedStack& stack, int dim, BakeOrigin origin) {
+    ResolvedStack fromStack = stack;
+    fromStack.to.reset();
+    fromStack.mix = 0.0f;
+    const std::shared_ptr<const CompositeLUT> ends[2] = {AcquireComposite(fromStack, dim, origin),
+                                                         AcquireComposite(*stack.to, dim, origin)};
+    const CompositeLUT* layout = ends[0] ? ends[0].get() : ends[1].get();
+
+    auto blended = std::make_shared<CompositeLUT>();
+    blended->dimension = dim;
+    if (layout) {
+        blended->shaper = layout->shaper;
+    }
+    const LUT3D layoutView = blended->view();
+    Lattice resampled[2];
+    const Lattice* values[2];
+    for (int e = 0; e < 2; ++e) {
+        const CompositeLUT* end = ends[e].get();
+        if (end && !end->adaptive && end->shaper == blended->shaper) {
+            values[e] = &end->data;
+            continue;
+        }
+        // An end already swapped for its adaptive form is sampled through it.
+        resampled[e] = *makeBase(dim, layoutView.shaper ? &layoutView : nullptr, StackTrim());
+        if (end) {
+            const ResolvedLayer resolved = end->adaptive ? ResolvedLayer{} : ResolveLayer(end->view(), 1.0f);
+            Lattice& nodes = resampled[e];
+            for (std::size_t i = 0; i < nodes.size(); i += 3) {
+                const RGB c = end->adaptive ? end->adaptive->Sample(nodes[i], nodes[i + 1], nodes[i + 2])
+                                            : sampleLUTFast(resolved, nodes[i], nodes[i + 1], nodes[i + 2]);
+                nodes[i] = c.r;
+                nodes[i + 1] = c.g;
+                nodes[i + 2] = c.b;
+            }
+        }
+        values[e] = &resampled[e];
+    }
+
+    const Lattice& a = *values[0];
+    const Lattice& b = *values[1];
+    const float t = stack.mix;
+    blended->data.resize(a.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        blended->data[i] = a[i] + t * (b[i] - a[i]);
+    }
+    return blended;
+}
+
+std::size_t compositeBytes(const CompositeLUT& composite) {
+    return (composite.data.size() + composite.shaper.size()) * sizeof(float) +
+           (composite.adaptive ? composite.adaptive->Bytes() : 0);
+}
+
+// Builds the adaptive form of a composite just cached and, when it is worth
+// keeping, swaps the cached entry's lattice for it. Renders holding the dense
+// composite keep it until they finish.
+void queueAdaptiveComposite(const std::shared_ptr<const CompositeLUT>& composite) {
+    if (composite->dimension <= kMaxDenseDim || adaptiveTolerance() <= 0.0f) {
+        return;
+    }
+    std::weak_ptr<const CompositeLUT> weak = composite;
+    BackgroundQueue::Shared().Submit(TaskLane::kRefine, [weak] {
+        const std::shared_ptr<const CompositeLUT> dense = weak.lock();
+        if (!dense) {
+            return;  // evicted meanwhile
+        }
+        auto slim = std::make_shared<CompositeLUT>();
+        slim->adaptive = makeAdaptive(dense->view());
+        if (!slim->adaptive) {
+            return;
+        }
+        slim->dimension = dense->dimension;
+        slim->shaper = dense->shaper;
+        {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+            for (CompositeEntry& e : g_composites) {
+                if (e.lut == dense && !e.keepDense) {
+                    CacheBudget::Shared().Release(e.bytes);
+                    e.lut = slim;
+                    e.bytes = compositeBytes(*slim);
+                    CacheBudget::Shared().Charge(e.bytes);
+                    break;
+                }
+            }
+        }
+        CacheBudget::Shared().Enforce();
+    });
+}
+
+std::shared_ptr<const CompositeLUT> acquireComposite(const ResolvedStack& stack, int dimension, BakeOrigin origin,
+                                                     bool dense) {
+    if (stack.Empty()) {
+        return nullptr;
+    }
+    registerWithBudget();
+
+    const int dim = dimension > 1 ? dimension : FullCompositeDimension(stack);
+    const CompositeKey compositeKey = makeCompositeKey(stack, dim);
+
+    {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        if (CompositeEntry* hit = findComposite(compositeKey, origin)) {
+            hit->keepDense = hit->keepDense || dense;
+            if (!dense || !hit->lut->adaptive) {
+                return hit->lut;
+            }
+            // Already swapped: rebake the lattice below and put it back.
+        }
+    }
+
+    std::shared_ptr<CompositeLUT> composite =
+        stack.to ? blendTransition(stack, dim, origin) : bakeLayers(stack, compositeKey, dim, origin);
+
+    CompositeEntry entry;
+    entry.key = compositeKey;
+    entry.owners = ownersOf(stack);
+    entry.lut = composite;
+    entry.bytes = compositeBytes(*composite);
+    entry.keepDense = dense;
+    bool swapBack = false;
+    {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        CompositeEntry* slim = dense ? findLRU(g_composites, compositeKey, BakeOrigin::kSpeculative) : nullptr;
+        if (slim && slim->lut->adaptive) {
+            CacheBudget::Shared().Release(slim->bytes);
+            slim->lut = composite;
+            slim->bytes = entry.bytes;
+            CacheBudget::Shared().Charge(slim->bytes);
+            swapBack = true;
+        } else if (insertLRU(g_composites, std::move(entry), origin) && origin == BakeOrigin::kSpeculative) {
+            ++g_prefetchStats.baked;
+        }
+    }
+    CacheBudget::Shared().Enforce();
+    if (!dense && !swapBack) {
+        queueAdaptiveComposite(composite);
+    }
+    return composite;
+}
+
+}  // namespace
+
+ResolvedStack ResolveStack(const ParamsSnapshot& params) {
+    ResolvedStack stack = resolveLayers(params);
+    const TransitionParams& transition = params.transition;
+    if (!transition.enabled) {
+        return stack;
+    }
+    const float steps = static_cast<float>(kTransitionMixSteps);
+    const float mix = std::round(clamp01(transition.mix) * steps) / steps;
+    if (mix <= 0.0f) {
+        return stack;
+    }
+    ParamsSnapshot target = params;
+    target.creative.enabled = true;
+    target.creative.lutIndex = transition.toLutIndex;
+    if (!params.creative.enabled) {
+        target.creative.intensity = 1.0f;
+    }
+    ResolvedStack to = resolveLayers(target);
+    if (mix >= 1.0f || to == stack) {
+        return to;
+    }
+    stack.to = std::make_shared<const ResolvedStack>(std::move(to));
+    stack.mix = mix;
+    return stack;
+}
+
+bool CollapseStructured(const ResolvedStack& stack, LUTStructure& out) {
+    if (stack.to) {
+        return false;
+    }
+    if (stack.count == 0) {
+        if (!stack.Trimmed()) return false;
+        // Nothing clamps between the two trims: one matrix.
+        const StackTrim& a = stack.input;
+        const StackTrim& b = stack.output;
+        float matrix[3][3], offset[3];
+        for (int row = 0; row < 3; ++row) {
+            offset[row] = b.offset[row];
+            for (int col = 0; col < 3; ++col) {
+                matrix[row][col] = 0.0f;
+                for (int k = 0; k < 3; ++k) matrix[row][col] += b.matrix[row][k] * a.matrix[k][col];
+                offset[row] += b.matrix[row][col] * a.offset[col];
+            }
+        }
+        out = AffineStructure(matrix, offset);
+        return true;
+    }
+    if (!stack.NeedsComposite()) {
+        return false;
+    }
+
+    // Trims are affine structures at full intensity; ComposeStructures
+    // refuses an input trim that leaves the unit cube, since the first layer
+    // clamps it.
+    LUTStructure trims[2];
+    const LUTStructure* parts[ResolvedStack::kMaxLayers + 2];
+    float intensities[ResolvedStack::kMaxLayers + 2];
+    int n = 0;
+    if (stack.input.active) {
+        trims[0] = AffineStructure(stack.input.matrix, stack.input.offset);
+        parts[n] = &trims[0];
+        intensities[n++] = 1.0f;
+    }
+    for (int i = 0; i < stack.count; ++i) {
+        if (!stack.layers[i].structure) return false;
+        parts[n] = stack.layers[i].structure;
+        intensities[n++] = effectiveIntensity(stack.layers[i].intensity);
+    }
+    if (stack.output.active) {
+        trims[1] = AffineStructure(stack.output.matrix, stack.output.offset);
+        parts[n] = &trims[1];
+        intensities[n++] = 1.0f;
+    }
+
+    LUTStructure collapsed;
+    if (!ComposeStructures(*parts[0], intensities[0], *parts[1], intensities[1], collapsed)) {
+        return false;
+    }
+    for (int i = 2; i < n; ++i) {
+        LUTStructure next;
+        if (!ComposeStructures(collapsed, 1.0f, *parts[i], intensities[i], next)) {
+            return false;
+        }
+        collapsed = std::move(next);
+    }
+    out = std::move(collapsed);
+    return true;
+}
+
+int FullCompositeDimension(const ResolvedStack& stack) {
+    int dim = 2;
+    for (int i = 0; i < stack.count; ++i) {
+        dim = std::max(dim, stack.layers[i].lut->dimension);
+    }
+    return stack.to ? std::max(dim, FullCompositeDimension(*stack.to)) : dim;
+}
+
+std::shared_ptr<const CompositeLUT> FindComposite(const ResolvedStack& stack, int dimension) {
+    if (stack.Empty()) {
+        return nullptr;
+    }
+    const CompositeKey compositeKey =
+        makeCompositeKey(stack, dimension > 1 ? dimension : FullCompositeDimension(stack));
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    CompositeEntry* hit = findComposite(compositeKey, BakeOrigin::kDemand);
+    return hit ? hit->lut : nullptr;
+}
+
+bool HasComposite(const ResolvedStack& stack, int dimension) {
+    if (stack.Empty()) {
+        return false;
+    }
+    const CompositeKey compositeKey =
+        makeCompositeKey(stack, dimension > 1 ? dimension : FullCompositeDimension(stack));
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    return findComposite(compositeKey, BakeOrigin::kSpeculative) != nullptr;
+}
+
+PrefetchStats GetPrefetchStats() {
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    return g_prefetchStats;
+}
+
+void InvalidateComposites(const LUT3D* lut) {
+    if (!lut) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    for (auto it = g_deltas.begin(); it != g_deltas.end();) {
+        const DeltaKey& key = it->key;
+        if (std::find(key.luts, key.luts + key.depth + 1, lut->data) != key.luts + key.depth + 1) {
+            eraseEntry(g_deltas, it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = g_composites.begin(); it != g_composites.end();) {
+        const CompositeKey& key = it->key;
+        const int toCount = std::max(key.toCount, 0);
+        if (std::find(key.luts, key.luts + key.count, lut->data) != key.luts + key.count ||
+            std::find(key.toLuts, key.toLuts + toCount, lut->data) != key.toLuts + toCount) {
+            eraseEntry(g_composites, it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = g_adaptives.begin(); it != g_adaptives.end();) {
+        if (it->key == lut->data) {
+            eraseEntry(g_adaptives, it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = g_reduced.begin(); it != g_reduced.end();) {
+        if (it->key == lut->data) {
+            eraseEntry(g_reduced, it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::shared_ptr<const AdaptiveLUT> AcquireAdaptive(const StackLayer& layer) {
+    const LUT3D* lut = layer.lut;
+    if (!lut || lut->dimension <= kMaxDenseDim || adaptiveTolerance() <= 0.0f) {
+        return nullptr;
+    }
+    registerWithBudget();
+    {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        if (AdaptiveEntry* hit = findLRU(g_adaptives, lut->data, BakeOrigin::kDemand)) {
+            return hit->lut;
+        }
+        // Placeholder so later frames do not queue the build again. It is
+        // charged a token size so the budget can still evict it.
+        AdaptiveEntry entry;
+        entry.key = lut->data;
+        entry.owner = layer.owner;
+        entry.bytes = sizeof(AdaptiveEntry);
+        insertLRU(g_adaptives, std::move(entry), BakeOrigin::kDemand);
+    }
+    CacheBudget::Shared().Enforce();
+
+    // The layer's owner keeps a user LUT readable until the task has run.
+    BackgroundQueue::Shared().Submit(TaskLane::kRefine, [layer] {
+        const LUT3D* lut = layer.lut;
+        std::shared_ptr<const AdaptiveLUT> adaptive = makeAdaptive(*lut);
+        if (!adaptive) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+            for (AdaptiveEntry& e : g_adaptives) {
+                if (e.key == lut->data && !e.lut) {
+                    CacheBudget::Shared().Release(e.bytes);
+                    e.lut = adaptive;
+                    e.bytes = adaptive->Bytes();
+                    CacheBudget::Shared().Charge(e.bytes);
+                    break;
+                }
+            }
+        }
+        CacheBudget::Shared().Enforce();
+    });
+    return nullptr;
+}
+
+std::shared_ptr<const LUTReduction> AcquireReduced(const StackLayer& layer) {
+    const LUT3D* lut = layer.lut;
+    if (!lut || LUTLibrary::TableOf(layer.lutId) != LUTTable::kRec709 || interactiveDeltaE() <= 0.0f ||
+        lut->dimension <= kReducedLUTDims[0]) {
+        return nullptr;
+    }
+    registerWithBudget();
+    {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        if (ReducedEntry* hit = findLRU(g_reduced, lut->data, BakeOrigin::kDemand)) {
+            return hit->lut;
+        }
+        ReducedEntry entry;
+        entry.key = lut->data;
+        entry.owner = layer.owner;
+        entry.bytes = sizeof(ReducedEntry);
+        insertLRU(g_reduced, std::move(entry), BakeOrigin::kDemand);
+    }
+    CacheBudget::Shared().Enforce();
+
+    std::string name = LUTLibrary::Shared().Name(LUTTable::kRec709, LUTLibrary::IndexOf(layer.lutId));
+    BackgroundQueue::Shared().Submit(TaskLane::kRefine, [layer, label = name.empty() ? "?" : std::move(name)] {
+        const LUT3D* lut = layer.lut;
+        const float bound = interactiveDeltaE();
+        auto reduced = std::make_shared<LUTReduction>(ReduceLUT(*lut, bound));
+        if (!reduced->reduced()) {
+            VTC_LUT_LOG("\"%s\" stays %d^3 in interactive renders, nothing smaller within "
+                        "dE2000 %g", label.c_str(), reduced->sourceDimension, bound);
+            return;
+        }
+        VTC_LUT_LOG("\"%s\" %d^3 -> %d^3 in interactive renders, max dE2000 %.2f", label.c_str(),
+                    reduced->sourceDimension, reduced->dimension, reduced->maxDeltaE);
+        {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+            for (ReducedEntry& e : g_reduced) {
+                if (e.key == lut->data && !e.lut) {
+                    CacheBudget::Shared().Release(e.bytes);
+                    e.lut = reduced;
+                    e.bytes = reduced->Bytes();
+                    CacheBudget::Shared().Charge(e.bytes);
+                    break;
+                }
+            }
+        }
+        CacheBudget::Shared().Enforce();
+    });
+    return nullptr;
+}
+
+std::shared_ptr<const CompositeLUT> AcquireComposite(const ResolvedStack& stack, int dimension, BakeOrigin origin) {
+    return acquireComposite(stack, dimension, origin, false);
+}
+
+std::shared_ptr<const CompositeLUT> AcquireDenseComposite(const ResolvedStack& stack, int dimension) {
+    return acquireComposite(stack, dimension, BakeOrigin::kDemand, true);
+}
+
+}  // namespace vtc
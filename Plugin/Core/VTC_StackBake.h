@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../Shared/VTC_LUTData.h"
+#include "../Shared/VTC_Params.h"
+
+namespace vtc {
+
+class AdaptiveLUT;
+struct LUTReduction;
+struct LUTStructure;
+
+// A contributing layer of the look stack, in render order.
+struct StackLayer {
+    const LUT3D* lut = nullptr;
+    std::uint32_t lutId = 0;     // LUTLibrary::LUTId, stable across processes
+    std::uint32_t revision = 0;  // bumped when the user file behind lutId changes
+    float intensity = 0.0f;   // 0..1, pre-clamped
+    const LUTStructure* structure = nullptr;  // affine or separable form of lut, if it has one
+    // Keeps a user LUT's lattice and structure alive after a rescan replaces
+    // it (see LUTLibrary::Get); null for built-ins.
+    std::shared_ptr<const void> owner;
+};
+
+// A TrimParams group as the affine map it is on code values: `matrix * c +
+// offset`, unclamped. The layer after an input trim clamps its input like any
+// layer; the frame write clamps after an output trim.
+struct StackTrim {
+    float matrix[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    float offset[3] = {};
+    bool active = false;  // false: identity, and matrix/offset are too
+
+    bool operator==(const StackTrim& o) const {
+        if (active != o.active) return false;
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                if (matrix[row][col] != o.matrix[row][col]) return false;
+            }
+            if (offset[row] != o.offset[row]) return false;
+        }
+        return true;
+    }
+};
+
+struct ResolvedStack {
+    static constexpr int kMaxLayers = 4;
+
+    StackLayer layers[kMaxLayers];
+    int count = 0;
+    StackTrim input;   // ahead of layers[0], on the clamped source
+    StackTrim output;  // after the last layer
+
+    // Mid-transition: the stack being faded to and how far, quantized to
+    // kTransitionMixSteps. Null otherwise, including at either end of the
+    // fade, where the stack simply is the one or the other.
+    std::shared_ptr<const ResolvedStack> to;
+    float mix = 0.0f;
+
+    bool Trimmed() const { return input.active || output.active; }
+
+    // Renders as a plain copy of the source.
+    bool Empty() const { return count == 0 && !Trimmed() && !to; }
+
+    // Rendered through one baked lattice: several layers, a trimmed one, or
+    // a transition. A trimmed stack without layers is a single affine map
+    // (see CollapseStructured).
+    bool NeedsComposite() const { return count > 1 || (count == 1 && Trimmed()) || to; }
+
+    bool operator==(const ResolvedStack& o) const {
+        if (count != o.count || !(input == o.input) || !(output == o.output) || mix != o.mix) return false;
+        for (int i = 0; i < count; ++i) {
+            if (layers[i].lut != o.layers[i].lut || layers[i].intensity != o.layers[i].intensity) return false;
+        }
+        return to ? o.to && *to == *o.to : !o.to;
+    }
+};
+
+// Mix steps a transition is quantized to. Each step is one cached composite;
+// 1/256 of a crossfade is below what an 8-bit frame can show.
+constexpr int kTransitionMixSteps = 256;
+
+// Drops disabled, unassigned, zero-intensity and identity layers, and turns
+// params.trim into the input and output trims. Exposure and white balance
+// are gains in linear light: on a Log table layer's input they are offsets
+// of about 0.075 code values per stop (camera log curves), otherwise gains
+// through a 2.4 display gamma. Saturation scales the distance from Rec.709
+// luma on code values.
+//
+// An enabled transition resolves the stack a second time with its look in
+// the creative slot (at the creative intensity, or full when the slot is
+// off) and hangs it off the first as `to`.
+ResolvedStack ResolveStack(const ParamsSnapshot& params);
+
+// The whole stack, trims included, as one affine or separable structure,
+// when every layer has one and they compose (see ComposeStructures). Needs no
+// lattice at all; always succeeds for a trimmed stack without layers, never
+// for a transition.
+bool CollapseStructured(const ResolvedStack& stack, LUTStructure& out);
+
+// Whole stack baked into one lattice (same r-fastest layout as LUT3D). When
+// the first layer is shaped the composite keeps its shaper, so the lattice
+// nodes stay where that layer needs them.
+//
+// Above 65^3 the cache swaps a composite for its adaptive form once that is
+// built (see AcquireAdaptive): `adaptive` is then set and `data` is empty, so
+// view() has no lattice. Renders sample whichever one there is;
+// AcquireDenseComposite always gives the lattice.
+struct CompositeLUT {
+    std::vector<float> data;
+    int dimension = 0;
+    std::vector<float> shaper;  // empty, or 3 * shaperSize entries
+    std::shared_ptr<const AdaptiveLUT> adaptive;  // null, or `data` is empty
+
+    LUT3D view() const {
+        return {data.data(), dimension, shaper.empty() ? nullptr : shaper.data(),
+                static_cast<int>(shaper.size() / 3)};
+    }
+};
+
+enum class BakeOrigin {
+    kDemand,       // a render needs it now
+    kSpeculative,  // baked ahead of demand; lowest eviction priority
+};
+
+// Counters for speculative bakes. hits / baked is the prefetch hit rate.
+struct PrefetchStats {
+    std::uint64_t baked = 0;  // speculative composites that entered the cache
+    std::uint64_t hits = 0;   // of those, later requested by a render
+};
+
+// Lattice size that reproduces the stack without loss: its largest layer (2
+// for trims alone, which are affine), across both ends of a transition.
+int FullCompositeDimension(const ResolvedStack& stack);
+
+// Returns the composite for `stack` at `dimension` (0 = full), or nullptr for
+// an empty stack (see ResolvedStack::Empty). Trims are folded in at the
+// lattice nodes: the input trim moves the points the first layer is sampled
+// at, the output trim is applied to the finished lattice.
+//
+// Each layer's contribution is kept as a delta lattice over the stack output
+// that feeds it (lerp(c, L(c), t) = c + t * (L(c) - c)), keyed by the layers
+// and intensities upstream of it. Changing the intensity of the last layer
+// therefore only re-weights a cached delta; changing an earlier intensity
+// re-samples the layers below it and nothing above. Cached lattices are
+// charged to CacheBudget and evicted LRU against it. Thread-safe.
+//
+// A transition acquires the composites of both ends at the same size and
+// blends them node by node, so a keyframed mix costs one lerp over the
+// lattice per new mix step; each step is cached like any composite.
+//
+// A composite above 65^3 is returned dense from its bake; its adaptive form
+// is built on the background queue and then replaces it in the cache.
+std::shared_ptr<const CompositeLUT> AcquireComposite(const ResolvedStack& stack, int dimension = 0,
+                                                     BakeOrigin origin = BakeOrigin::kDemand);
+
+// Same, always with `data`, for consumers that upload the lattice (the GPU
+// paths). The cached entry then keeps its lattice and is never swapped for
+// the adaptive form.
+std::shared_ptr<const CompositeLUT> AcquireDenseComposite(const ResolvedStack& stack, int dimension = 0);
+
+// Cache lookup only; never bakes. Returns nullptr on a miss.
+std::shared_ptr<const CompositeLUT> FindComposite(const ResolvedStack& stack, int dimension = 0);
+
+// Whether FindComposite would hit, for readiness polls: unlike it, not a use.
+// The entry keeps its LRU place, and a speculative one stays speculative and
+// is not counted as a prefetch hit.
+bool HasComposite(const ResolvedStack& stack, int dimension = 0);
+
+PrefetchStats GetPrefetchStats();
+
+// The AdaptiveLUT form of a single library LUT, for lattices too large to
+// stay in cache (above 65^3) whose adaptive form is at most a quarter of the
+// size. Returns nullptr when there is none or it is still being built: the
+// first call queues the build on the background queue and the caller renders
+// from the dense lattice meanwhile. VTC_ADAPTIVE_LUT_TOLERANCE sets the error
+// bound (default 1/2048; 0 turns adaptive lattices off).
+std::shared_ptr<const AdaptiveLUT> AcquireAdaptive(const StackLayer& layer);
+
+// The smaller lattice a look layer samples in interactive renders (see
+// ReduceLUT), within VTC_INTERACTIVE_DELTA_E CIEDE2000 of the full one
+// (default kDefaultInteractiveDeltaE; 0 turns reduction off). Only looks,
+// the Rec 709 table, are reduced. Returns nullptr while the reduction runs
+// on the background queue and for LUTs no smaller size reproduces; the size
+// chosen for each LUT, and its error, are logged when it finishes.
+std::shared_ptr<const LUTReduction> AcquireReduced(const StackLayer& layer);
+
+// Drops every cached lattice built from `lut`, e.g. once its file has been
+// replaced on disk. Composites already handed out stay valid.
+void InvalidateComposites(const LUT3D* lut);
+
+}  // namespace vtc
@@ -0,0 +1,96 @@
+#include "VTC_StackExport.h"
+
+#include <cstdio>
+
+#include "VTC_LUTSampling.h"
+
+namespace vtc {
+
+namespace {
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+}  // namespace
+
+bool BakeStackLattice(const ParamsSnapshot& params, int dimension, std::vector<float>& out) {
+    if (dimension < 2 || dimension > kMaxExportDimension) {
+        return false;
+    }
+    // One row per (g, b) pair, r along the row: the frame is the lattice.
+    const int width = dimension;
+    const int height = dimension * dimension;
+    const std::size_t pixels = static_cast<std::size_t>(width) * height;
+    std::vector<float> frame(pixels * 4);
+    const float inv = 1.0f / static_cast<float>(dimension - 1);
+    float* px = frame.data();
+    for (int b = 0; b < dimension; ++b) {
+        for (int g = 0; g < dimension; ++g) {
+            for (int r = 0; r < dimension; ++r) {
+                *px++ = r * inv;
+                *px++ = g * inv;
+                *px++ = b * inv;
+                *px++ = 1.0f;
+            }
+        }
+    }
+
+    // Nodes are colors, not graphics: alpha plays no part.
+    ParamsSnapshot straight = params;
+    straight.alphaMode = AlphaMode::kStraight;
+    std::vector<float> graded(frame.size());
+    const int rowBytes = width * 4 * static_cast<int>(sizeof(float));
+    const FrameDesc src{frame.data(), width, height, rowBytes, FrameFormat::kRGBA_32f};
+    FrameDesc dst{graded.data(), width, height, rowBytes, FrameFormat::kRGBA_32f};
+    ProcessFrameCPU(straight, src, dst);
+
+    out.resize(pixels * 3);
+    for (std::size_t i = 0; i < pixels; ++i) {
+        out[3 * i] = graded[4 * i];
+        out[3 * i + 1] = graded[4 * i + 1];
+        out[3 * i + 2] = graded[4 * i + 2];
+    }
+    return true;
+}
+
+bool WriteCube(const std::string& path, const std::vector<float>& data, int dimension, const std::string& title,
+               std::string* error) {
+    const std::size_t entries = static_cast<std::size_t>(dimension) * dimension * dimension;
+    if (dimension < 2 || data.size() != entries * 3) {
+        return fail(error, "lattice does not match LUT_3D_SIZE " + std::to_string(dimension));
+    }
+    std::string tmp;
+    std::FILE* f = CreateTempFile(path, tmp);
+    if (!f) return fail(error, "cannot write " + tmp);
+    bool ok = std::fprintf(f, "TITLE \"%s\"\nLUT_3D_SIZE %d\nDOMAIN_MIN 0.0 0.0 0.0\nDOMAIN_MAX 1.0 1.0 1.0\n",
+                           title.c_str(), dimension) > 0;
+    for (std::size_t i = 0; ok && i < entries; ++i) {
+        ok = std::fprintf(f, "%.6f %.6f %.6f\n", data[3 * i], data[3 * i + 1], data[3 * i + 2]) > 0;
+    }
+    if (std::fclose(f) != 0 || !ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return fail(error, "cannot write " + path);
+    }
+    return true;
+}
+
+bool ExportStack(const ParamsSnapshot& params, const std::string& path, const StackExportOptions& options,
+                 std::string* error) {
+    std::vector<float> lattice;
+    if (!BakeStackLattice(params, options.dimension, lattice)) {
+        return fail(error, "dimension must be 2.." + std::to_string(kMaxExportDimension));
+    }
+    if (!options.pack) {
+        return WriteCube(path, lattice, options.dimension, options.title, error);
+    }
+    LUTPackItem item;
+    item.name = options.title;
+    item.data = lattice.data();
+    item.dimension = options.dimension;
+    item.precision = options.precision;
+    return WriteLUTPack(path, {item}, {}, error);
+}
+
+}  // namespace vtc
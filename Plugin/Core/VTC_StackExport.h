@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../Shared/VTC_Params.h"
+#include "VTC_LUTPack.h"
+
+namespace vtc {
+
+// A look stack flattened to one lattice for systems that cannot run the
+// plugin (on-set monitoring, ffmpeg, dailies): they apply a single lookup
+// and get what the editor sees.
+//
+// The lattice nodes are rendered as a frame through ProcessFrameCPU with the
+// stack's own params, so every layer, intensity and trim goes through the
+// engine that renders the timeline, at final quality. Between nodes the
+// downstream system interpolates; export at the resolution its lookup uses.
+
+constexpr int kDefaultExportDimension = 33;
+constexpr int kMaxExportDimension = 129;
+
+// dimension^3 RGB output of `params`, r fastest (.cube order). False when
+// `dimension` is outside [2, kMaxExportDimension].
+bool BakeStackLattice(const ParamsSnapshot& params, int dimension, std::vector<float>& out);
+
+// Writes the lattice as a .cube with `title`, through a temporary file
+// renamed into place.
+bool WriteCube(const std::string& path, const std::vector<float>& data, int dimension, const std::string& title,
+               std::string* error = nullptr);
+
+struct StackExportOptions {
+    int dimension = kDefaultExportDimension;
+    std::string title = "VTC Looks";  // .cube TITLE, or the pack entry's name
+    bool pack = false;                // a one-entry .vtclut instead of a .cube
+    LUTPrecision precision = LUTPrecision::kF32;  // pack only
+};
+
+// BakeStackLattice, then WriteCube or WriteLUTPack to `path`.
+bool ExportStack(const ParamsSnapshot& params, const std::string& path, const StackExportOptions& options,
+                 std::string* error = nullptr);
+
+}  // namespace vtc
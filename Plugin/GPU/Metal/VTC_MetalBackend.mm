@@ -1,12 +1,15 @@
 #include "VTC_MetalBackend.h"
+#include "../../Core/VTC_CacheBudget.h"
 #include "../../Core/VTC_CopyUtils.h"
-#include "../../Core/VTC_LUTRegistry.h"
+#include "../../Core/VTC_LUTLibrary.h"
+#include "../../Core/VTC_StackBake.h"
 #import <Metal/Metal.h>
 #include <algorithm>
 #include <array>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -21,13 +24,17 @@ struct MetalParams {
   uint32_t srcRowBytes;
   uint32_t dstRowBytes;
   uint32_t layerCount;
+  uint32_t premultiplied;  // AlphaMode::kPremultiplied
 };
 
+// A shaped layer's shaper (shaperSize floats per channel) follows its lattice
+// in the LUT buffer.
 struct LayerInfo {
   uint32_t offset;
   uint32_t dim;
   float scale;
   float intensity;
+  uint32_t shaperSize;
 };
 
 id<MTLDevice> gDevice = nil;
@@ -59,6 +66,7 @@ struct MetalParams {
     uint srcRowBytes;
     uint dstRowBytes;
     uint layerCount;
+    uint premultiplied;
 };
 
 struct LayerInfo {
@@ -66,8 +74,16 @@ struct LayerInfo {
     uint dim;
     float scale;
     float intensity;
+    uint shaperSize;
 };
 
+inline float applyShaper(device const float* curve, int n, float v) {
+    float x = clamp(v, 0.0f, 1.0f) * float(n - 1);
+    int i0 = int(x);
+    int i1 = min(i0 + 1, n - 1);
+    return mix(curve[i0], curve[i1], x - float(i0));
+}
+
 inline float3 sampleLUT3D(device const float* lut, int dim, float r, float g, float b) {
     float s = float(dim - 1);
     r = clamp(r, 0.0f, 1.0f) * s;
@@ -119,14 +135,30 @@ kernel void vtc_apply_32f(
     uint srcIdx = (gid.y * p.srcRowBytes) / 16 + gid.x;
     uint dstIdx = (gid.y * p.dstRowBytes) / 16 + gid.x;
     float4 c = src[srcIdx];
-    float r = c.x, g = c.y, b = c.z;
+    // Premultiplied: grade the unpremultiplied color (transparent is black),
+    // then clamp and premultiply again.
+    float a = clamp(c.w, 0.0f, 1.0f);
+    float unpremul = p.premultiplied != 0 ? (a > 0.0f ? 1.0f / a : 0.0f) : 1.0f;
+    float r = c.x * unpremul, g = c.y * unpremul, b = c.z * unpremul;
     for (uint i = 0; i < p.layerCount && i < 4; ++i) {
-        float3 lutRGB = sampleLUT3D(lutBuf + layers[i].offset,
-                                     int(layers[i].dim), r, g, b);
+        device const float* lut = lutBuf + layers[i].offset;
+        int dim = int(layers[i].dim);
+        float sr = r, sg = g, sb = b;
+        if (layers[i].shaperSize > 0) {
+            int n = int(layers[i].shaperSize);
+            device const float* curve = lut + dim * dim * dim * 3;
+            sr = applyShaper(curve, n, r);
+            sg = applyShaper(curve + n, n, g);
+            sb = applyShaper(curve + 2 * n, n, b);
+        }
+        float3 lutRGB = sampleLUT3D(lut, dim, sr, sg, sb);
         r = mix(r, lutRGB.x, layers[i].intensity);
         g = mix(g, lutRGB.y, layers[i].intensity);
         b = mix(b, lutRGB.z, layers[i].intensity);
     }
+    if (p.premultiplied != 0) {
+        r = clamp(r, 0.0f, 1.0f) * a; g = clamp(g, 0.0f, 1.0f) * a; b = clamp(b, 0.0f, 1.0f) * a;
+    }
     dst[dstIdx] = float4(r, g, b, c.w);
 }
 )";
@@ -195,9 +227,12 @@ void initPipeline(id<MTLCommandQueue> q) {
       for (int i = 0; i < n; ++i) {
         const LUT3D &lut = table[i];
         const int lutValues = lut.dimension * lut.dimension * lut.dimension * 3;
+        const int shaperValues = lut.shaper ? lut.shaperSize * 3 : 0;
         offsets.push_back(totalFloats);
         allLUTData.insert(allLUTData.end(), lut.data, lut.data + lutValues);
-        totalFloats += lutValues;
+        allLUTData.insert(allLUTData.end(), lut.shaper,
+                          lut.shaper + shaperValues);
+        totalFloats += lutValues + shaperValues;
       }
     };
 
@@ -240,28 +275,208 @@ bool blitCopy(id<MTLCommandQueue> q, id<MTLBuffer> srcBuf, id<MTLBuffer> dstBuf,
   return cb.status == MTLCommandBufferStatusCompleted;
 }
 
+// Releases a +1 buffer at the end of a dispatch (this file is built without
+// ARC).
+struct ScopedBuffer {
+  id<MTLBuffer> buffer = nil;
+  ~ScopedBuffer() { [buffer release]; }
+};
+
+// Uploaded stacks that are not in gLUTCacheBuffer, kept across frames and
+// charged to CacheBudget. Keyed by the lattices' addresses, which stay valid
+// because an entry holds the composite and user LUTs it was copied from.
+struct StackBufferKey {
+  std::array<const float *, 4> data{};
+  std::array<int, 4> dims{};
+  uint32_t count = 0;
+  bool operator==(const StackBufferKey &o) const {
+    return data == o.data && dims == o.dims && count == o.count;
+  }
+};
+
+struct StackBuffer {
+  StackBufferKey key;
+  id<MTLBuffer> buffer = nil; // cache owns one retain
+  size_t bytes = 0;
+  uint64_t lastUse = 0;
+  std::shared_ptr<const CompositeLUT> composite;
+  std::array<std::shared_ptr<const void>, 4> owners;
+};
+
+std::mutex gStackBufferMutex;
+std::vector<StackBuffer> gStackBuffers;
+
+// A dispatch retains the buffer it binds, so any entry can go at any time.
+class StackBufferCache final : public BudgetedCache {
+public:
+  bool OldestUse(uint64_t &tick) override {
+    std::lock_guard<std::mutex> lock(gStackBufferMutex);
+    auto it = oldest();
+    if (it == gStackBuffers.end()) {
+      return false;
+    }
+    tick = it->lastUse;
+    return true;
+  }
+
+  size_t EvictOldest() override {
+    std::lock_guard<std::mutex> lock(gStackBufferMutex);
+    auto it = oldest();
+    return it != gStackBuffers.end() ? erase(it) : 0;
+  }
+
+  void Purge() override {
+    std::lock_guard<std::mutex> lock(gStackBufferMutex);
+    while (!gStackBuffers.empty()) {
+      erase(gStackBuffers.begin());
+    }
+  }
+
+private:
+  static std::vector<StackBuffer>::iterator oldest() {
+    return std::min_element(gStackBuffers.begin(), gStackBuffers.end(),
+                            [](const StackBuffer &a, const StackBuffer &b) {
+                              return a.lastUse < b.lastUse;
+                            });
+  }
+
+  static size_t erase(std::vector<StackBuffer>::iterator it) {
+    const size_t bytes = it->bytes;
+    [it->buffer release];
+    gStackBuffers.erase(it);
+    CacheBudget::Shared().Release(bytes);
+    return bytes;
+  }
+};
+
+// +1 buffer for `key`, or nil.
+id<MTLBuffer> findStackBuffer(const StackBufferKey &key) {
+  std::lock_guard<std::mutex> lock(gStackBufferMutex);
+  for (StackBuffer &entry : gStackBuffers) {
+    if (entry.key == key) {
+      entry.lastUse = CacheBudget::Shared().Tick();
+      return [entry.buffer retain];
+    }
+  }
+  return nil;
+}
+
+void cacheStackBuffer(StackBuffer entry) {
+  static StackBufferCache cache;
+  static std::once_flag registered;
+  std::call_once(registered,
+                 [] { CacheBudget::Shared().Register(&cache); });
+  [entry.buffer retain];
+  entry.lastUse = CacheBudget::Shared().Tick();
+  CacheBudget::Shared().Charge(entry.bytes);
+  {
+    std::lock_guard<std::mutex> lock(gStackBufferMutex);
+    gStackBuffers.push_back(std::move(entry));
+  }
+  CacheBudget::Shared().Enforce();
+}
+
+// `stackBuffer` is filled when a layer uses a user LUT, which is not in
+// gLUTCacheBuffer: every layer is then copied into a stack buffer, reused
+// while the stack stays the same, and the offsets point into it. Trims and
+// transitions exist only in the baked composite, so such a stack is that one
+// lattice.
 void buildLayers(const ParamsSnapshot &p, std::array<LayerInfo, 4> &layers,
-                 uint32_t &count) {
+                 uint32_t &count, ScopedBuffer &stackBuffer) {
   count = 0;
-  auto add = [&](const LayerParams &lp, const LUT3D *table, int n,
+  std::array<const LUT3D *, 4> luts{};
+  // Keep user LUTs readable until they are copied below.
+  std::array<std::shared_ptr<const void>, 4> owners;
+  bool needsStackBuffer = false;
+  const ResolvedStack stack = ResolveStack(p);
+  std::shared_ptr<const CompositeLUT> composite =
+      stack.Trimmed() || stack.to ? AcquireDenseComposite(stack) : nullptr;
+  LUT3D compositeView{nullptr, 0};
+  if (composite) {
+    compositeView = composite->view();
+    LayerInfo info{};
+    info.dim = static_cast<uint32_t>(compositeView.dimension);
+    info.scale = static_cast<float>(compositeView.dimension - 1);
+    info.shaperSize = compositeView.shaper
+                          ? static_cast<uint32_t>(compositeView.shaperSize)
+                          : 0;
+    info.intensity = 1.f;
+    luts[count] = &compositeView;
+    layers[count++] = info;
+    needsStackBuffer = true;
+  }
+  auto add = [&](const LayerParams &lp, LUTTable table,
                  const std::vector<uint32_t> &offsets) {
-    if (!lp.enabled || lp.lutIndex < 0 || lp.lutIndex >= n ||
-        lp.intensity <= 0.0001f) {
+    if (!lp.enabled || lp.intensity <= 0.0001f) {
+      return;
+    }
+    const LUT3D *lut =
+        LUTLibrary::Shared().Get(table, lp.lutIndex, nullptr, &owners[count]);
+    if (!lut) {
       return;
     }
-    const LUT3D &lut = table[lp.lutIndex];
+    const bool embedded = lp.lutIndex < static_cast<int>(offsets.size());
+    needsStackBuffer = needsStackBuffer || !embedded;
     LayerInfo info{};
-    info.offset = offsets[lp.lutIndex];
-    info.dim = static_cast<uint32_t>(lut.dimension);
-    info.scale = static_cast<float>(lut.dimension - 1);
+    info.offset = embedded ? offsets[lp.lutIndex] : 0;
+    info.dim = static_cast<uint32_t>(lut->dimension);
+    info.scale = static_cast<float>(lut->dimension - 1);
+    info.shaperSize = lut->shaper ? static_cast<uint32_t>(lut->shaperSize) : 0;
     info.intensity =
         lp.intensity < 0.f ? 0.f : (lp.intensity > 1.f ? 1.f : lp.intensity);
+    luts[count] = lut;
     layers[count++] = info;
   };
-  add(p.logConvert, kLogLUTs, kLogLUTCount, gLogLUTOffsets);
-  add(p.creative, kRec709LUTs, kRec709LUTCount, gRec709LUTOffsets);
-  add(p.secondary, kRec709LUTs, kRec709LUTCount, gRec709LUTOffsets);
-  add(p.accent, kRec709LUTs, kRec709LUTCount, gRec709LUTOffsets);
+  if (!composite) {
+    add(p.logConvert, LUTTable::kLog, gLogLUTOffsets);
+    add(p.creative, LUTTable::kRec709, gRec709LUTOffsets);
+    add(p.secondary, LUTTable::kRec709, gRec709LUTOffsets);
+    add(p.accent, LUTTable::kRec709, gRec709LUTOffsets);
+  }
+
+  if (!needsStackBuffer) {
+    return;
+  }
+  StackBufferKey key;
+  key.count = count;
+  size_t floats = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    const LUT3D &lut = *luts[i];
+    key.data[i] = lut.data;
+    key.dims[i] = lut.dimension;
+    layers[i].offset = static_cast<uint32_t>(floats);
+    floats +=
+        static_cast<size_t>(lut.dimension) * lut.dimension * lut.dimension * 3 +
+        (lut.shaper ? lut.shaperSize * 3 : 0);
+  }
+  stackBuffer.buffer = findStackBuffer(key);
+  if (stackBuffer.buffer) {
+    return;
+  }
+
+  std::vector<float> data;
+  data.reserve(floats);
+  for (uint32_t i = 0; i < count; ++i) {
+    const LUT3D &lut = *luts[i];
+    const size_t n =
+        static_cast<size_t>(lut.dimension) * lut.dimension * lut.dimension * 3;
+    const size_t shaperValues = lut.shaper ? lut.shaperSize * 3 : 0;
+    data.insert(data.end(), lut.data, lut.data + n);
+    data.insert(data.end(), lut.shaper, lut.shaper + shaperValues);
+  }
+  stackBuffer.buffer =
+      [gDevice newBufferWithBytes:data.data()
+                           length:data.size() * sizeof(float)
+                          options:MTLResourceStorageModeShared];
+  if (stackBuffer.buffer) {
+    StackBuffer entry;
+    entry.key = key;
+    entry.buffer = stackBuffer.buffer;
+    entry.bytes = data.size() * sizeof(float);
+    entry.composite = composite;
+    entry.owners = owners;
+    cacheStackBuffer(std::move(entry));
+  }
 }
 
 } // namespace
@@ -337,12 +552,16 @@ bool TryDispatchNative(const ParamsSnapshot &params, const FrameDesc &src,
 
       std::array<LayerInfo, 4> layers{};
       uint32_t layerCount = 0;
-      buildLayers(params, layers, layerCount);
+      ScopedBuffer stackBuffer;
+      buildLayers(params, layers, layerCount, stackBuffer);
+      id<MTLBuffer> lutBuffer =
+          stackBuffer.buffer ? stackBuffer.buffer : gLUTCacheBuffer;
 
       const MetalParams p{static_cast<uint32_t>(src.width),
                           static_cast<uint32_t>(src.height),
                           static_cast<uint32_t>(src.rowBytes),
-                          static_cast<uint32_t>(dst.rowBytes), layerCount};
+                          static_cast<uint32_t>(dst.rowBytes), layerCount,
+                          params.alphaMode == AlphaMode::kPremultiplied};
 
       id<MTLCommandBuffer> cb = [q commandBuffer];
       id<MTLComputeCommandEncoder> enc = [cb computeCommandEncoder];
@@ -353,7 +572,7 @@ bool TryDispatchNative(const ParamsSnapshot &params, const FrameDesc &src,
       [enc setBytes:&p length:sizeof(MetalParams) atIndex:2];
 
       if (layerCount > 0) {
-        if (!gLUTCacheBuffer) {
+        if (!lutBuffer) {
           if (reason)
             *reason = "lut_cache_missing";
           return false;
@@ -361,7 +580,7 @@ bool TryDispatchNative(const ParamsSnapshot &params, const FrameDesc &src,
         [enc setBytes:layers.data()
                length:sizeof(LayerInfo) * layerCount
               atIndex:3];
-        [enc setBuffer:gLUTCacheBuffer offset:0 atIndex:4];
+        [enc setBuffer:lutBuffer offset:0 atIndex:4];
       }
 
       MTLSize grid = MTLSizeMake(p.width, p.height, 1);
@@ -470,12 +689,16 @@ bool TryDispatchNativeBuffers(const ParamsSnapshot &params,
 
       std::array<LayerInfo, 4> layers{};
       uint32_t layerCount = 0;
-      buildLayers(params, layers, layerCount);
+      ScopedBuffer stackBuffer;
+      buildLayers(params, layers, layerCount, stackBuffer);
+      id<MTLBuffer> lutBuffer =
+          stackBuffer.buffer ? stackBuffer.buffer : gLUTCacheBuffer;
 
       const MetalParams p{static_cast<uint32_t>(width),
                           static_cast<uint32_t>(height),
                           static_cast<uint32_t>(srcRowBytes),
-                          static_cast<uint32_t>(dstRowBytes), layerCount};
+                          static_cast<uint32_t>(dstRowBytes), layerCount,
+                          params.alphaMode == AlphaMode::kPremultiplied};
 
       id<MTLBuffer> pbuf =
           [gDevice newBufferWithBytes:&p
@@ -496,7 +719,7 @@ bool TryDispatchNativeBuffers(const ParamsSnapshot &params,
       [enc setBytes:&p length:sizeof(MetalParams) atIndex:2];
 
       if (layerCount > 0) {
-        if (!gLUTCacheBuffer) {
+        if (!lutBuffer) {
           if (reason)
             *reason = "lut_cache_missing";
           return false;
@@ -504,7 +727,7 @@ bool TryDispatchNativeBuffers(const ParamsSnapshot &params,
         [enc setBytes:layers.data()
                length:sizeof(LayerInfo) * layerCount
               atIndex:3];
-        [enc setBuffer:gLUTCacheBuffer offset:0 atIndex:4];
+        [enc setBuffer:lutBuffer offset:0 atIndex:4];
       }
 
       MTLSize grid = MTLSizeMake(p.width, p.height, 1);
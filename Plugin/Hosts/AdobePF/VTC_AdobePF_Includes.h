@@ -3,6 +3,7 @@
 #include "AEConfig.h"
 #include "AE_Effect.h"
 #include "AE_EffectCB.h"
+#include "AE_EffectSuites.h"
 #include "AE_EffectPixelFormat.h"
 #include "Param_Utils.h"
 #include "AE_Macros.h"
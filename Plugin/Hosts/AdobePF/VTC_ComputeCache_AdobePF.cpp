@@ -0,0 +1,146 @@
+#include "VTC_ComputeCache_AdobePF.h"
+
+#include "AE_ComputeCacheSuite.h"
+
+#include "../../Core/VTC_AdaptiveLUT.h"
+
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace vtc {
+namespace pf {
+
+namespace {
+
+constexpr const char* kComputeClassId = "com.vtc.looks.composite.v1";
+
+static_assert(sizeof(ComputeKey) == sizeof(AEGP_CCComputeKey), "ComputeKey must fill the AE cache key");
+
+// Opaque options handed to the host; only valid during the checkout call.
+struct ComputeOptions {
+    const ParamsSnapshot* params;
+    int dimension;
+    ComputeKey key;
+};
+
+// The host owns one of these per entry. Renders copy the shared_ptr out, so
+// a purge never frees a lattice mid-frame.
+using CachedComposite = std::shared_ptr<const CompositeLUT>;
+
+A_Err generateKey(AEGP_CCComputeOptionsRefconP optionsP, AEGP_CCComputeKeyP out_keyP) {
+    const ComputeOptions* options = static_cast<const ComputeOptions*>(optionsP);
+    std::memcpy(out_keyP, &options->key, sizeof(*out_keyP));
+    return A_Err_NONE;
+}
+
+A_Err compute(AEGP_CCComputeOptionsRefconP optionsP, AEGP_CCComputeValueRefconP* out_valuePP) {
+    const ComputeOptions* options = static_cast<const ComputeOptions*>(optionsP);
+    // A C callback: nothing may unwind into the host.
+    try {
+        *out_valuePP = new CachedComposite(ComputeComposite(*options->params, options->dimension));
+    } catch (const std::bad_alloc&) {
+        return A_Err_ALLOC;
+    } catch (...) {
+        return A_Err_GENERIC;
+    }
+    return A_Err_NONE;
+}
+
+size_t approxSizeValue(AEGP_CCComputeValueRefconP valueP) {
+    const CachedComposite& value = *static_cast<const CachedComposite*>(valueP);
+    if (!value) return sizeof(value);
+    return sizeof(value) + (value->data.size() + value->shaper.size()) * sizeof(float) +
+           (value->adaptive ? value->adaptive->Bytes() : 0);
+}
+
+void deleteComputeValue(AEGP_CCComputeValueRefconP valueP) {
+    delete static_cast<CachedComposite*>(valueP);
+}
+
+const AEGP_ComputeCacheCallbacks kCallbacks = {
+    generateKey,
+    compute,
+    approxSizeValue,
+    deleteComputeValue,
+};
+
+class HostComputeCache final : public ComputeCache {
+public:
+    explicit HostComputeCache(const AEGP_ComputeCacheSuite1* suite) : suite_(suite) {}
+
+    std::shared_ptr<const CompositeLUT> AcquireComposite(const ParamsSnapshot& params, int dimension) override {
+        ComputeOptions options{&params, dimension, MakeComputeKey(params, dimension)};
+        AEGP_CCCheckoutReceiptP receipt = nullptr;
+        // One value per render call: let the host make us wait for a bake
+        // another thread already started.
+        if (suite_->AEGP_ComputeIfNeededAndCheckout(kComputeClassId, &options, true, &receipt) != A_Err_NONE ||
+            !receipt) {
+            return ComputeComposite(params, dimension);
+        }
+        CachedComposite result;
+        AEGP_CCComputeValueRefconP value = nullptr;
+        if (suite_->AEGP_GetReceiptComputeValue(receipt, &value) == A_Err_NONE && value) {
+            result = *static_cast<const CachedComposite*>(value);
+        }
+        suite_->AEGP_CheckinComputeReceipt(receipt);
+        return result;
+    }
+
+private:
+    const AEGP_ComputeCacheSuite1* suite_;
+};
+
+std::mutex g_setupMutex;
+SPBasicSuite* g_basic = nullptr;
+const AEGP_ComputeCacheSuite1* g_suite = nullptr;
+HostComputeCache* g_hostCache = nullptr;
+
+InProcessComputeCache& inProcessCache() {
+    static InProcessComputeCache cache;
+    return cache;
+}
+
+}  // namespace
+
+void SetupComputeCache(PF_InData* in_data) {
+    std::lock_guard<std::mutex> lock(g_setupMutex);
+    if (g_hostCache || !in_data || !in_data->pica_basicP) return;
+
+    const void* suite = nullptr;
+    if (in_data->pica_basicP->AcquireSuite(kAEGPComputeCacheSuite, kAEGPComputeCacheSuiteVersion1, &suite) !=
+            kSPNoError ||
+        !suite) {
+        return;
+    }
+    g_basic = in_data->pica_basicP;
+    g_suite = static_cast<const AEGP_ComputeCacheSuite1*>(suite);
+    if (g_suite->AEGP_ClassRegister(kComputeClassId, &kCallbacks) != A_Err_NONE) {
+        g_basic->ReleaseSuite(kAEGPComputeCacheSuite, kAEGPComputeCacheSuiteVersion1);
+        g_basic = nullptr;
+        g_suite = nullptr;
+        return;
+    }
+    g_hostCache = new HostComputeCache(g_suite);
+}
+
+void SetdownComputeCache() {
+    std::lock_guard<std::mutex> lock(g_setupMutex);
+    if (!g_hostCache) return;
+    // Purges every value through deleteComputeValue.
+    g_suite->AEGP_ClassUnregister(kComputeClassId);
+    g_basic->ReleaseSuite(kAEGPComputeCacheSuite, kAEGPComputeCacheSuiteVersion1);
+    delete g_hostCache;
+    g_hostCache = nullptr;
+    g_suite = nullptr;
+    g_basic = nullptr;
+}
+
+ComputeCache* SharedComputeCache() {
+    std::lock_guard<std::mutex> lock(g_setupMutex);
+    if (g_hostCache) return g_hostCache;
+    return &inProcessCache();
+}
+
+}  // namespace pf
+}  // namespace vtc
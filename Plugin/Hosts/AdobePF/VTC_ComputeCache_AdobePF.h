@@ -0,0 +1,18 @@
+#pragma once
+
+#include "VTC_AdobePF_Includes.h"
+#include "../../Core/VTC_ComputeCache.h"
+
+namespace vtc {
+namespace pf {
+
+// Registers the composite compute class with AE's compute cache (AE 18.2+)
+// so render threads and render processes share one bake. Hosts without the
+// suite get an InProcessComputeCache. Call from GLOBAL_SETUP/SETDOWN.
+void SetupComputeCache(PF_InData* in_data);
+void SetdownComputeCache();
+
+ComputeCache* SharedComputeCache();
+
+}  // namespace pf
+}  // namespace vtc
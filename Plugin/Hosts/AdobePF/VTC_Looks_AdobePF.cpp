@@ -1,10 +1,23 @@
 #include "VTC_AdobePF_Includes.h"
 
+#include "AE_GeneralPlug.h"
+
+#include "../../Core/VTC_CacheBudget.h"
+#include "../../Core/VTC_LUTLibrary.h"
 #include "../../Core/VTC_LUTSampling.h"
+#include "../../Core/VTC_Prefetch.h"
+#include "../../Core/VTC_ProgressiveBake.h"
+#include "../../Core/VTC_SequencePrebake.h"
 #include "../../Shared/VTC_LUTData.h"
+#include "VTC_ComputeCache_AdobePF.h"
 #include "VTC_FrameMap_AdobePF.h"
 #include "VTC_ParamMap_AdobePF.h"
 
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 namespace vtc {
 namespace pf {
 
@@ -12,27 +25,188 @@ namespace pf {
 
 struct GroupIDs {
     ParamID look, next, prev, selected;
-    int lutCount;
+    LUTTable table;
 };
 
 static const GroupIDs kGroups[] = {
-    { kParam_LogLook,       kParam_LogNext,       kParam_LogPrev,       kParam_LogSelected,       kLogLUTCount },
-    { kParam_CreativeLook,  kParam_CreativeNext,  kParam_CreativePrev,  kParam_CreativeSelected,  kRec709LUTCount },
-    { kParam_SecondaryLook, kParam_SecondaryNext, kParam_SecondaryPrev, kParam_SecondarySelected, kRec709LUTCount },
-    { kParam_AccentLook,    kParam_AccentNext,    kParam_AccentPrev,    kParam_AccentSelected,    kRec709LUTCount },
+    { kParam_LogLook,       kParam_LogNext,       kParam_LogPrev,       kParam_LogSelected,       LUTTable::kLog },
+    { kParam_CreativeLook,  kParam_CreativeNext,  kParam_CreativePrev,  kParam_CreativeSelected,  LUTTable::kRec709 },
+    { kParam_SecondaryLook, kParam_SecondaryNext, kParam_SecondaryPrev, kParam_SecondarySelected, LUTTable::kRec709 },
+    { kParam_AccentLook,    kParam_AccentNext,    kParam_AccentPrev,    kParam_AccentSelected,    LUTTable::kRec709 },
 };
 constexpr int kGroupCount = 4;
 
+// Background queue key of an instance's prefetch and prebake tasks, so one
+// instance replacing its own leaves the others' queued.
+static std::uint64_t InstanceKey(PF_ProgPtr effect_ref) {
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(effect_ref));
+}
+
+// ── Refine redraw ──
+
+// A viewer showing a draft frame keeps it until AE asks for a render again,
+// which it only does when something invalidates the frame. A stack picked in
+// the Effect Controls is therefore watched until its full composite lands;
+// then an idle hook calls the effect with PF_Cmd_COMPLETELY_GENERAL, which
+// answers PF_OutFlag_FORCE_RERENDER.
+
+struct RefineWatch {
+    AEGP_EffectRefH effect = nullptr;
+    ResolvedStack stack;
+};
+
+struct RefineRedraw {
+    std::mutex mutex;
+    SPBasicSuite* basic = nullptr;
+    AEGP_PluginID plugin = 0;
+    const AEGP_UtilitySuite6* utility = nullptr;
+    const AEGP_PFInterfaceSuite1* pfInterface = nullptr;
+    const AEGP_EffectSuite4* effects = nullptr;
+    std::unordered_map<PF_ProgPtr, RefineWatch> watches;  // by the UI thread's effect_ref
+};
+static RefineRedraw g_redraw;
+
+// extra of our own PF_Cmd_COMPLETELY_GENERAL calls.
+static const char kRedrawTag = 0;
+
+// Background queue thread. AEGP_CauseIdleRoutinesToBeCalled is thread-safe.
+static void OnCompositeRefined(const ResolvedStack& stack) {
+    (void)stack;
+    std::lock_guard<std::mutex> lock(g_redraw.mutex);
+    if (g_redraw.utility) {
+        g_redraw.utility->AEGP_CauseIdleRoutinesToBeCalled();
+    }
+}
+
+static A_Err RedrawIdleHook(AEGP_GlobalRefcon plugin_refconP, AEGP_IdleRefcon refconP, A_long* max_sleepPL) {
+    (void)plugin_refconP; (void)refconP; (void)max_sleepPL;
+    std::lock_guard<std::mutex> lock(g_redraw.mutex);
+    if (!g_redraw.effects) return A_Err_NONE;
+    const A_Time time = {0, 1};
+    for (auto it = g_redraw.watches.begin(); it != g_redraw.watches.end();) {
+        if (!IsFullCompositeReady(it->second.stack)) {
+            ++it;
+            continue;
+        }
+        g_redraw.effects->AEGP_EffectCallGeneric(g_redraw.plugin, it->second.effect, &time,
+                                                 PF_Cmd_COMPLETELY_GENERAL, const_cast<char*>(&kRedrawTag));
+        g_redraw.effects->AEGP_DisposeEffect(it->second.effect);
+        it = g_redraw.watches.erase(it);
+    }
+    return A_Err_NONE;
+}
+
+// GLOBAL_SETUP. Without the AEGP suites a paused draft stays until the next
+// render request, as before.
+static void SetupRefineRedraw(PF_InData* in_data) {
+    std::lock_guard<std::mutex> lock(g_redraw.mutex);
+    SPBasicSuite* basic = in_data->pica_basicP;
+    if (g_redraw.basic || !basic) return;
+    const void* utility = nullptr;
+    const void* pfInterface = nullptr;
+    const void* effects = nullptr;
+    const void* reg = nullptr;
+    basic->AcquireSuite(kAEGPUtilitySuite, kAEGPUtilitySuiteVersion6, &utility);
+    basic->AcquireSuite(kAEGPPFInterfaceSuite, kAEGPPFInterfaceSuiteVersion1, &pfInterface);
+    basic->AcquireSuite(kAEGPEffectSuite, kAEGPEffectSuiteVersion4, &effects);
+    basic->AcquireSuite(kAEGPRegisterSuite, kAEGPRegisterSuiteVersion5, &reg);
+    g_redraw.basic = basic;
+    g_redraw.utility = static_cast<const AEGP_UtilitySuite6*>(utility);
+    g_redraw.pfInterface = static_cast<const AEGP_PFInterfaceSuite1*>(pfInterface);
+    g_redraw.effects = static_cast<const AEGP_EffectSuite4*>(effects);
+    const AEGP_RegisterSuite5* registerSuite = static_cast<const AEGP_RegisterSuite5*>(reg);
+    const bool ok = g_redraw.utility && g_redraw.pfInterface && g_redraw.effects && registerSuite &&
+                    g_redraw.utility->AEGP_RegisterWithAEGP(nullptr, "VTC Looks", &g_redraw.plugin) == A_Err_NONE &&
+                    registerSuite->AEGP_RegisterIdleHook(g_redraw.plugin, RedrawIdleHook, nullptr) == A_Err_NONE;
+    if (reg) basic->ReleaseSuite(kAEGPRegisterSuite, kAEGPRegisterSuiteVersion5);
+    if (!ok) {
+        if (utility) basic->ReleaseSuite(kAEGPUtilitySuite, kAEGPUtilitySuiteVersion6);
+        if (pfInterface) basic->ReleaseSuite(kAEGPPFInterfaceSuite, kAEGPPFInterfaceSuiteVersion1);
+        if (effects) basic->ReleaseSuite(kAEGPEffectSuite, kAEGPEffectSuiteVersion4);
+        g_redraw.basic = nullptr;
+        g_redraw.utility = nullptr;
+        g_redraw.pfInterface = nullptr;
+        g_redraw.effects = nullptr;
+        return;
+    }
+    SetCompositeRefinedListener(OnCompositeRefined);
+}
+
+// GLOBAL_SETDOWN. AE has no way to remove an idle hook; it finds no suites.
+static void SetdownRefineRedraw() {
+    SetCompositeRefinedListener(nullptr);
+    std::lock_guard<std::mutex> lock(g_redraw.mutex);
+    if (!g_redraw.basic) return;
+    for (auto& entry : g_redraw.watches) {
+        g_redraw.effects->AEGP_DisposeEffect(entry.second.effect);
+    }
+    g_redraw.watches.clear();
+    g_redraw.basic->ReleaseSuite(kAEGPUtilitySuite, kAEGPUtilitySuiteVersion6);
+    g_redraw.basic->ReleaseSuite(kAEGPPFInterfaceSuite, kAEGPPFInterfaceSuiteVersion1);
+    g_redraw.basic->ReleaseSuite(kAEGPEffectSuite, kAEGPEffectSuiteVersion4);
+    g_redraw.basic = nullptr;
+    g_redraw.utility = nullptr;
+    g_redraw.pfInterface = nullptr;
+    g_redraw.effects = nullptr;
+}
+
+// UI thread: redraw this instance once `stack` has its full composite.
+// Replaces what the instance watched before.
+static void WatchRefine(PF_InData* in_data, const ResolvedStack& stack) {
+    if (IsFullCompositeReady(stack)) return;
+    std::lock_guard<std::mutex> lock(g_redraw.mutex);
+    if (!g_redraw.pfInterface) return;
+    RefineWatch& watch = g_redraw.watches[in_data->effect_ref];
+    if (!watch.effect &&
+        g_redraw.pfInterface->AEGP_GetNewEffectForEffect(g_redraw.plugin, in_data->effect_ref, &watch.effect) !=
+            A_Err_NONE) {
+        g_redraw.watches.erase(in_data->effect_ref);
+        return;
+    }
+    watch.stack = stack;
+}
+
+// SEQUENCE_SETDOWN: the instance is going away.
+static void ForgetRefineWatch(PF_ProgPtr effect_ref) {
+    std::lock_guard<std::mutex> lock(g_redraw.mutex);
+    auto it = g_redraw.watches.find(effect_ref);
+    if (it == g_redraw.watches.end()) return;
+    g_redraw.effects->AEGP_DisposeEffect(it->second.effect);
+    g_redraw.watches.erase(it);
+}
+
+// Start baking the new stack before the host asks for the first frame, then
+// the stacks one Next/Prev away in group `g` (kGroups order = LayerSlot).
+static void PrepareStack(PF_InData* in_data, PF_ParamDef* params[], int g) {
+    const ParamsSnapshot snap = ReadParams(const_cast<const PF_ParamDef* const*>(params));
+    const ResolvedStack stack = ResolveStack(snap);
+    ScheduleCompositeRefine(stack);
+    WatchRefine(in_data, stack);
+    PrefetchNeighbourLooks(snap, static_cast<LayerSlot>(g), params[kGroups[g].look]->u.pd.num_choices - 1,
+                           InstanceKey(in_data->effect_ref));
+}
+
+// Draft quality is the only interactive signal AE gives an effect; Best
+// quality renders (including the render queue default) always bake fully.
+static RenderHints HintsFor(const PF_InData* in_data) {
+    RenderHints hints;
+    hints.interactive = in_data->quality == PF_Quality_LO;
+    hints.cache = SharedComputeCache();
+    return hints;
+}
+
 static PF_Err HandleParamChange(PF_InData* in_data, PF_OutData* out_data,
                                 PF_ParamDef* params[],
                                 PF_UserChangedParamExtra* ucp) {
-    (void)in_data; (void)out_data;
+    (void)out_data;
     PF_Err err = PF_Err_NONE;
     const int changed = ucp->param_index;
 
     for (int g = 0; g < kGroupCount; ++g) {
         const GroupIDs& gid = kGroups[g];
-        const int maxVal = gid.lutCount + 1;
+        // The popup's length as registered at PARAMS_SETUP; LUTs added
+        // since have no entry to step to.
+        const int maxVal = params[gid.look]->u.pd.num_choices;
 
         if (changed == gid.next) {
             int cur = params[gid.look]->u.pd.value;
@@ -41,6 +215,7 @@ static PF_Err HandleParamChange(PF_InData* in_data, PF_OutData* out_data,
             params[gid.look]->uu.change_flags = PF_ChangeFlag_CHANGED_VALUE;
             params[gid.selected]->u.pd.value = nxt;
             params[gid.selected]->uu.change_flags = PF_ChangeFlag_CHANGED_VALUE;
+            PrepareStack(in_data, params, g);
             return err;
         }
         if (changed == gid.prev) {
@@ -50,11 +225,13 @@ static PF_Err HandleParamChange(PF_InData* in_data, PF_OutData* out_data,
             params[gid.look]->uu.change_flags = PF_ChangeFlag_CHANGED_VALUE;
             params[gid.selected]->u.pd.value = prv;
             params[gid.selected]->uu.change_flags = PF_ChangeFlag_CHANGED_VALUE;
+            PrepareStack(in_data, params, g);
             return err;
         }
         if (changed == gid.look) {
             params[gid.selected]->u.pd.value = params[gid.look]->u.pd.value;
             params[gid.selected]->uu.change_flags = PF_ChangeFlag_CHANGED_VALUE;
+            PrepareStack(in_data, params, g);
             return err;
         }
 
@@ -72,43 +249,220 @@ static PF_Err Render(PF_InData* in_data, PF_OutData* out_data,
     err = (err == PF_Err_NONE) ? MapWorldToFrame(output, &dst) : err;
     if (err != PF_Err_NONE) return err;
     const ParamsSnapshot snap = ReadParams(const_cast<const PF_ParamDef* const*>(params));
-    ProcessFrameCPU(snap, src, dst);
+    ProcessFrameCPU(snap, src, dst, HintsFor(in_data));
     return PF_Err_NONE;
 }
 
-static LayerParams CheckoutLayer(PF_InData* in_data,
+static LayerParams CheckoutLayer(PF_InData* in_data, A_long time,
                                  ParamID enableId, ParamID lookId, ParamID intensityId) {
     LayerParams lp;
     PF_ParamDef def;
 
     AEFX_CLR_STRUCT(def);
-    if (PF_CHECKOUT_PARAM(in_data, enableId, in_data->current_time,
-                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE)
+    if (PF_CHECKOUT_PARAM(in_data, enableId, time,
+                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE) {
         lp.enabled = def.u.bd.value != 0;
+        PF_CHECKIN_PARAM(in_data, &def);
+    }
 
     AEFX_CLR_STRUCT(def);
-    if (PF_CHECKOUT_PARAM(in_data, lookId, in_data->current_time,
+    if (PF_CHECKOUT_PARAM(in_data, lookId, time,
                           in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE) {
         const int pv = def.u.pd.value;
         lp.lutIndex = (pv > 1) ? (pv - 2) : -1;
+        PF_CHECKIN_PARAM(in_data, &def);
     }
 
     AEFX_CLR_STRUCT(def);
-    if (PF_CHECKOUT_PARAM(in_data, intensityId, in_data->current_time,
-                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE)
+    if (PF_CHECKOUT_PARAM(in_data, intensityId, time,
+                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE) {
         lp.intensity = static_cast<float>(def.u.fs_d.value) / 100.0f;
+        PF_CHECKIN_PARAM(in_data, &def);
+    }
 
     return lp;
 }
 
-static PF_Err ReadParamsForCurrentFrame(PF_InData* in_data, ParamsSnapshot& out_snap) {
-    out_snap.logConvert = CheckoutLayer(in_data, kParam_LogEnable,      kParam_LogLook,       kParam_LogIntensity);
-    out_snap.creative   = CheckoutLayer(in_data, kParam_CreativeEnable,  kParam_CreativeLook,  kParam_CreativeIntensity);
-    out_snap.secondary  = CheckoutLayer(in_data, kParam_SecondaryEnable, kParam_SecondaryLook, kParam_SecondaryIntensity);
-    out_snap.accent     = CheckoutLayer(in_data, kParam_AccentEnable,    kParam_AccentLook,    kParam_AccentIntensity);
+// `fallback` when the checkout fails.
+static float CheckoutFloat(PF_InData* in_data, A_long time, ParamID id, float fallback) {
+    PF_ParamDef def;
+    AEFX_CLR_STRUCT(def);
+    if (PF_CHECKOUT_PARAM(in_data, id, time,
+                          in_data->time_step, in_data->time_scale, &def) != PF_Err_NONE) {
+        return fallback;
+    }
+    const float value = static_cast<float>(def.u.fs_d.value);
+    PF_CHECKIN_PARAM(in_data, &def);
+    return value;
+}
+
+static TrimParams CheckoutTrim(PF_InData* in_data, A_long time) {
+    TrimParams trim;
+    trim.exposure         = CheckoutFloat(in_data, time, kParam_TrimExposure, 0.0f);
+    trim.temperature      = CheckoutFloat(in_data, time, kParam_TrimTemperature, 0.0f);
+    trim.tint             = CheckoutFloat(in_data, time, kParam_TrimTint, 0.0f);
+    trim.saturation       = CheckoutFloat(in_data, time, kParam_TrimSaturation, 100.0f) / 100.0f;
+    trim.outputGain       = CheckoutFloat(in_data, time, kParam_TrimOutputGain, 100.0f) / 100.0f;
+    trim.outputSaturation = CheckoutFloat(in_data, time, kParam_TrimOutputSaturation, 100.0f) / 100.0f;
+    return trim;
+}
+
+static AlphaMode CheckoutAlphaMode(PF_InData* in_data, A_long time) {
+    PF_ParamDef def;
+    AEFX_CLR_STRUCT(def);
+    AlphaMode mode = AlphaMode::kStraight;
+    if (PF_CHECKOUT_PARAM(in_data, kParam_AlphaMode, time,
+                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE) {
+        if (def.u.pd.value == 2) mode = AlphaMode::kPremultiplied;
+        PF_CHECKIN_PARAM(in_data, &def);
+    }
+    return mode;
+}
+
+static TransitionParams CheckoutTransition(PF_InData* in_data, A_long time) {
+    TransitionParams transition;
+    PF_ParamDef def;
+
+    AEFX_CLR_STRUCT(def);
+    if (PF_CHECKOUT_PARAM(in_data, kParam_TransitionEnable, time,
+                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE) {
+        transition.enabled = def.u.bd.value != 0;
+        PF_CHECKIN_PARAM(in_data, &def);
+    }
+
+    AEFX_CLR_STRUCT(def);
+    if (PF_CHECKOUT_PARAM(in_data, kParam_TransitionLook, time,
+                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE) {
+        const int pv = def.u.pd.value;
+        transition.toLutIndex = (pv > 1) ? (pv - 2) : -1;
+        PF_CHECKIN_PARAM(in_data, &def);
+    }
+
+    transition.mix = CheckoutFloat(in_data, time, kParam_TransitionMix, 0.0f) / 100.0f;
+    return transition;
+}
+
+static PF_Err ReadParamsAtTime(PF_InData* in_data, A_long time, ParamsSnapshot& out_snap) {
+    out_snap.logConvert = CheckoutLayer(in_data, time, kParam_LogEnable,      kParam_LogLook,       kParam_LogIntensity);
+    out_snap.creative   = CheckoutLayer(in_data, time, kParam_CreativeEnable,  kParam_CreativeLook,  kParam_CreativeIntensity);
+    out_snap.secondary  = CheckoutLayer(in_data, time, kParam_SecondaryEnable, kParam_SecondaryLook, kParam_SecondaryIntensity);
+    out_snap.accent     = CheckoutLayer(in_data, time, kParam_AccentEnable,    kParam_AccentLook,    kParam_AccentIntensity);
+    out_snap.trim       = CheckoutTrim(in_data, time);
+    out_snap.alphaMode  = CheckoutAlphaMode(in_data, time);
+    out_snap.transition = CheckoutTransition(in_data, time);
     return PF_Err_NONE;
 }
 
+static PF_Err ReadParamsForCurrentFrame(PF_InData* in_data, ParamsSnapshot& out_snap) {
+    return ReadParamsAtTime(in_data, in_data->current_time, out_snap);
+}
+
+// ── Sequence pre-bake ──
+
+// AE never announces an export range; a Best-quality pre-render of the frame
+// right after the previous one marks a sequential render. From there we bake
+// the stacks of the next window of frames ahead of the render threads.
+constexpr A_long kPrebakeWindowFrames = 48;
+
+// Per instance, so instances rendered interleaved (several in one comp, or
+// several comps) each keep their own run.
+struct SequenceState {
+    A_long lastTime = 0;
+    A_long prebakedUntil = 0;
+};
+static std::mutex g_sequenceMutex;
+static std::unordered_map<PF_ProgPtr, SequenceState> g_sequences;  // by effect_ref
+
+// Key times of the stack params in [first, last]; true if an intensity, a
+// trim or the transition mix interpolates there.
+static bool CollectStackKeyTimes(PF_InData* in_data, A_long first, A_long last,
+                                 std::vector<double>& keyTimes) {
+    static const ParamID kStackParams[] = {
+        kParam_LogEnable,       kParam_LogLook,       kParam_LogIntensity,
+        kParam_CreativeEnable,  kParam_CreativeLook,  kParam_CreativeIntensity,
+        kParam_SecondaryEnable, kParam_SecondaryLook, kParam_SecondaryIntensity,
+        kParam_AccentEnable,    kParam_AccentLook,    kParam_AccentIntensity,
+        kParam_TrimExposure,    kParam_TrimTemperature, kParam_TrimTint,
+        kParam_TrimSaturation,  kParam_TrimOutputGain,  kParam_TrimOutputSaturation,
+        kParam_TransitionEnable, kParam_TransitionLook, kParam_TransitionMix,
+    };
+    const PF_ParamUtilsSuite3* utils = nullptr;
+    if (!in_data->pica_basicP ||
+        in_data->pica_basicP->AcquireSuite(kPFParamUtilsSuite, kPFParamUtilsSuiteVersion3,
+                                           reinterpret_cast<const void**>(&utils)) != kSPNoError ||
+        !utils) {
+        return true;  // no key info: treat every frame as distinct
+    }
+
+    bool interpolated = false;
+    for (ParamID id : kStackParams) {
+        PF_KeyIndex count = PF_KeyIndex_NONE;
+        if (utils->PF_GetKeyframeCount(in_data->effect_ref, id, &count) != PF_Err_NONE || count <= 0) {
+            continue;
+        }
+        const bool isIntensity = id == kParam_LogIntensity || id == kParam_CreativeIntensity ||
+                                 id == kParam_SecondaryIntensity || id == kParam_AccentIntensity;
+        const bool isTrim = id >= kParam_TrimExposure && id <= kParam_TrimOutputSaturation;
+        const bool isMix = id == kParam_TransitionMix;
+        interpolated = interpolated || ((isIntensity || isTrim || isMix) && count > 1);
+        for (PF_KeyIndex k = 0; k < count; ++k) {
+            A_long keyTime = 0;
+            A_u_long keyScale = 0;
+            if (utils->PF_KeyIndexToTime(in_data->effect_ref, id, k, &keyTime, &keyScale) != PF_Err_NONE ||
+                keyScale == 0) {
+                continue;
+            }
+            const double t = static_cast<double>(keyTime) * in_data->time_scale / keyScale;
+            if (t >= first && t <= last) {
+                keyTimes.push_back(t);
+            }
+        }
+    }
+    in_data->pica_basicP->ReleaseSuite(kPFParamUtilsSuite, kPFParamUtilsSuiteVersion3);
+    return interpolated;
+}
+
+static void PrebakeAhead(PF_InData* in_data) {
+    if (HintsFor(in_data).interactive || in_data->time_step <= 0) {
+        return;
+    }
+    const A_long now = in_data->current_time;
+    const A_long step = in_data->time_step;
+    A_long first = 0, last = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_sequenceMutex);
+        auto inserted = g_sequences.emplace(in_data->effect_ref, SequenceState{});
+        SequenceState& sequence = inserted.first->second;
+        const bool sequential = !inserted.second && now == sequence.lastTime + step;
+        sequence.lastTime = now;
+        // Re-arm halfway through the previous window.
+        if (!sequential || now + step * (kPrebakeWindowFrames / 2) < sequence.prebakedUntil) {
+            return;
+        }
+        first = now + step;
+        last = now + step * kPrebakeWindowFrames;
+        sequence.prebakedUntil = last;
+    }
+
+    std::vector<double> keyTimes;
+    const bool interpolated = CollectStackKeyTimes(in_data, first, last, keyTimes);
+    const std::vector<double> times = PrebakeSampleTimes(first, last, step, std::move(keyTimes), interpolated);
+    std::vector<ParamsSnapshot> frames(times.size());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        (void)ReadParamsAtTime(in_data, static_cast<A_long>(times[i]), frames[i]);
+    }
+    PrebakeSequence(frames, InstanceKey(in_data->effect_ref));
+}
+
+// SEQUENCE_SETDOWN.
+static void ForgetSequence(PF_ProgPtr effect_ref) {
+    {
+        std::lock_guard<std::mutex> lock(g_sequenceMutex);
+        g_sequences.erase(effect_ref);
+    }
+    CancelSequencePrebake(InstanceKey(effect_ref));
+}
+
 static PF_Err SmartPreRender(PF_InData* in_data, PF_OutData* out_data,
                              PF_PreRenderExtra* extra) {
     (void)out_data;
@@ -124,6 +478,17 @@ static PF_Err SmartPreRender(PF_InData* in_data, PF_OutData* out_data,
         UnionLRect(&in_result.result_rect,     &extra->output->result_rect);
         UnionLRect(&in_result.max_result_rect, &extra->output->max_result_rect);
     }
+    // A draft frame must not be cached as the final one: once the full
+    // composite is ready the key changes and AE renders the frame again.
+    if (!err && HintsFor(in_data).interactive) {
+        ParamsSnapshot snap{};
+        (void)ReadParamsForCurrentFrame(in_data, snap);
+        const A_long draft = IsFullCompositeReady(ResolveStack(snap)) ? 0 : 1;
+        err = extra->cb->GuidMixInPtr(in_data->effect_ref, sizeof(draft), &draft);
+    }
+    if (!err) {
+        PrebakeAhead(in_data);
+    }
     return err;
 }
 
@@ -143,7 +508,7 @@ static PF_Err SmartRender(PF_InData* in_data, PF_OutData* out_data,
         if (!err) {
             ParamsSnapshot snap{};
             (void)ReadParamsForCurrentFrame(in_data, snap);
-            ProcessFrameCPU(snap, src, dst);
+            ProcessFrameCPU(snap, src, dst, HintsFor(in_data));
         }
     }
     if (extra && extra->cb && input_worldP)
@@ -167,7 +532,22 @@ PF_Err EffectMain(PF_Cmd cmd, PF_InData* in_data, PF_OutData* out_data,
             out_data->out_flags2 = PF_OutFlag2_FLOAT_COLOR_AWARE
                                  | PF_OutFlag2_SUPPORTS_SMART_RENDER
                                  | PF_OutFlag2_PARAM_GROUP_START_COLLAPSED_FLAG
-                                 | PF_OutFlag2_SUPPORTS_THREADED_RENDERING;
+                                 | PF_OutFlag2_SUPPORTS_THREADED_RENDERING
+                                 | PF_OutFlag2_I_MIX_GUID_DEPENDENCIES;
+            SetupComputeCache(in_data);
+            SetupRefineRedraw(in_data);
+            break;
+        case PF_Cmd_GLOBAL_SETDOWN:
+            SetdownRefineRedraw();
+            SetdownComputeCache();
+            vtc::PurgeCaches();
+            break;
+        case PF_Cmd_SEQUENCE_SETDOWN:
+            ForgetRefineWatch(in_data->effect_ref);
+            ForgetSequence(in_data->effect_ref);
+            // The caches are shared by every instance and bounded by
+            // CacheBudget, which ages this one's entries out; purging here
+            // would make the others rebake. Only GLOBAL_SETDOWN purges.
             break;
         case PF_Cmd_PARAMS_SETUP:
             err = AddParams(in_data, out_data);
@@ -187,6 +567,12 @@ PF_Err EffectMain(PF_Cmd cmd, PF_InData* in_data, PF_OutData* out_data,
             err = HandleParamChange(in_data, out_data, params,
                                     reinterpret_cast<PF_UserChangedParamExtra*>(extra));
             break;
+        case PF_Cmd_COMPLETELY_GENERAL:
+            // RedrawIdleHook: a watched stack's full composite is ready.
+            if (extra == &kRedrawTag) {
+                out_data->out_flags |= PF_OutFlag_FORCE_RERENDER;
+            }
+            break;
         default:
             break;
     }
@@ -14,7 +14,7 @@ resource 'PiPL' (16000) {
         AE_Effect_Version { 524288 },
         AE_Effect_Info_Flags { 0 },
         AE_Effect_Global_OutFlags { 100663296 },
-        AE_Effect_Global_OutFlags_2 { 134222856 },
+        AE_Effect_Global_OutFlags_2 { 136320008 },
         AE_Effect_Match_Name { "com.vtclooks.cpu" },
         AE_Reserved_Info { 0 },
         AE_Effect_Support_URL { "https://vtclooks.example" }
@@ -1,5 +1,5 @@
 #include "VTC_ParamMap_AdobePF.h"
-#include "../../Shared/VTC_LUTData.h"
+#include "../../Core/VTC_LUTLibrary.h"
 
 namespace vtc {
 namespace pf {
@@ -48,37 +48,117 @@ static PF_Err AddGroup(PF_InData* in_data, PF_OutData* out_data,
     return err;
 }
 
+// Sliders in TrimParams units, except saturation and gain in percent.
+static PF_Err AddTrimGroup(PF_InData* in_data, PF_OutData* out_data) {
+    PF_Err err = PF_Err_NONE;
+    PF_ParamDef def;
+
+    AEFX_CLR_STRUCT(def);
+    def.flags = PF_ParamFlag_START_COLLAPSED;
+    PF_ADD_TOPIC("Trim", kParam_TrimTopic);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Exposure", -4, 4, -2, 2, 0, 0, 2, 0, 0, kParam_TrimExposure);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Temperature", -100, 100, -100, 100, 0, 0, 0, 0, 0, kParam_TrimTemperature);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Tint", -100, 100, -100, 100, 0, 0, 0, 0, 0, kParam_TrimTint);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Saturation", 0, 200, 0, 200, 0, 100, 0, 1, 0, kParam_TrimSaturation);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Output Gain", 0, 200, 0, 200, 0, 100, 0, 1, 0, kParam_TrimOutputGain);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Output Saturation", 0, 200, 0, 200, 0, 100, 0, 1, 0, kParam_TrimOutputSaturation);
+
+    AEFX_CLR_STRUCT(def);
+    PF_END_TOPIC(kParam_TrimTopicEnd);
+
+    (void)out_data;
+    return err;
+}
+
+// Mix in percent, keyframeable; the look uses the Rec 709 popup.
+static PF_Err AddTransitionGroup(PF_InData* in_data, PF_OutData* out_data, int lut_count,
+                                 const char* look_popup_str) {
+    PF_Err err = PF_Err_NONE;
+    PF_ParamDef def;
+
+    AEFX_CLR_STRUCT(def);
+    def.flags = PF_ParamFlag_START_COLLAPSED;
+    PF_ADD_TOPIC("Transition", kParam_TransitionTopic);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_CHECKBOXX("Enable", FALSE, 0, kParam_TransitionEnable);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_POPUP("To Look", lut_count + 1, 1, look_popup_str, kParam_TransitionLook);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Mix", 0, 100, 0, 100, 0, 0, 1, 1, 0, kParam_TransitionMix);
+
+    AEFX_CLR_STRUCT(def);
+    PF_END_TOPIC(kParam_TransitionTopicEnd);
+
+    (void)out_data;
+    return err;
+}
+
 PF_Err AddParams(PF_InData* in_data, PF_OutData* out_data) {
     PF_Err err = PF_Err_NONE;
+    // Built-in looks keep their popup positions; user LUTs are appended.
+    const LUTLibrary& library = LUTLibrary::Shared();
+    const int logCount = library.Count(LUTTable::kLog);
+    const int rec709Count = library.Count(LUTTable::kRec709);
+    const std::string logPopupString = library.PopupString(LUTTable::kLog);
+    const std::string logSelectedString = library.SelectedPopupString(LUTTable::kLog);
+    const std::string rec709PopupString = library.PopupString(LUTTable::kRec709);
+    const std::string rec709SelectedString = library.SelectedPopupString(LUTTable::kRec709);
+    const char* logPopup = logPopupString.c_str();
+    const char* logSelected = logSelectedString.c_str();
+    const char* rec709Popup = rec709PopupString.c_str();
+    const char* rec709Selected = rec709SelectedString.c_str();
 
     ERR(AddGroup(in_data, out_data, "Log Convert",
-                 kLogLUTCount, kLogPopupStr, kLogSelectedPopupStr, 100,
+                 logCount, logPopup, logSelected, 100,
                  false,
                  kParam_LogTopic, kParam_LogEnable, kParam_LogLook,
                  kParam_LogNext, kParam_LogPrev, kParam_LogSelected,
                  kParam_LogIntensity, kParam_LogTopicEnd));
 
     ERR(AddGroup(in_data, out_data, "Creative Look",
-                 kRec709LUTCount, kRec709PopupStr, kRec709SelectedPopupStr, 80,
+                 rec709Count, rec709Popup, rec709Selected, 80,
                  false,
                  kParam_CreativeTopic, kParam_CreativeEnable, kParam_CreativeLook,
                  kParam_CreativeNext, kParam_CreativePrev, kParam_CreativeSelected,
                  kParam_CreativeIntensity, kParam_CreativeTopicEnd));
 
     ERR(AddGroup(in_data, out_data, "Secondary Look",
-                 kRec709LUTCount, kRec709PopupStr, kRec709SelectedPopupStr, 50,
+                 rec709Count, rec709Popup, rec709Selected, 50,
                  true,
                  kParam_SecondaryTopic, kParam_SecondaryEnable, kParam_SecondaryLook,
                  kParam_SecondaryNext, kParam_SecondaryPrev, kParam_SecondarySelected,
                  kParam_SecondaryIntensity, kParam_SecondaryTopicEnd));
 
     ERR(AddGroup(in_data, out_data, "Accent Look",
-                 kRec709LUTCount, kRec709PopupStr, kRec709SelectedPopupStr, 20,
+                 rec709Count, rec709Popup, rec709Selected, 20,
                  true,
                  kParam_AccentTopic, kParam_AccentEnable, kParam_AccentLook,
                  kParam_AccentNext, kParam_AccentPrev, kParam_AccentSelected,
                  kParam_AccentIntensity, kParam_AccentTopicEnd));
 
+    ERR(AddTrimGroup(in_data, out_data));
+
+    PF_ParamDef def;
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_POPUP("Alpha", 2, 1, "Straight|Premultiplied", kParam_AlphaMode);
+
+    ERR(AddTransitionGroup(in_data, out_data, rec709Count, rec709Popup));
+
     out_data->num_params = kParam_Count;
     return err;
 }
@@ -93,12 +173,36 @@ static LayerParams ReadLayer(const PF_ParamDef* const params[],
     return lp;
 }
 
+static TrimParams ReadTrim(const PF_ParamDef* const params[]) {
+    auto value = [params](ParamID id) { return static_cast<float>(params[id]->u.fs_d.value); };
+    TrimParams trim;
+    trim.exposure = value(kParam_TrimExposure);
+    trim.temperature = value(kParam_TrimTemperature);
+    trim.tint = value(kParam_TrimTint);
+    trim.saturation = value(kParam_TrimSaturation) / 100.0f;
+    trim.outputGain = value(kParam_TrimOutputGain) / 100.0f;
+    trim.outputSaturation = value(kParam_TrimOutputSaturation) / 100.0f;
+    return trim;
+}
+
+static TransitionParams ReadTransition(const PF_ParamDef* const params[]) {
+    TransitionParams transition;
+    transition.enabled = params[kParam_TransitionEnable]->u.bd.value != 0;
+    const int pv = params[kParam_TransitionLook]->u.pd.value;
+    transition.toLutIndex = (pv > 1) ? (pv - 2) : -1;
+    transition.mix = static_cast<float>(params[kParam_TransitionMix]->u.fs_d.value) / 100.0f;
+    return transition;
+}
+
 ParamsSnapshot ReadParams(const PF_ParamDef* const params[]) {
     ParamsSnapshot snap{};
     snap.logConvert = ReadLayer(params, kParam_LogEnable,      kParam_LogLook,       kParam_LogIntensity);
     snap.creative   = ReadLayer(params, kParam_CreativeEnable,  kParam_CreativeLook,  kParam_CreativeIntensity);
     snap.secondary  = ReadLayer(params, kParam_SecondaryEnable, kParam_SecondaryLook, kParam_SecondaryIntensity);
     snap.accent     = ReadLayer(params, kParam_AccentEnable,    kParam_AccentLook,    kParam_AccentIntensity);
+    snap.trim       = ReadTrim(params);
+    snap.alphaMode  = params[kParam_AlphaMode]->u.pd.value == 2 ? AlphaMode::kPremultiplied : AlphaMode::kStraight;
+    snap.transition = ReadTransition(params);
     return snap;
 }
 
@@ -2,18 +2,29 @@
 #include "VTC_OFX_Includes.h"
 #include "VTC_ParamMap_OFX.h"
 
+#include "../../Core/VTC_CacheBudget.h"
 #include "../../Core/VTC_CopyUtils.h"
+#include "../../Core/VTC_LUTLibrary.h"
 #include "../../Core/VTC_LUTSampling.h"
+#include "../../Core/VTC_Prefetch.h"
+#include "../../Core/VTC_ProgressiveBake.h"
+#include "../../Core/VTC_SequencePrebake.h"
 #include "../../GPU/Metal/VTC_MetalBackend.h"
 
 #import <Metal/Metal.h>
+#include <dispatch/dispatch.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace OFX {
 namespace Private {
@@ -133,13 +144,59 @@ void logLifecycle(const char *stage, const char *detail = nullptr) {
                detail ? detail : "");
   std::fclose(f);
 }
+
+bool slotForPrefix(const std::string &prefix, LayerSlot &slot) {
+  if (prefix == "log")
+    slot = LayerSlot::kLogConvert;
+  else if (prefix == "creative")
+    slot = LayerSlot::kCreative;
+  else if (prefix == "secondary")
+    slot = LayerSlot::kSecondary;
+  else if (prefix == "accent")
+    slot = LayerSlot::kAccent;
+  else
+    return false;
+  return true;
+}
+} // namespace
+
+class VTCLooksEffect;
+
+namespace {
+// Live instances, for redrawing the ones a refined composite belongs to.
+std::mutex g_instancesMutex;
+std::vector<VTCLooksEffect *> g_instances;
 } // namespace
 
 class VTCLooksEffect : public OFX::ImageEffect {
 public:
   explicit VTCLooksEffect(OfxImageEffectHandle handle)
-      : OFX::ImageEffect(handle) {}
-  ~VTCLooksEffect() override { logLifecycle("destroyInstance", "dtor"); }
+      : OFX::ImageEffect(handle) {
+    std::lock_guard<std::mutex> lock(g_instancesMutex);
+    g_instances.push_back(this);
+  }
+  ~VTCLooksEffect() override {
+    {
+      std::lock_guard<std::mutex> lock(g_instancesMutex);
+      g_instances.erase(
+          std::remove(g_instances.begin(), g_instances.end(), this),
+          g_instances.end());
+    }
+    logLifecycle("destroyInstance", "dtor");
+  }
+
+  // The full composite of `stack` is ready. If this instance shows that
+  // stack its viewer may still hold the draft frame; bumping the secret
+  // redraw param makes the host render it again. Main thread only.
+  void redrawIfShowing(const ResolvedStack &stack) {
+    if (!(ResolveStack(ReadParams(this)) == stack))
+      return;
+    if (OFX::IntParam *redraw = fetchIntParam(kRedrawParam)) {
+      int value = 0;
+      redraw->getValue(value);
+      redraw->setValue(value + 1);
+    }
+  }
 
   void render(const OFX::RenderArguments &args) override {
     @autoreleasepool {
@@ -165,7 +222,7 @@ public:
           }
 
           logLifecycle("render_params", "reading");
-          const ParamsSnapshot snap = ReadParams(this);
+          const ParamsSnapshot snap = ReadParamsAtTime(this, args.time);
           logLifecycle("render_params", "done");
 
           const bool hostMetalAvailable =
@@ -281,7 +338,9 @@ public:
                                           : "stability_forced_cpu";
             }
             logLifecycle("render_cpu_start", reason);
-            ProcessFrameCPU(snap, src, dst);
+            RenderHints hints;
+            hints.interactive = args.interactiveRenderStatus;
+            ProcessFrameCPU(snap, src, dst, hints);
             logLifecycle("render_cpu_done", "ok");
             logFrameOnce(snap, src, args, "cpu", reason);
           } else {
@@ -313,6 +372,34 @@ public:
     } // @autoreleasepool
   }
 
+  // Bake every stack the export will hit before its first frame arrives.
+  void beginSequenceRender(const OFX::BeginSequenceRenderArguments &args) override {
+    if (args.isInteractive)
+      return;
+    std::vector<double> keyTimes;
+    const bool interpolated = CollectStackKeyTimes(this, keyTimes);
+    const std::vector<double> times =
+        PrebakeSampleTimes(args.frameRange.min, args.frameRange.max,
+                           args.frameStep > 0.0 ? args.frameStep : 1.0,
+                           std::move(keyTimes), interpolated);
+    std::vector<ParamsSnapshot> frames;
+    frames.reserve(times.size());
+    for (double t : times)
+      frames.push_back(ReadParamsAtTime(this, t));
+    PrebakeSequence(frames, instanceKey());
+    logLifecycle("beginSequenceRender", interpolated ? "interpolated" : "keys");
+  }
+
+  void endSequenceRender(const OFX::EndSequenceRenderArguments &args) override {
+    (void)args;
+    CancelSequencePrebake(instanceKey());
+  }
+
+  void purgeCaches() override {
+    logLifecycle("purgeCaches");
+    PurgeCaches();
+  }
+
   bool isIdentity(const OFX::IsIdentityArguments &args,
                   OFX::Clip *&identityClip, double &identityTime) override {
     (void)args;
@@ -326,10 +413,13 @@ public:
     if (args.reason != OFX::eChangeUserEdit)
       return;
 
-    auto cycleLook = [this](const char *prefix, int optionCount, bool forward) {
+    // Within the options the popup was described with; the library may
+    // have grown since.
+    auto cycleLook = [this](const char *prefix, bool forward) {
       std::string p(prefix);
       OFX::ChoiceParam *look = fetchChoiceParam(p + "Look");
       OFX::ChoiceParam *sel = fetchChoiceParam(p + "Selected");
+      const int optionCount = look ? look->getNOptions() : 0;
       if (!look || !sel || optionCount <= 0)
         return;
 
@@ -346,24 +436,25 @@ public:
 
       look->setValue(next);
       sel->setValue(next);
+      prepareStack(p);
     };
 
     if (paramName == "logNext")
-      cycleLook("log", kLogLUTCount + 1, true);
+      cycleLook("log", true);
     else if (paramName == "logPrev")
-      cycleLook("log", kLogLUTCount + 1, false);
+      cycleLook("log", false);
     else if (paramName == "creativeNext")
-      cycleLook("creative", kRec709LUTCount + 1, true);
+      cycleLook("creative", true);
     else if (paramName == "creativePrev")
-      cycleLook("creative", kRec709LUTCount + 1, false);
+      cycleLook("creative", false);
     else if (paramName == "secondaryNext")
-      cycleLook("secondary", kRec709LUTCount + 1, true);
+      cycleLook("secondary", true);
     else if (paramName == "secondaryPrev")
-      cycleLook("secondary", kRec709LUTCount + 1, false);
+      cycleLook("secondary", false);
     else if (paramName == "accentNext")
-      cycleLook("accent", kRec709LUTCount + 1, true);
+      cycleLook("accent", true);
     else if (paramName == "accentPrev")
-      cycleLook("accent", kRec709LUTCount + 1, false);
+      cycleLook("accent", false);
     else if (paramName.find("Look") != std::string::npos &&
              paramName.find("Selected") == std::string::npos) {
       std::string p = paramName.substr(0, paramName.find("Look"));
@@ -373,15 +464,49 @@ public:
         int value = 0;
         look->getValue(value);
         sel->setValue(value);
+        prepareStack(p);
       }
     }
   }
+
+private:
+  // Background queue key of this instance's prefetch and prebake tasks.
+  std::uint64_t instanceKey() const {
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(this));
+  }
+
+  // Start baking the new stack before the host asks for the first frame, then
+  // the stacks one Next/Prev away in the group that changed.
+  void prepareStack(const std::string &prefix) {
+    const ParamsSnapshot snap = ReadParams(this);
+    ScheduleCompositeRefine(ResolveStack(snap));
+    LayerSlot slot;
+    OFX::ChoiceParam *look = fetchChoiceParam(prefix + "Look");
+    if (slotForPrefix(prefix, slot) && look)
+      PrefetchNeighbourLooks(snap, slot, look->getNOptions() - 1, instanceKey());
+  }
 };
 
+namespace {
+// Runs on the background queue; params may only be set on the main thread.
+void onCompositeRefined(const ResolvedStack &stack) {
+  auto refined = std::make_shared<const ResolvedStack>(stack);
+  dispatch_async(dispatch_get_main_queue(), ^{
+    std::lock_guard<std::mutex> lock(g_instancesMutex);
+    for (VTCLooksEffect *effect : g_instances)
+      effect->redrawIfShowing(*refined);
+  });
+}
+} // namespace
+
 class VTCLooksFactory : public OFX::PluginFactoryHelper<VTCLooksFactory> {
 public:
   VTCLooksFactory() : PluginFactoryHelper<VTCLooksFactory>(kPluginID, 1, 0) {}
 
+  void load() override { SetCompositeRefinedListener(onCompositeRefined); }
+
+  void unload() override { SetCompositeRefinedListener(nullptr); }
+
   void describe(OFX::ImageEffectDescriptor &desc) override {
     logLifecycle("describe", kPluginID);
     desc.setLabels(kPluginLabel, kPluginLabel, kPluginLabel);
@@ -1,10 +1,11 @@
 #include "VTC_ParamMap_OFX.h"
-#include "../../Shared/VTC_LUTData.h"
+#include "../../Core/VTC_LUTLibrary.h"
 
 #include "ofxsImageEffect.h"
 #include "ofxsParam.h"
 
 #include <string>
+#include <vector>
 
 namespace vtc {
 namespace ofx {
@@ -74,25 +75,128 @@ void addGroup(OFX::ParamSetDescriptor& desc,
     intensity->setParent(*grp);
 }
 
-LayerParams readLayer(const OFX::ParamSet* params, const char* prefix) {
+constexpr const char* kLayerPrefixes[] = {"log", "creative", "secondary", "accent"};
+
+// Trim sliders: name, label, default, range and display range. Percent
+// sliders are read as fractions.
+struct TrimSlider {
+    const char* name;
+    const char* label;
+    double defaultValue, min, max, displayMin, displayMax;
+    bool percent;
+};
+
+constexpr TrimSlider kTrimSliders[] = {
+    {"trimExposure", "Exposure", 0.0, -4.0, 4.0, -2.0, 2.0, false},
+    {"trimTemperature", "Temperature", 0.0, -100.0, 100.0, -100.0, 100.0, false},
+    {"trimTint", "Tint", 0.0, -100.0, 100.0, -100.0, 100.0, false},
+    {"trimSaturation", "Saturation", 100.0, 0.0, 200.0, 0.0, 200.0, true},
+    {"trimOutputGain", "Output Gain", 100.0, 0.0, 200.0, 0.0, 200.0, true},
+    {"trimOutputSaturation", "Output Saturation", 100.0, 0.0, 200.0, 0.0, 200.0, true},
+};
+
+void addTrimGroup(OFX::ParamSetDescriptor& desc) {
+    OFX::GroupParamDescriptor* grp = desc.defineGroupParam("trimGroup");
+    grp->setLabel("Trim");
+    grp->setOpen(false);
+
+    for (const TrimSlider& t : kTrimSliders) {
+        OFX::DoubleParamDescriptor* slider = desc.defineDoubleParam(t.name);
+        slider->setLabel(t.label);
+        slider->setDefault(t.defaultValue);
+        slider->setRange(t.min, t.max);
+        slider->setDisplayRange(t.displayMin, t.displayMax);
+        slider->setParent(*grp);
+    }
+}
+
+// kTrimSliders order: exposure, temperature, tint, saturation, output gain,
+// output saturation.
+TrimParams readTrim(const OFX::ParamSet* params, const double* time) {
+    float values[6];
+    for (int i = 0; i < 6; ++i) {
+        const TrimSlider& t = kTrimSliders[i];
+        double value = t.defaultValue;
+        if (OFX::DoubleParam* slider = params->fetchDoubleParam(t.name)) {
+            if (time) slider->getValueAtTime(*time, value); else slider->getValue(value);
+        }
+        values[i] = static_cast<float>(t.percent ? value / 100.0 : value);
+    }
+    TrimParams trim;
+    trim.exposure = values[0];
+    trim.temperature = values[1];
+    trim.tint = values[2];
+    trim.saturation = values[3];
+    trim.outputGain = values[4];
+    trim.outputSaturation = values[5];
+    return trim;
+}
+
+// Mix in percent, keyframeable; the look uses the Rec 709 popup.
+void addTransitionGroup(OFX::ParamSetDescriptor& desc, const char* lookPopup) {
+    OFX::GroupParamDescriptor* grp = desc.defineGroupParam("transitionGroup");
+    grp->setLabel("Transition");
+    grp->setOpen(false);
+
+    OFX::BooleanParamDescriptor* en = desc.defineBooleanParam("transitionEnable");
+    en->setLabel("Enable");
+    en->setDefault(false);
+    en->setParent(*grp);
+
+    OFX::ChoiceParamDescriptor* look = desc.defineChoiceParam("transitionLook");
+    look->setLabel("To Look");
+    look->setDefault(0);
+    appendChoiceOptions(look, lookPopup);
+    look->setParent(*grp);
+
+    OFX::DoubleParamDescriptor* mix = desc.defineDoubleParam("transitionMix");
+    mix->setLabel("Mix");
+    mix->setDefault(0.0);
+    mix->setRange(0.0, 100.0);
+    mix->setDisplayRange(0.0, 100.0);
+    mix->setParent(*grp);
+}
+
+TransitionParams readTransition(const OFX::ParamSet* params, const double* time) {
+    TransitionParams transition;
+    if (OFX::BooleanParam* en = params->fetchBooleanParam("transitionEnable")) {
+        bool enabled = false;
+        if (time) en->getValueAtTime(*time, enabled); else en->getValue(enabled);
+        transition.enabled = enabled;
+    }
+    if (OFX::ChoiceParam* look = params->fetchChoiceParam("transitionLook")) {
+        int v = 0;
+        if (time) look->getValueAtTime(*time, v); else look->getValue(v);
+        transition.toLutIndex = (v > 0) ? (v - 1) : -1;
+    }
+    if (OFX::DoubleParam* mix = params->fetchDoubleParam("transitionMix")) {
+        double value = 0.0;
+        if (time) mix->getValueAtTime(*time, value); else mix->getValue(value);
+        transition.mix = static_cast<float>(value) / 100.0f;
+    }
+    return transition;
+}
+
+// `time` null reads the current value.
+LayerParams readLayer(const OFX::ParamSet* params, const char* prefix, const double* time) {
     LayerParams lp{};
     std::string p(prefix);
 
     if (OFX::BooleanParam* en = params->fetchBooleanParam(p + "Enable")) {
         bool enabled = false;
-        en->getValue(enabled);
+        if (time) en->getValueAtTime(*time, enabled); else en->getValue(enabled);
         lp.enabled = enabled;
     }
 
     if (OFX::ChoiceParam* look = params->fetchChoiceParam(p + "Look")) {
         int v = 0;
-        look->getValue(v);
+        if (time) look->getValueAtTime(*time, v); else look->getValue(v);
         lp.lutIndex = (v > 0) ? (v - 1) : -1;
     }
 
     if (OFX::DoubleParam* intensity = params->fetchDoubleParam(p + "Intensity")) {
         double value = 100.0;
-        intensity->getValue(value);
+        if (time) intensity->getValueAtTime(*time, value); else intensity->getValue(value);
         lp.intensity = static_cast<float>(value) / 100.0f;
     } else {
         lp.intensity = 1.0f;
@@ -101,26 +205,107 @@ LayerParams readLayer(const OFX::ParamSet* params, const char* prefix) {
     return lp;
 }
 
+ParamsSnapshot readSnapshot(const OFX::ParamSet* params, const double* time) {
+    ParamsSnapshot snap{};
+    if (!params) {
+        return snap;
+    }
+
+    snap.logConvert = readLayer(params, "log", time);
+    snap.creative = readLayer(params, "creative", time);
+    snap.secondary = readLayer(params, "secondary", time);
+    snap.accent = readLayer(params, "accent", time);
+    snap.trim = readTrim(params, time);
+    if (OFX::ChoiceParam* alpha = params->fetchChoiceParam("alphaMode")) {
+        int v = 0;
+        if (time) alpha->getValueAtTime(*time, v); else alpha->getValue(v);
+        snap.alphaMode = v == 1 ? AlphaMode::kPremultiplied : AlphaMode::kStraight;
+    }
+    snap.transition = readTransition(params, time);
+    return snap;
+}
+
+void appendKeyTimes(OFX::ValueParam* param, std::vector<double>& keyTimes) {
+    if (!param) return;
+    const unsigned int n = param->getNumKeys();
+    for (unsigned int i = 0; i < n; ++i) {
+        keyTimes.push_back(param->getKeyTime(static_cast<int>(i)));
+    }
+}
+
 }  // namespace
 
 void AddParams(OFX::ParamSetDescriptor& desc) {
-    addGroup(desc, "Log Convert", kLogPopupStr, kLogSelectedPopupStr, 100, false, "log");
-    addGroup(desc, "Creative", kRec709PopupStr, kRec709SelectedPopupStr, 80, false, "creative");
-    addGroup(desc, "Secondary", kRec709PopupStr, kRec709SelectedPopupStr, 50, true, "secondary");
-    addGroup(desc, "Accent", kRec709PopupStr, kRec709SelectedPopupStr, 20, true, "accent");
+    // Built-in looks keep their option positions; user LUTs are appended.
+    const LUTLibrary& library = LUTLibrary::Shared();
+    const std::string logPopupString = library.PopupString(LUTTable::kLog);
+    const std::string logSelectedString = library.SelectedPopupString(LUTTable::kLog);
+    const std::string rec709PopupString = library.PopupString(LUTTable::kRec709);
+    const std::string rec709SelectedString = library.SelectedPopupString(LUTTable::kRec709);
+    const char* logPopup = logPopupString.c_str();
+    const char* logSelected = logSelectedString.c_str();
+    const char* rec709Popup = rec709PopupString.c_str();
+    const char* rec709Selected = rec709SelectedString.c_str();
+
+    addGroup(desc, "Log Convert", logPopup, logSelected, 100, false, "log");
+    addGroup(desc, "Creative", rec709Popup, rec709Selected, 80, false, "creative");
+    addGroup(desc, "Secondary", rec709Popup, rec709Selected, 50, true, "secondary");
+    addGroup(desc, "Accent", rec709Popup, rec709Selected, 20, true, "accent");
+    addTrimGroup(desc);
+
+    OFX::ChoiceParamDescriptor* alpha = desc.defineChoiceParam("alphaMode");
+    alpha->setLabel("Alpha");
+    alpha->appendOption("Straight");
+    alpha->appendOption("Premultiplied");
+    alpha->setDefault(0);
+
+    addTransitionGroup(desc, rec709Popup);
+
+    OFX::IntParamDescriptor* redraw = desc.defineIntParam(kRedrawParam);
+    redraw->setIsSecret(true);
+    redraw->setIsPersistant(false);
+    redraw->setCanUndo(false);
+    redraw->setAnimates(false);
 }
 
 ParamsSnapshot ReadParams(const OFX::ParamSet* params) {
-    ParamsSnapshot snap{};
+    return readSnapshot(params, nullptr);
+}
+
+ParamsSnapshot ReadParamsAtTime(const OFX::ParamSet* params, double time) {
+    return readSnapshot(params, &time);
+}
+
+bool CollectStackKeyTimes(const OFX::ParamSet* params, std::vector<double>& keyTimes) {
+    bool intensityAnimated = false;
     if (!params) {
-        return snap;
+        return intensityAnimated;
     }
-
-    snap.logConvert = readLayer(params, "log");
-    snap.creative = readLayer(params, "creative");
-    snap.secondary = readLayer(params, "secondary");
-    snap.accent = readLayer(params, "accent");
-    return snap;
+    for (const char* prefix : kLayerPrefixes) {
+        std::string p(prefix);
+        appendKeyTimes(params->fetchBooleanParam(p + "Enable"), keyTimes);
+        appendKeyTimes(params->fetchChoiceParam(p + "Look"), keyTimes);
+        OFX::DoubleParam* intensity = params->fetchDoubleParam(p + "Intensity");
+        if (intensity && intensity->getNumKeys() > 1) {
+            intensityAnimated = true;
+        }
+        appendKeyTimes(intensity, keyTimes);
+    }
+    for (const TrimSlider& t : kTrimSliders) {
+        OFX::DoubleParam* slider = params->fetchDoubleParam(t.name);
+        if (slider && slider->getNumKeys() > 1) {
+            intensityAnimated = true;
+        }
+        appendKeyTimes(slider, keyTimes);
+    }
+    appendKeyTimes(params->fetchBooleanParam("transitionEnable"), keyTimes);
+    appendKeyTimes(params->fetchChoiceParam("transitionLook"), keyTimes);
+    OFX::DoubleParam* mix = params->fetchDoubleParam("transitionMix");
+    if (mix && mix->getNumKeys() > 1) {
+        intensityAnimated = true;
+    }
+    appendKeyTimes(mix, keyTimes);
+    return intensityAnimated;
 }
 
 }  // namespace ofx
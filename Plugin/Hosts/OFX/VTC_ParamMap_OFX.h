@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "../../Shared/VTC_Params.h"
 
 namespace OFX {
@@ -10,8 +12,18 @@ class ParamSet;
 namespace vtc {
 namespace ofx {
 
+// Secret, unsaved integer the effect bumps to make the host render again
+// once a refined composite replaces a draft; nothing reads its value.
+constexpr const char* kRedrawParam = "refineRedraw";
+
 void AddParams(OFX::ParamSetDescriptor& desc);
 ParamsSnapshot ReadParams(const OFX::ParamSet* params);
+ParamsSnapshot ReadParamsAtTime(const OFX::ParamSet* params, double time);
+
+// Appends the key times of every Enable/Look/Intensity, trim and transition
+// param. Returns true if an intensity, trim or transition mix interpolates
+// (more than one key), i.e. can differ per frame.
+bool CollectStackKeyTimes(const OFX::ParamSet* params, std::vector<double>& keyTimes);
 
 }  // namespace ofx
 }  // namespace vtc
@@ -5,6 +5,8 @@
 #include "VTC_ParamMap_PrGPU.h"
 #include "VTC_PrGPU_Params.h"
 #include "../../Shared/VTC_LUTData.h"
+#include "../../Core/VTC_LUTLibrary.h"
+#include "../../Core/VTC_StackBake.h"
 
 static size_t DivideRoundUp(size_t v, size_t m) {
     return v ? (v + m - 1) / m : 0;
@@ -64,29 +66,59 @@ struct MultiLUTParams {
     int layer3Offset;
     int layer3Dim;
     float layer3Intensity;
+    int layerShaperSize[4];
+    int premultiplied;
 };
 
 struct ResolvedLayer {
     const float* data;
     int dimension;
     float intensity;
+    const float* shaper;
+    int shaperSize;
 };
 
 struct ActiveLayers {
     ResolvedLayer layers[4];
     int count = 0;
 
-    void tryAdd(const vtc::prgpu::LayerParams& lp, const vtc::LUT3D* table, int tableCount) {
-        if (!lp.enabled || lp.lutIndex < 0 || lp.lutIndex >= tableCount || lp.intensity <= 0.0001f)
+    // Premiere's popups list the built-in looks only.
+    void tryAdd(const vtc::prgpu::LayerParams& lp, vtc::LUTTable table) {
+        vtc::LUTLibrary& library = vtc::LUTLibrary::Shared();
+        if (!lp.enabled || lp.lutIndex < 0 || lp.lutIndex >= library.BuiltinCount(table) || lp.intensity <= 0.0001f)
+            return;
+        const vtc::LUT3D* lut = library.Get(table, lp.lutIndex);
+        if (!lut)
             return;
-        const vtc::LUT3D& lut = table[lp.lutIndex];
         ResolvedLayer& rl = layers[count++];
-        rl.data = lut.data;
-        rl.dimension = lut.dimension;
+        rl.data = lut->data;
+        rl.dimension = lut->dimension;
+        rl.shaper = lut->shaper;
+        rl.shaperSize = lut->shaper ? lut->shaperSize : 0;
         rl.intensity = (lp.intensity < 0.0f) ? 0.0f : (lp.intensity > 1.0f ? 1.0f : lp.intensity);
     }
+
+    // The whole stack as its one baked composite, trims included.
+    void setComposite(const vtc::CompositeLUT& composite) {
+        const vtc::LUT3D view = composite.view();
+        ResolvedLayer& rl = layers[0];
+        rl.data = view.data;
+        rl.dimension = view.dimension;
+        rl.shaper = view.shaper;
+        rl.shaperSize = view.shaper ? view.shaperSize : 0;
+        rl.intensity = 1.0f;
+        count = 1;
+    }
 };
 
+static vtc::LayerParams ToLayerParams(const vtc::prgpu::LayerParams& lp) {
+    vtc::LayerParams out;
+    out.enabled = lp.enabled;
+    out.lutIndex = lp.lutIndex;
+    out.intensity = lp.intensity;
+    return out;
+}
+
 class VTCPassthrough : public PrGPUFilterBase
 {
 public:
@@ -173,12 +205,36 @@ public:
             crEn, crLook, crInt,
             secEn, secLook, secInt,
             accEn, accLook, accInt);
+        PrParam trimParams[6];
+        for (int i = 0; i < 6; ++i)
+            trimParams[i] = GetParam(vtc::prgpu::kParam_TrimExposure + i, clipTime);
+        snap.trim = vtc::prgpu::ReadTrimFromPrParam(trimParams);
+        snap.alphaMode = vtc::prgpu::ReadAlphaModeFromPrParam(GetParam(vtc::prgpu::kParam_AlphaMode, clipTime));
+        snap.transition = vtc::prgpu::ReadTransitionFromPrParam(GetParam(vtc::prgpu::kParam_TransitionEnable, clipTime),
+                                                                GetParam(vtc::prgpu::kParam_TransitionLook, clipTime),
+                                                                GetParam(vtc::prgpu::kParam_TransitionMix, clipTime));
 
         ActiveLayers al;
-        al.tryAdd(snap.logConvert, vtc::kLogLUTs, vtc::kLogLUTCount);
-        al.tryAdd(snap.creative, vtc::kRec709LUTs, vtc::kRec709LUTCount);
-        al.tryAdd(snap.secondary, vtc::kRec709LUTs, vtc::kRec709LUTCount);
-        al.tryAdd(snap.accent, vtc::kRec709LUTs, vtc::kRec709LUTCount);
+        al.tryAdd(snap.logConvert, vtc::LUTTable::kLog);
+        al.tryAdd(snap.creative, vtc::LUTTable::kRec709);
+        al.tryAdd(snap.secondary, vtc::LUTTable::kRec709);
+        al.tryAdd(snap.accent, vtc::LUTTable::kRec709);
+
+        // Trims and transitions exist only folded into a composite; it must outlive RenderMetal's copy.
+        vtc::ParamsSnapshot params{};
+        params.logConvert = ToLayerParams(snap.logConvert);
+        params.creative = ToLayerParams(snap.creative);
+        params.secondary = ToLayerParams(snap.secondary);
+        params.accent = ToLayerParams(snap.accent);
+        params.trim = snap.trim;
+        params.transition = snap.transition;
+        const vtc::ResolvedStack stack = vtc::ResolveStack(params);
+        std::shared_ptr<const vtc::CompositeLUT> composite;
+        if (stack.Trimmed() || stack.to) {
+            composite = vtc::AcquireDenseComposite(stack);
+            if (composite)
+                al.setComposite(*composite);
+        }
 
         VTC_PRGPU_LOG("Render %dx%d rb=%d pitch=%d 16f=%d layers=%d", width, height, rowBytes, pitch, is16f ? 1 : 0, al.count);
 
@@ -186,7 +242,8 @@ public:
             return suiteError_Fail;
 
         if (mDeviceInfo.outDeviceFramework == PrGPUDeviceFramework_Metal) {
-            return RenderMetal(inData, outData, pixFmt, width, height, pitch, is16f, al);
+            return RenderMetal(inData, outData, pixFmt, width, height, pitch, is16f, al,
+                               snap.alphaMode == vtc::AlphaMode::kPremultiplied);
         }
         return suiteError_Fail;
     }
@@ -248,7 +305,7 @@ private:
 
     prSuiteError RenderMetal(void* inData, void* outData, PrPixelFormat pixFmt,
                              int width, int height, int pitch, bool is16f,
-                             const ActiveLayers& al)
+                             const ActiveLayers& al, bool premultiplied)
     {
         @autoreleasepool {
             id<MTLDevice> dev = (id<MTLDevice>)mDeviceInfo.outDeviceHandle;
@@ -270,8 +327,12 @@ private:
                 MTLSize ntg = {DivideRoundUp((size_t)width, tpg.width), DivideRoundUp((size_t)height, tpg.height), 1};
                 [enc dispatchThreadgroups:ntg threadsPerThreadgroup:tpg];
             } else {
-                size_t lutFloatsPer = (size_t)33 * 33 * 33 * 3;
-                size_t totalFloats = lutFloatsPer * (size_t)al.count;
+                // Layers keep their native lattice sizes; pack them back to back,
+                // each followed by its shaper.
+                size_t totalFloats = 0;
+                for (int i = 0; i < al.count && i < 4; ++i)
+                    totalFloats += (size_t)al.layers[i].dimension * al.layers[i].dimension * al.layers[i].dimension * 3 +
+                                   (size_t)al.layers[i].shaperSize * 3;
                 id<MTLBuffer> lutBuf = [dev newBufferWithLength:totalFloats * sizeof(float) options:MTLResourceStorageModeShared];
                 float* dst = (float*)[lutBuf contents];
                 size_t offset = 0;
@@ -280,14 +341,18 @@ private:
                 mp.width = width;
                 mp.height = height;
                 mp.layerCount = al.count;
+                mp.premultiplied = premultiplied ? 1 : 0;
                 for (int i = 0; i < al.count && i < 4; ++i) {
                     size_t n = (size_t)al.layers[i].dimension * al.layers[i].dimension * al.layers[i].dimension * 3;
                     memcpy(dst + offset, al.layers[i].data, n * sizeof(float));
+                    if (al.layers[i].shaperSize > 0)
+                        memcpy(dst + offset + n, al.layers[i].shaper, (size_t)al.layers[i].shaperSize * 3 * sizeof(float));
+                    mp.layerShaperSize[i] = al.layers[i].shaperSize;
                     if (i == 0) { mp.layer0Offset = (int)offset; mp.layer0Dim = al.layers[i].dimension; mp.layer0Intensity = al.layers[i].intensity; }
                     else if (i == 1) { mp.layer1Offset = (int)offset; mp.layer1Dim = al.layers[i].dimension; mp.layer1Intensity = al.layers[i].intensity; }
                     else if (i == 2) { mp.layer2Offset = (int)offset; mp.layer2Dim = al.layers[i].dimension; mp.layer2Intensity = al.layers[i].intensity; }
                     else { mp.layer3Offset = (int)offset; mp.layer3Dim = al.layers[i].dimension; mp.layer3Intensity = al.layers[i].intensity; }
-                    offset += n;
+                    offset += n + (size_t)al.layers[i].shaperSize * 3;
                 }
                 id<MTLBuffer> paramBuf = [[dev newBufferWithBytes:&mp length:sizeof(MultiLUTParams) options:MTLResourceStorageModeShared] autorelease];
                 id<MTLComputePipelineState> pso = is16f ? sPSO_Multi_16f[mDeviceIndex] : sPSO_Multi_32f[mDeviceIndex];
@@ -7,6 +7,7 @@
 #include "AE_Macros.h"
 #include "Param_Utils.h"
 #include "VTC_PrGPU_Params.h"
+#include "../../Core/VTC_CacheBudget.h"
 #include "../../Core/VTC_CopyUtils.h"
 #include "../../Core/VTC_LUTSampling.h"
 #include "../../Shared/VTC_LUTData.h"
@@ -148,12 +149,37 @@ static vtc::LayerParams ReadLayerFromParams(const PF_ParamDef* const params[],
     return layer;
 }
 
+static vtc::TrimParams ReadTrimFromParams(const PF_ParamDef* const params[]) {
+    vtc::TrimParams trim;
+    trim.exposure = static_cast<float>(params[vtc::prgpu::kParam_TrimExposure]->u.fs_d.value);
+    trim.temperature = static_cast<float>(params[vtc::prgpu::kParam_TrimTemperature]->u.fs_d.value);
+    trim.tint = static_cast<float>(params[vtc::prgpu::kParam_TrimTint]->u.fs_d.value);
+    trim.saturation = static_cast<float>(params[vtc::prgpu::kParam_TrimSaturation]->u.fs_d.value) / 100.0f;
+    trim.outputGain = static_cast<float>(params[vtc::prgpu::kParam_TrimOutputGain]->u.fs_d.value) / 100.0f;
+    trim.outputSaturation =
+        static_cast<float>(params[vtc::prgpu::kParam_TrimOutputSaturation]->u.fs_d.value) / 100.0f;
+    return trim;
+}
+
+static vtc::TransitionParams ReadTransitionFromParams(const PF_ParamDef* const params[]) {
+    vtc::TransitionParams transition;
+    transition.enabled = params[vtc::prgpu::kParam_TransitionEnable]->u.bd.value != 0;
+    const int popupValue = params[vtc::prgpu::kParam_TransitionLook]->u.pd.value;
+    transition.toLutIndex = (popupValue > 1) ? (popupValue - 2) : -1;
+    transition.mix = static_cast<float>(params[vtc::prgpu::kParam_TransitionMix]->u.fs_d.value) / 100.0f;
+    return transition;
+}
+
 static vtc::ParamsSnapshot ReadParamsFromRender(const PF_ParamDef* const params[]) {
     vtc::ParamsSnapshot snap{};
     snap.logConvert = ReadLayerFromParams(params, vtc::prgpu::kParam_LogEnable, vtc::prgpu::kParam_LogLook, vtc::prgpu::kParam_LogIntensity);
     snap.creative = ReadLayerFromParams(params, vtc::prgpu::kParam_CreativeEnable, vtc::prgpu::kParam_CreativeLook, vtc::prgpu::kParam_CreativeIntensity);
     snap.secondary = ReadLayerFromParams(params, vtc::prgpu::kParam_SecondaryEnable, vtc::prgpu::kParam_SecondaryLook, vtc::prgpu::kParam_SecondaryIntensity);
     snap.accent = ReadLayerFromParams(params, vtc::prgpu::kParam_AccentEnable, vtc::prgpu::kParam_AccentLook, vtc::prgpu::kParam_AccentIntensity);
+    snap.trim = ReadTrimFromParams(params);
+    snap.alphaMode = params[vtc::prgpu::kParam_AlphaMode]->u.pd.value == 2 ? vtc::AlphaMode::kPremultiplied
+                                                                          : vtc::AlphaMode::kStraight;
+    snap.transition = ReadTransitionFromParams(params);
     return snap;
 }
 
@@ -189,12 +215,62 @@ static vtc::LayerParams CheckoutLayer(PF_InData* in_data,
     return layer;
 }
 
+// `fallback` when the checkout fails.
+static float CheckoutFloat(PF_InData* in_data, PrGPUParamID id, float fallback) {
+    PF_ParamDef def;
+    AEFX_CLR_STRUCT(def);
+    if (PF_CHECKOUT_PARAM(in_data, id, in_data->current_time,
+                          in_data->time_step, in_data->time_scale, &def) != PF_Err_NONE) {
+        return fallback;
+    }
+    const float value = static_cast<float>(def.u.fs_d.value);
+    PF_CHECKIN_PARAM(in_data, &def);
+    return value;
+}
+
+static vtc::TrimParams CheckoutTrim(PF_InData* in_data) {
+    vtc::TrimParams trim;
+    trim.exposure = CheckoutFloat(in_data, vtc::prgpu::kParam_TrimExposure, 0.0f);
+    trim.temperature = CheckoutFloat(in_data, vtc::prgpu::kParam_TrimTemperature, 0.0f);
+    trim.tint = CheckoutFloat(in_data, vtc::prgpu::kParam_TrimTint, 0.0f);
+    trim.saturation = CheckoutFloat(in_data, vtc::prgpu::kParam_TrimSaturation, 100.0f) / 100.0f;
+    trim.outputGain = CheckoutFloat(in_data, vtc::prgpu::kParam_TrimOutputGain, 100.0f) / 100.0f;
+    trim.outputSaturation = CheckoutFloat(in_data, vtc::prgpu::kParam_TrimOutputSaturation, 100.0f) / 100.0f;
+    return trim;
+}
+
+static vtc::AlphaMode CheckoutAlphaMode(PF_InData* in_data) {
+    PF_ParamDef def;
+    AEFX_CLR_STRUCT(def);
+    vtc::AlphaMode mode = vtc::AlphaMode::kStraight;
+    if (PF_CHECKOUT_PARAM(in_data, vtc::prgpu::kParam_AlphaMode, in_data->current_time,
+                          in_data->time_step, in_data->time_scale, &def) == PF_Err_NONE) {
+        if (def.u.pd.value == 2) mode = vtc::AlphaMode::kPremultiplied;
+        PF_CHECKIN_PARAM(in_data, &def);
+    }
+    return mode;
+}
+
+static vtc::TransitionParams CheckoutTransition(PF_InData* in_data) {
+    // Enable and To Look check out like a layer's; the mix slider is in percent.
+    const vtc::LayerParams layer = CheckoutLayer(in_data, vtc::prgpu::kParam_TransitionEnable,
+                                                 vtc::prgpu::kParam_TransitionLook, vtc::prgpu::kParam_TransitionMix);
+    vtc::TransitionParams transition;
+    transition.enabled = layer.enabled;
+    transition.toLutIndex = layer.lutIndex;
+    transition.mix = layer.intensity;
+    return transition;
+}
+
 static vtc::ParamsSnapshot ReadParamsFromSmartRender(PF_InData* in_data) {
     vtc::ParamsSnapshot snap{};
     snap.logConvert = CheckoutLayer(in_data, vtc::prgpu::kParam_LogEnable, vtc::prgpu::kParam_LogLook, vtc::prgpu::kParam_LogIntensity);
     snap.creative = CheckoutLayer(in_data, vtc::prgpu::kParam_CreativeEnable, vtc::prgpu::kParam_CreativeLook, vtc::prgpu::kParam_CreativeIntensity);
     snap.secondary = CheckoutLayer(in_data, vtc::prgpu::kParam_SecondaryEnable, vtc::prgpu::kParam_SecondaryLook, vtc::prgpu::kParam_SecondaryIntensity);
     snap.accent = CheckoutLayer(in_data, vtc::prgpu::kParam_AccentEnable, vtc::prgpu::kParam_AccentLook, vtc::prgpu::kParam_AccentIntensity);
+    snap.trim = CheckoutTrim(in_data);
+    snap.alphaMode = CheckoutAlphaMode(in_data);
+    snap.transition = CheckoutTransition(in_data);
     return snap;
 }
 
@@ -273,6 +349,60 @@ static PF_Err AddGroup(PF_InData* in_data,
     return PF_Err_NONE;
 }
 
+static PF_Err AddTrimGroup(PF_InData* in_data) {
+    PF_ParamDef def;
+
+    AEFX_CLR_STRUCT(def);
+    def.flags = PF_ParamFlag_START_COLLAPSED;
+    PF_ADD_TOPIC("Trim", vtc::prgpu::kParam_TrimTopic);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Exposure", -4, 4, -2, 2, 0, 0, 2, 0, 0, vtc::prgpu::kParam_TrimExposure);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Temperature", -100, 100, -100, 100, 0, 0, 0, 0, 0, vtc::prgpu::kParam_TrimTemperature);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Tint", -100, 100, -100, 100, 0, 0, 0, 0, 0, vtc::prgpu::kParam_TrimTint);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Saturation", 0, 200, 0, 200, 0, 100, 0, 1, 0, vtc::prgpu::kParam_TrimSaturation);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Output Gain", 0, 200, 0, 200, 0, 100, 0, 1, 0, vtc::prgpu::kParam_TrimOutputGain);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Output Saturation", 0, 200, 0, 200, 0, 100, 0, 1, 0,
+                        vtc::prgpu::kParam_TrimOutputSaturation);
+
+    AEFX_CLR_STRUCT(def);
+    PF_END_TOPIC(vtc::prgpu::kParam_TrimTopicEnd);
+
+    return PF_Err_NONE;
+}
+
+static PF_Err AddTransitionGroup(PF_InData* in_data) {
+    PF_ParamDef def;
+
+    AEFX_CLR_STRUCT(def);
+    def.flags = PF_ParamFlag_START_COLLAPSED;
+    PF_ADD_TOPIC("Transition", vtc::prgpu::kParam_TransitionTopic);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_CHECKBOXX("Enable", FALSE, 0, vtc::prgpu::kParam_TransitionEnable);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_POPUP("To Look", vtc::kRec709LUTCount + 1, 1, vtc::kRec709PopupStr, vtc::prgpu::kParam_TransitionLook);
+
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_FLOAT_SLIDER("Mix", 0, 100, 0, 100, 0, 0, 1, 1, 0, vtc::prgpu::kParam_TransitionMix);
+
+    AEFX_CLR_STRUCT(def);
+    PF_END_TOPIC(vtc::prgpu::kParam_TransitionTopicEnd);
+
+    return PF_Err_NONE;
+}
+
 static PF_Err AddParams(PF_InData* in_data, PF_OutData* out_data) {
     (void)in_data;
     PF_Err err = PF_Err_NONE;
@@ -305,6 +435,14 @@ static PF_Err AddParams(PF_InData* in_data, PF_OutData* out_data) {
                  vtc::prgpu::kParam_AccentNext, vtc::prgpu::kParam_AccentPrev, vtc::prgpu::kParam_AccentSelected,
                  vtc::prgpu::kParam_AccentIntensity, vtc::prgpu::kParam_AccentTopicEnd));
 
+    ERR(AddTrimGroup(in_data));
+
+    PF_ParamDef def;
+    AEFX_CLR_STRUCT(def);
+    PF_ADD_POPUP("Alpha", 2, 1, "Straight|Premultiplied", vtc::prgpu::kParam_AlphaMode);
+
+    ERR(AddTransitionGroup(in_data));
+
     out_data->num_params = vtc::prgpu::kParam_Count;
     return err;
 }
@@ -429,6 +567,11 @@ extern "C" DllExport PF_Err EffectMain(PF_Cmd cmd, PF_InData* in_data, PF_OutDat
                                 | PF_OutFlag2_PARAM_GROUP_START_COLLAPSED_FLAG
                                 | PF_OutFlag2_SUPPORTS_THREADED_RENDERING;
             break;
+        case PF_Cmd_GLOBAL_SETDOWN:
+            // Not on SEQUENCE_SETDOWN: the caches are shared by every
+            // instance and CacheBudget bounds them.
+            vtc::PurgeCaches();
+            break;
         case PF_Cmd_PARAMS_SETUP:
             err = AddParams(in_data, out_data);
             break;
@@ -41,5 +41,47 @@ PrGPUParamsSnapshot ReadParamsFromPrParam(
     return snap;
 }
 
+static float ReadFloat(const PrParam& param, float fallback) {
+    if (param.mType == kPrParamType_Float32)
+        return param.mFloat32;
+    if (param.mType == kPrParamType_Float64)
+        return static_cast<float>(param.mFloat64);
+    return fallback;
+}
+
+vtc::TrimParams ReadTrimFromPrParam(const PrParam params[6]) {
+    vtc::TrimParams trim;
+    trim.exposure = ReadFloat(params[0], 0.0f);
+    trim.temperature = ReadFloat(params[1], 0.0f);
+    trim.tint = ReadFloat(params[2], 0.0f);
+    trim.saturation = ReadFloat(params[3], 100.0f) / 100.0f;
+    trim.outputGain = ReadFloat(params[4], 100.0f) / 100.0f;
+    trim.outputSaturation = ReadFloat(params[5], 100.0f) / 100.0f;
+    return trim;
+}
+
+vtc::AlphaMode ReadAlphaModeFromPrParam(const PrParam& alphaParam) {
+    // 0-based like the look popups: Straight=0, Premultiplied=1.
+    int pv = 0;
+    if (alphaParam.mType == kPrParamType_Int32)
+        pv = alphaParam.mInt32;
+    else if (alphaParam.mType == kPrParamType_Int64)
+        pv = static_cast<int>(alphaParam.mInt64);
+    return pv == 1 ? vtc::AlphaMode::kPremultiplied : vtc::AlphaMode::kStraight;
+}
+
+vtc::TransitionParams ReadTransitionFromPrParam(const PrParam& enableParam,
+                                                const PrParam& lookParam,
+                                                const PrParam& mixParam) {
+    // Enable and To Look read like a layer's; the mix slider is in percent.
+    LayerParams layer;
+    ReadLayerFromPrParam(layer, enableParam, lookParam, mixParam);
+    vtc::TransitionParams transition;
+    transition.enabled = layer.enabled;
+    transition.toLutIndex = layer.lutIndex;
+    transition.mix = ReadFloat(mixParam, 0.0f) / 100.0f;
+    return transition;
+}
+
 }  // namespace prgpu
 }  // namespace vtc
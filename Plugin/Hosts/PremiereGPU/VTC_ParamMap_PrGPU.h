@@ -18,5 +18,14 @@ PrGPUParamsSnapshot ReadParamsFromPrParam(
     const PrParam& secondaryEnable, const PrParam& secondaryLook, const PrParam& secondaryIntensity,
     const PrParam& accentEnable, const PrParam& accentLook, const PrParam& accentIntensity);
 
+// `params` in kParam_TrimExposure..kParam_TrimOutputSaturation order.
+vtc::TrimParams ReadTrimFromPrParam(const PrParam params[6]);
+
+vtc::AlphaMode ReadAlphaModeFromPrParam(const PrParam& alphaParam);
+
+vtc::TransitionParams ReadTransitionFromPrParam(const PrParam& enableParam,
+                                                const PrParam& lookParam,
+                                                const PrParam& mixParam);
+
 }  // namespace prgpu
 }  // namespace vtc
@@ -98,8 +98,11 @@ kernel void VTC_LUTApply_16f(
     float3 outRGB = mix(float3(r,g,b), lutRGB, params.intensity);
     outBuf[idx] = half4(half(outRGB.z), half(outRGB.y), half(outRGB.x), inColor.w);
 }
-// M3: 4-layer cascade. LUT buffer has layers concatenated (each 33^3*3 floats).
-// Params: pitch, width, height, layerCount, then per-layer: offset (in floats), dimension, intensity (pad).
+// M3: 4-layer cascade. LUT buffer has layers concatenated (each dim^3*3 floats, then
+// its 1D shaper when layerShaperSize is set: that many floats per channel).
+// Params: pitch, width, height, layerCount, then per-layer: offset (in floats), dimension, intensity,
+// then the shaper sizes, then whether the frame is premultiplied (graded unpremultiplied, transparent
+// pixels stay black).
 struct MultiLUTParams {
     int pitch;
     int width;
@@ -117,8 +120,28 @@ struct MultiLUTParams {
     int layer3Offset;
     int layer3Dim;
     float layer3Intensity;
+    int layerShaperSize[4];
+    int premultiplied;
 };
 
+inline float applyShaper(device const float* curve, int n, float v) {
+    float x = clamp(v, 0.0f, 1.0f) * float(n - 1);
+    int i0 = int(x);
+    int i1 = min(i0 + 1, n - 1);
+    return mix(curve[i0], curve[i1], x - float(i0));
+}
+
+// sampleLUT3D behind the layer's shaper, if it has one.
+inline float3 sampleShapedLUT3D(device const float* lut, int dim, int shaperSize, float r, float g, float b) {
+    if (shaperSize > 0) {
+        device const float* curve = lut + dim * dim * dim * 3;
+        r = applyShaper(curve, shaperSize, r);
+        g = applyShaper(curve + shaperSize, shaperSize, g);
+        b = applyShaper(curve + 2 * shaperSize, shaperSize, b);
+    }
+    return sampleLUT3D(lut, dim, r, g, b);
+}
+
 kernel void VTC_LUTApplyMulti_32f(
     device const float4* inBuf   [[buffer(0)]],
     device       float4* outBuf  [[buffer(1)]],
@@ -129,23 +152,28 @@ kernel void VTC_LUTApplyMulti_32f(
     if (gid.x >= uint(p.width) || gid.y >= uint(p.height)) return;
     uint idx = gid.y * uint(p.pitch) + gid.x;
     float4 c = inBuf[idx];
-    float r = c.z, g = c.y, b = c.x;
+    float a = clamp(c.w, 0.0f, 1.0f);
+    float unpremul = p.premultiplied != 0 ? (a > 0.0f ? 1.0f / a : 0.0f) : 1.0f;
+    float r = c.z * unpremul, g = c.y * unpremul, b = c.x * unpremul;
     if (p.layerCount >= 1 && p.layer0Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer0Offset, p.layer0Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer0Offset, p.layer0Dim, p.layerShaperSize[0], r, g, b);
         r = mix(r, lutRGB.x, p.layer0Intensity); g = mix(g, lutRGB.y, p.layer0Intensity); b = mix(b, lutRGB.z, p.layer0Intensity);
     }
     if (p.layerCount >= 2 && p.layer1Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer1Offset, p.layer1Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer1Offset, p.layer1Dim, p.layerShaperSize[1], r, g, b);
         r = mix(r, lutRGB.x, p.layer1Intensity); g = mix(g, lutRGB.y, p.layer1Intensity); b = mix(b, lutRGB.z, p.layer1Intensity);
     }
     if (p.layerCount >= 3 && p.layer2Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer2Offset, p.layer2Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer2Offset, p.layer2Dim, p.layerShaperSize[2], r, g, b);
         r = mix(r, lutRGB.x, p.layer2Intensity); g = mix(g, lutRGB.y, p.layer2Intensity); b = mix(b, lutRGB.z, p.layer2Intensity);
     }
     if (p.layerCount >= 4 && p.layer3Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer3Offset, p.layer3Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer3Offset, p.layer3Dim, p.layerShaperSize[3], r, g, b);
         r = mix(r, lutRGB.x, p.layer3Intensity); g = mix(g, lutRGB.y, p.layer3Intensity); b = mix(b, lutRGB.z, p.layer3Intensity);
     }
+    if (p.premultiplied != 0) {
+        r = clamp(r, 0.0f, 1.0f) * a; g = clamp(g, 0.0f, 1.0f) * a; b = clamp(b, 0.0f, 1.0f) * a;
+    }
     outBuf[idx] = float4(b, g, r, c.w);
 }
 
@@ -159,23 +187,28 @@ kernel void VTC_LUTApplyMulti_16f(
     if (gid.x >= uint(p.width) || gid.y >= uint(p.height)) return;
     uint idx = gid.y * uint(p.pitch) + gid.x;
     half4 inC = inBuf[idx];
-    float r = float(inC.z), g = float(inC.y), b = float(inC.x);
+    float a = clamp(float(inC.w), 0.0f, 1.0f);
+    float unpremul = p.premultiplied != 0 ? (a > 0.0f ? 1.0f / a : 0.0f) : 1.0f;
+    float r = float(inC.z) * unpremul, g = float(inC.y) * unpremul, b = float(inC.x) * unpremul;
     if (p.layerCount >= 1 && p.layer0Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer0Offset, p.layer0Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer0Offset, p.layer0Dim, p.layerShaperSize[0], r, g, b);
         r = mix(r, lutRGB.x, p.layer0Intensity); g = mix(g, lutRGB.y, p.layer0Intensity); b = mix(b, lutRGB.z, p.layer0Intensity);
     }
     if (p.layerCount >= 2 && p.layer1Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer1Offset, p.layer1Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer1Offset, p.layer1Dim, p.layerShaperSize[1], r, g, b);
         r = mix(r, lutRGB.x, p.layer1Intensity); g = mix(g, lutRGB.y, p.layer1Intensity); b = mix(b, lutRGB.z, p.layer1Intensity);
     }
     if (p.layerCount >= 3 && p.layer2Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer2Offset, p.layer2Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer2Offset, p.layer2Dim, p.layerShaperSize[2], r, g, b);
         r = mix(r, lutRGB.x, p.layer2Intensity); g = mix(g, lutRGB.y, p.layer2Intensity); b = mix(b, lutRGB.z, p.layer2Intensity);
     }
     if (p.layerCount >= 4 && p.layer3Dim > 0) {
-        float3 lutRGB = sampleLUT3D(lutBuf + p.layer3Offset, p.layer3Dim, r, g, b);
+        float3 lutRGB = sampleShapedLUT3D(lutBuf + p.layer3Offset, p.layer3Dim, p.layerShaperSize[3], r, g, b);
         r = mix(r, lutRGB.x, p.layer3Intensity); g = mix(g, lutRGB.y, p.layer3Intensity); b = mix(b, lutRGB.z, p.layer3Intensity);
     }
+    if (p.premultiplied != 0) {
+        r = clamp(r, 0.0f, 1.0f) * a; g = clamp(g, 0.0f, 1.0f) * a; b = clamp(b, 0.0f, 1.0f) * a;
+    }
     outBuf[idx] = half4(half(b), half(g), half(r), inC.w);
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../../Shared/VTC_Params.h"
+
 // Full parity with AdobePF params layout.
 // Param 0 = input.
 namespace vtc {
@@ -44,6 +46,23 @@ enum PrGPUParamID : int {
     kParam_AccentIntensity,
     kParam_AccentTopicEnd,
 
+    kParam_TrimTopic,
+    kParam_TrimExposure,
+    kParam_TrimTemperature,
+    kParam_TrimTint,
+    kParam_TrimSaturation,
+    kParam_TrimOutputGain,
+    kParam_TrimOutputSaturation,
+    kParam_TrimTopicEnd,
+
+    kParam_AlphaMode,
+
+    kParam_TransitionTopic,
+    kParam_TransitionEnable,
+    kParam_TransitionLook,
+    kParam_TransitionMix,
+    kParam_TransitionTopicEnd,
+
     kParam_Count
 };
 
@@ -58,6 +77,9 @@ struct PrGPUParamsSnapshot {
     LayerParams creative;
     LayerParams secondary;
     LayerParams accent;
+    vtc::TrimParams trim;
+    vtc::AlphaMode alphaMode = vtc::AlphaMode::kStraight;
+    vtc::TransitionParams transition;
 };
 
 }  // namespace prgpu
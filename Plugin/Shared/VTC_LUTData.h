@@ -1,21 +1,41 @@
 #pragma once
 
+#include <cstdint>
+
 namespace vtc {
 
+// What vtc_lut_baker measured on a lattice, stored with the built-in tables
+// so the plugin picks kernels without scanning them. In lattice coordinates
+// (behind the shaper); errors are the largest node deviation per channel.
+struct LUTAnalysis {
+    float identityError;   // of the lattice alone: a shaped LUT is never the identity
+    float separableError;  // from the curves along the three axes through black
+    float affineError;     // from matrix/offset, the least-squares affine fit
+    float matrix[3][3];
+    float offset[3];
+    float maxGradient;  // steepest output change between neighbouring nodes, per unit input
+    float outputMin[3];
+    float outputMax[3];
+    std::uint64_t contentHash;  // FNV-1a over lattice and shaper
+};
+
 struct LUT3D {
     const float* data;
     int dimension;
+    // Optional per-channel input curve: shaperSize entries each for r, g, b,
+    // mapping [0,1] input to [0,1] lattice coordinate.
+    const float* shaper = nullptr;
+    int shaperSize = 0;
+    const LUTAnalysis* analysis = nullptr;  // baked tables only
 };
 
-constexpr int kLUTDim = 33;
-
 extern const LUT3D kLogLUTs[];
 extern const int kLogLUTCount;
 
 extern const LUT3D kRec709LUTs[];
 extern const int kRec709LUTCount;
 
-inline const char* const kLogLUTNames[] = {
+inline constexpr const char* kLogLUTNames[] = {
     "Convert Sony",
     "Dark Forest",
     "Amethyst",
@@ -25,7 +45,7 @@ inline const char* const kLogLUTNames[] = {
     "Convert RED",
 };
 
-inline const char* const kRec709LUTNames[] = {
+inline constexpr const char* kRec709LUTNames[] = {
     "VTC Blue Shadows",
     "VTC Brown Tone",
     "VTC Cinematic Contrast",
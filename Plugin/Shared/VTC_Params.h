@@ -43,6 +43,23 @@ enum ParamID : int32_t {
     kParam_AccentIntensity,
     kParam_AccentTopicEnd,
 
+    kParam_TrimTopic,
+    kParam_TrimExposure,
+    kParam_TrimTemperature,
+    kParam_TrimTint,
+    kParam_TrimSaturation,
+    kParam_TrimOutputGain,
+    kParam_TrimOutputSaturation,
+    kParam_TrimTopicEnd,
+
+    kParam_AlphaMode,
+
+    kParam_TransitionTopic,
+    kParam_TransitionEnable,
+    kParam_TransitionLook,
+    kParam_TransitionMix,
+    kParam_TransitionTopicEnd,
+
     kParam_Count
 };
 
@@ -52,11 +69,50 @@ struct LayerParams {
     float intensity = 1.0f;
 };
 
+enum class LayerSlot : int {
+    kLogConvert = 0,
+    kCreative,
+    kSecondary,
+    kAccent,
+};
+
+// Input trims ahead of the first LUT and an output trim after the last. They
+// are folded into the stack's lattice rather than run as passes of their own;
+// the defaults leave the stack untouched.
+struct TrimParams {
+    float exposure    = 0.0f;  // stops
+    float temperature = 0.0f;  // -100 (cooler) .. 100 (warmer)
+    float tint        = 0.0f;  // -100 (greener) .. 100 (more magenta)
+    float saturation  = 1.0f;  // 0 .. 2
+    float outputGain  = 1.0f;  // 0 .. 2
+    float outputSaturation = 1.0f;  // 0 .. 2
+};
+
+// How the frame's color relates to its alpha. A premultiplied frame is
+// graded unpremultiplied and premultiplied again in the same pass, so
+// graphics need no Unmultiply / Premultiply effects around the look.
+enum class AlphaMode : int {
+    kStraight = 0,
+    kPremultiplied,
+};
+
+// A crossfade from the creative look to `toLutIndex` (Rec709 table) as `mix`
+// goes from 0 to 1, the rest of the stack unchanged. Both stacks are blended
+// at the lattice nodes, so every frame of the fade is still one lookup.
+struct TransitionParams {
+    bool enabled   = false;
+    int  toLutIndex = -1;
+    float mix      = 0.0f;  // 0 .. 1
+};
+
 struct ParamsSnapshot {
     LayerParams logConvert;
     LayerParams creative;
     LayerParams secondary;
     LayerParams accent;
+    TrimParams trim;
+    AlphaMode alphaMode = AlphaMode::kStraight;
+    TransitionParams transition;
 };
 
 }  // namespace vtc
@@ -0,0 +1,24 @@
+#!/bin/bash
+# Builds Tests/vtc_core_tests.cpp against the portable Core sources (no GPU
+# backends, no generated LUT tables: the test brings fixtures) and runs it.
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+OUT="${TMPDIR:-/tmp}/vtc_core_tests"
+
+CORE=()
+for f in "$ROOT"/Plugin/Core/*.cpp; do
+    case "$f" in
+        *Cuda*|*OpenCL*|*RenderBackend*|*_Gen.cpp) ;;
+        *) CORE+=("$f") ;;
+    esac
+done
+
+echo "── Compile ──"
+"${CXX:-clang++}" -std=c++17 -O2 -pthread -Wall \
+    -I"$ROOT/Plugin/Shared" -I"$ROOT/Plugin/Core" \
+    "$ROOT/Tests/vtc_core_tests.cpp" "${CORE[@]}" \
+    -o "$OUT"
+
+echo "── Run ──"
+"$OUT"
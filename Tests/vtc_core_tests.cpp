@@ -0,0 +1,456 @@
+// Regression checks for the portable Core: composite baking, transitions,
+// premultiplied alpha, .cube and .vtclut round trips, the shared compute
+// cache, the cache budget and user LUT slots. No GPU and no host SDK. The
+// built-in tables are small fixtures defined here in place of the ones
+// vtc_lut_baker generates, so the checks run without the LUT folder.
+//
+//   Tests/run_core_tests.sh
+//
+// Prints one line per check and exits non-zero if any failed.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Plugin/Core/VTC_CacheBudget.h"
+#include "../Plugin/Core/VTC_ComputeCache.h"
+#include "../Plugin/Core/VTC_CubeLoader.h"
+#include "../Plugin/Core/VTC_LUTKernel.h"
+#include "../Plugin/Core/VTC_LUTLibrary.h"
+#include "../Plugin/Core/VTC_LUTPack.h"
+#include "../Plugin/Core/VTC_LUTSampling.h"
+#include "../Plugin/Core/VTC_StackBake.h"
+
+// ── Built-in fixtures ──
+//
+// Smooth, non-separable looks that lift black, so neither a fast structural
+// path nor a premultiplied shortcut can hide a wrong result.
+
+namespace vtc {
+
+namespace {
+
+constexpr int kFixtureDim = 17;
+constexpr int kFixtureValues = kFixtureDim * kFixtureDim * kFixtureDim * 3;
+
+float g_logData[7][kFixtureValues];
+float g_rec709Data[33][kFixtureValues];
+
+void fillFixture(float* out, int k) {
+    const float scale = 1.0f / (kFixtureDim - 1);
+    for (int b = 0, i = 0; b < kFixtureDim; ++b) {
+        for (int g = 0; g < kFixtureDim; ++g) {
+            for (int r = 0; r < kFixtureDim; ++r, i += 3) {
+                const float R = r * scale, G = g * scale, B = b * scale;
+                out[i + 0] = clamp01(0.03f + 0.92f * std::pow(R, 1.0f + 0.04f * (k % 9)) + 0.04f * B * G);
+                out[i + 1] = clamp01(0.02f + 0.9f * G + 0.05f * std::sin(3.0f * R + static_cast<float>(k)));
+                out[i + 2] = clamp01(0.04f + 0.9f * std::pow(B, 1.0f - 0.02f * (k % 7)) + 0.03f * R);
+            }
+        }
+    }
+}
+
+// Runs before main, so before anything reads the tables.
+const bool g_fixturesFilled = [] {
+    for (int k = 0; k < 7; ++k) fillFixture(g_logData[k], k);
+    for (int k = 0; k < 33; ++k) fillFixture(g_rec709Data[k], k + 3);
+    return true;
+}();
+
+}  // namespace
+
+#define VTC_FIXTURE(table, i) LUT3D{table[i], kFixtureDim}
+#define VTC_FIXTURE_4(table, i) \
+    VTC_FIXTURE(table, i), VTC_FIXTURE(table, i + 1), VTC_FIXTURE(table, i + 2), VTC_FIXTURE(table, i + 3)
+
+const LUT3D kLogLUTs[] = {
+    VTC_FIXTURE_4(g_logData, 0), VTC_FIXTURE(g_logData, 4), VTC_FIXTURE(g_logData, 5), VTC_FIXTURE(g_logData, 6),
+};
+const int kLogLUTCount = 7;
+
+const LUT3D kRec709LUTs[] = {
+    VTC_FIXTURE_4(g_rec709Data, 0),  VTC_FIXTURE_4(g_rec709Data, 4),  VTC_FIXTURE_4(g_rec709Data, 8),
+    VTC_FIXTURE_4(g_rec709Data, 12), VTC_FIXTURE_4(g_rec709Data, 16), VTC_FIXTURE_4(g_rec709Data, 20),
+    VTC_FIXTURE_4(g_rec709Data, 24), VTC_FIXTURE_4(g_rec709Data, 28), VTC_FIXTURE(g_rec709Data, 32),
+};
+const int kRec709LUTCount = 33;
+
+#undef VTC_FIXTURE_4
+#undef VTC_FIXTURE
+
+}  // namespace vtc
+
+using namespace vtc;
+
+namespace {
+
+int g_failed = 0;
+
+void expect(bool ok, const char* format, ...) {
+    std::va_list args;
+    va_start(args, format);
+    std::printf("%s  ", ok ? "ok  " : "FAIL");
+    std::vprintf(format, args);
+    std::printf("\n");
+    va_end(args);
+    if (!ok) ++g_failed;
+}
+
+std::string g_tmp;  // scratch folder, removed at exit
+
+// ── Frames ──
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 64;
+
+struct Image {
+    std::vector<float> pixels = std::vector<float>(kWidth * kHeight * 4);
+    FrameDesc desc() { return {pixels.data(), kWidth, kHeight, kWidth * 16, FrameFormat::kRGBA_32f}; }
+};
+
+// Deterministic colours spread over the cube, alpha opaque.
+Image testImage() {
+    Image image;
+    for (std::size_t i = 0; i < image.pixels.size(); ++i) {
+        image.pixels[i] = i % 4 == 3 ? 1.0f : static_cast<float>(i * 37 % 101) / 100.0f;
+    }
+    return image;
+}
+
+Image render(const ParamsSnapshot& params, Image src) {
+    Image dst;
+    FrameDesc srcDesc = src.desc();
+    FrameDesc dstDesc = dst.desc();
+    ProcessFrameCPU(params, srcDesc, dstDesc);
+    return dst;
+}
+
+// ── Rendering ──
+
+// The composite of several layers against applying each layer in turn, as
+// the single-layer path does.
+void compositeMatchesLayers() {
+    ParamsSnapshot params;
+    params.logConvert = {true, 2, 1.0f};
+    params.creative = {true, 5, 0.8f};
+    params.secondary = {true, 9, 0.5f};
+    params.accent = {true, 12, 0.2f};
+    Image src = testImage();
+    const Image dst = render(params, src);
+
+    const ResolvedStack stack = ResolveStack(params);
+    float maxError = 0.0f;
+    for (int i = 0; i < kWidth * kHeight; ++i) {
+        RGB c{src.pixels[i * 4], src.pixels[i * 4 + 1], src.pixels[i * 4 + 2]};
+        for (int l = 0; l < stack.count; ++l) {
+            const ResolvedLayer layer = ResolveLayer(*stack.layers[l].lut, stack.layers[l].intensity);
+            const RGB o = sampleLUTFast(layer, c.r, c.g, c.b);
+            c = {lerp(c.r, o.r, layer.intensity), lerp(c.g, o.g, layer.intensity), lerp(c.b, o.b, layer.intensity)};
+        }
+        const float ref[3] = {clamp01(c.r), clamp01(c.g), clamp01(c.b)};
+        for (int ch = 0; ch < 3; ++ch) maxError = std::max(maxError, std::fabs(ref[ch] - dst.pixels[i * 4 + ch]));
+    }
+    expect(stack.NeedsComposite() && maxError < 0.005f, "composite matches per-layer application (max error %.4f)",
+           maxError);
+}
+
+// A transition renders the two stacks blended: its ends are the stacks
+// themselves and every mix between is their blend.
+void transitionBlendsRenders() {
+    ParamsSnapshot from;
+    from.logConvert = {true, 1, 1.0f};
+    from.creative = {true, 2, 0.8f};
+    ParamsSnapshot to = from;
+    to.creative.lutIndex = 6;
+    const Image src = testImage();
+    const Image a = render(from, src);
+    const Image b = render(to, src);
+    float distance = 0.0f;
+    for (std::size_t i = 0; i < a.pixels.size(); ++i) {
+        distance = std::max(distance, std::fabs(a.pixels[i] - b.pixels[i]));
+    }
+    expect(distance > 0.01f, "transition ends differ (by up to %.3f)", distance);
+
+    for (float mix : {0.0f, 0.5f, 1.0f}) {
+        ParamsSnapshot params = from;
+        params.transition = {true, to.creative.lutIndex, mix};
+        const float t = mix > 0.0f && mix < 1.0f ? ResolveStack(params).mix : mix;  // as quantized
+        const Image m = render(params, src);
+        float maxError = 0.0f;
+        for (std::size_t i = 0; i < m.pixels.size(); ++i) {
+            if (i % 4 == 3) continue;
+            maxError = std::max(maxError, std::fabs(lerp(a.pixels[i], b.pixels[i], t) - m.pixels[i]));
+        }
+        expect(maxError < 0.005f, "transition at mix %.2f is the blend of both renders (max error %.4f)", mix,
+               maxError);
+    }
+}
+
+// Premultiplied pixels with zero alpha carry no colour and must stay black
+// even through a look that lifts black.
+void premultipliedZeroAlpha() {
+    ParamsSnapshot params;
+    params.creative = {true, 4, 1.0f};
+    params.trim.exposure = 0.5f;
+    params.alphaMode = AlphaMode::kPremultiplied;
+    Image src = testImage();
+    for (std::size_t i = 0; i < src.pixels.size(); i += 4) {
+        const float alpha = static_cast<float>(i / 4 % 5) / 4.0f;
+        for (int ch = 0; ch < 4; ++ch) src.pixels[i + ch] = ch == 3 ? alpha : src.pixels[i + ch] * alpha;
+    }
+    const Image dst = render(params, src);
+    int nonZero = 0;
+    for (std::size_t i = 0; i < dst.pixels.size(); i += 4) {
+        if (src.pixels[i + 3] != 0.0f) continue;
+        for (int ch = 0; ch < 4; ++ch) nonZero += dst.pixels[i + ch] != 0.0f;
+    }
+    expect(nonZero == 0, "premultiplied alpha 0 renders zero (%d non-zero channels)", nonZero);
+}
+
+// ── LUT files ──
+
+void cubeRoundTrip() {
+    const float* lut = g_rec709Data[7];
+    std::string text = "TITLE \"fixture\"\nLUT_3D_SIZE 17\n";
+    char line[64];
+    for (int i = 0; i < kFixtureValues; i += 3) {
+        std::snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", lut[i], lut[i + 1], lut[i + 2]);
+        text += line;
+    }
+    std::vector<float> data;
+    int dimension = 0;
+    std::string error;
+    const bool parsed = ParseCube(text.data(), text.size(), data, dimension, &error);
+    float maxError = 0.0f;
+    for (std::size_t i = 0; parsed && i < data.size(); ++i) maxError = std::max(maxError, std::fabs(data[i] - lut[i]));
+    expect(parsed && dimension == kFixtureDim && data.size() == kFixtureValues && maxError <= 1e-6f,
+           ".cube parses back to its lattice (max error %.2g%s%s)", maxError, error.empty() ? "" : ", ",
+           error.c_str());
+}
+
+// Largest distance from the identity lattice, the scale of the delta
+// encodings.
+float maxResidual(const float* data) {
+    float residual = 0.0f;
+    for (int i = 0; i < kFixtureValues; ++i) {
+        const int node = i / 3;
+        const int axis[3] = {node % kFixtureDim, node / kFixtureDim % kFixtureDim,
+                             node / (kFixtureDim * kFixtureDim)};
+        residual = std::max(residual, std::fabs(data[i] - axis[i % 3] / static_cast<float>(kFixtureDim - 1)));
+    }
+    return residual;
+}
+
+void packRoundTrip() {
+    const float* lut = g_rec709Data[11];
+    const float lo = *std::min_element(lut, lut + kFixtureValues);
+    const float hi = *std::max_element(lut, lut + kFixtureValues);
+    const float residual = maxResidual(lut);
+    struct Case {
+        LUTPrecision precision;
+        const char* name;
+        float tolerance;  // half a quantization step
+    };
+    const Case cases[] = {
+        {LUTPrecision::kF32, "f32", 0.0f},
+        {LUTPrecision::kF16, "f16", 0.5f / 2048.0f},
+        {LUTPrecision::kU16, "u16", 0.5f * (hi - lo) / 65535.0f + 1e-6f},
+        {LUTPrecision::kDelta8, "delta8", 0.5f * residual / 127.0f + 1e-6f},
+        {LUTPrecision::kDelta16, "delta16", 0.5f * residual / 32767.0f + 1e-6f},
+    };
+    const std::string path = g_tmp + "/roundtrip.vtclut";
+    for (const Case& c : cases) {
+        LUTPackItem item;
+        item.id = LUTLibrary::LUTId(LUTTable::kRec709, 11);
+        item.name = "fixture";
+        item.data = lut;
+        item.dimension = kFixtureDim;
+        item.precision = c.precision;
+        std::string error;
+        const bool written = WriteLUTPack(path, {item}, {}, &error);
+        std::shared_ptr<LUTPack> pack = written ? LUTPack::Open(path, &error) : nullptr;
+        const LUT3D* read = pack && pack->Count() == 1 ? pack->Get(0) : nullptr;
+        float maxError = read ? 0.0f : INFINITY;
+        for (int i = 0; read && i < kFixtureValues; ++i) {
+            maxError = std::max(maxError, std::fabs(read->data[i] - lut[i]));
+        }
+        expect(read && read->dimension == kFixtureDim && pack->Entry(0).name == "fixture" && maxError <= c.tolerance,
+               ".vtclut %s round-trips (max error %.2g, bound %.2g%s%s)", c.name, maxError, c.tolerance,
+               error.empty() ? "" : ", ", error.c_str());
+    }
+    std::remove(path.c_str());
+}
+
+// ── Caches ──
+
+// Only bakes in flight are shared, so the threads start together on a bake
+// large enough to still be running when the last one asks.
+void computeCacheDedupes() {
+    constexpr int kDimension = 65;
+    InProcessComputeCache cache;
+    ParamsSnapshot params;
+    params.logConvert = {true, 0, 1.0f};
+    params.creative = {true, 3, 0.6f};
+    PurgeCaches();
+    std::vector<std::shared_ptr<const CompositeLUT>> results(8);
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i] {
+            while (!go.load()) std::this_thread::yield();
+            results[i] = cache.AcquireComposite(params, kDimension);
+        });
+    }
+    go = true;
+    for (std::thread& t : threads) t.join();
+    const bool shared = results[0] && std::all_of(results.begin(), results.end(),
+                                                  [&](const auto& r) { return r == results[0]; });
+    expect(shared && cache.ComputeCount() == 1, "concurrent acquires share one bake (%llu bakes)",
+           static_cast<unsigned long long>(cache.ComputeCount()));
+}
+
+// Entries stamped with CacheBudget ticks; evictions are recorded in order.
+class FakeCache final : public BudgetedCache {
+public:
+    FakeCache(std::vector<int>& evicted) : evicted_(evicted) { CacheBudget::Shared().Register(this); }
+    ~FakeCache() override {
+        Purge();
+        CacheBudget::Shared().Unregister(this);
+    }
+
+    void Add(int id, std::size_t bytes) {
+        entries_.push_back({id, bytes, CacheBudget::Shared().Tick()});
+        CacheBudget::Shared().Charge(bytes);
+        CacheBudget::Shared().Enforce();
+    }
+    void Use(int id) {
+        for (Entry& e : entries_) {
+            if (e.id == id) e.lastUse = CacheBudget::Shared().Tick();
+        }
+    }
+
+    bool OldestUse(std::uint64_t& tick) override {
+        if (entries_.empty()) return false;
+        tick = oldest()->lastUse;
+        return true;
+    }
+    std::size_t EvictOldest() override {
+        if (entries_.empty()) return 0;
+        auto it = oldest();
+        const std::size_t bytes = it->bytes;
+        evicted_.push_back(it->id);
+        entries_.erase(it);
+        CacheBudget::Shared().Release(bytes);
+        return bytes;
+    }
+    void Purge() override {
+        while (!entries_.empty()) EvictOldest();
+    }
+
+private:
+    struct Entry {
+        int id;
+        std::size_t bytes;
+        std::uint64_t lastUse;
+    };
+    std::vector<Entry>::iterator oldest() {
+        return std::min_element(entries_.begin(), entries_.end(),
+                                [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<int>& evicted_;
+};
+
+void cacheBudgetEvictsLRU() {
+    CacheBudget& budget = CacheBudget::Shared();
+    PurgeCaches();  // earlier checks' composites would be older than anything here
+    const std::size_t limit = budget.LimitBytes();
+    constexpr std::size_t kEntry = 1u << 20;
+    budget.SetLimitBytes(budget.UsedBytes() + 3 * kEntry);
+
+    std::vector<int> evicted;
+    {
+        FakeCache a(evicted), b(evicted);
+        a.Add(1, kEntry);
+        b.Add(2, kEntry);
+        a.Add(3, kEntry);
+        a.Use(1);          // 2 is now the least recently used, then 3
+        b.Add(4, kEntry);  // over by one
+        b.Add(5, kEntry);
+        expect(evicted == std::vector<int>({2, 3}), "cache budget evicts least recently used first (%d, %d)",
+               evicted.size() > 0 ? evicted[0] : -1, evicted.size() > 1 ? evicted[1] : -1);
+    }
+    budget.SetLimitBytes(limit);
+}
+
+// ── User LUT folder ──
+
+void writeCube(const std::string& path, float gain) {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return;
+    std::fprintf(f, "LUT_3D_SIZE 2\n");
+    for (int i = 0; i < 8; ++i) std::fprintf(f, "%f %d %d\n", (i & 1) * gain, (i >> 1) & 1, (i >> 2) & 1);
+    std::fclose(f);
+}
+
+// A look keeps its popup index when others are added or removed, since
+// saved projects store the index.
+void userSlotsStable() {
+    LUTLibrary& library = LUTLibrary::Shared();
+    const std::string dir = g_tmp + "/luts/Rec 709";
+    writeCube(dir + "/Bravo.cube", 0.5f);
+    writeCube(dir + "/Delta.cube", 0.7f);
+    library.Reload();
+    const int bravo = library.Find(LUTTable::kRec709, "Bravo");
+    const int delta = library.Find(LUTTable::kRec709, "Delta");
+
+    writeCube(dir + "/Alpha.cube", 0.3f);  // sorts first
+    std::remove((dir + "/Delta.cube").c_str());
+    library.Reload();
+    const int alpha = library.Find(LUTTable::kRec709, "Alpha");
+    expect(bravo >= 0 && delta >= 0 && library.Find(LUTTable::kRec709, "Bravo") == bravo &&
+               library.Get(LUTTable::kRec709, delta) == nullptr && alpha > std::max(bravo, delta) &&
+               library.Get(LUTTable::kRec709, alpha) != nullptr,
+           "user LUT indices survive a reload (Bravo %d, Delta %d removed, Alpha %d appended)", bravo, delta, alpha);
+}
+
+}  // namespace
+
+int main() {
+    char dir[] = "/tmp/vtc_core_tests.XXXXXX";
+    if (!::mkdtemp(dir)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    g_tmp = dir;
+    std::system(("mkdir -p '" + g_tmp + "/luts/Rec 709' '" + g_tmp + "/cache'").c_str());
+    // Before anything opens the library: it reads these once.
+    ::setenv("VTC_USER_LUT_DIR", (g_tmp + "/luts").c_str(), 1);
+    ::setenv("VTC_LUT_CACHE_DIR", (g_tmp + "/cache").c_str(), 1);
+    ::setenv("VTC_LUT_WATCH", "0", 1);
+
+    compositeMatchesLayers();
+    transitionBlendsRenders();
+    premultipliedZeroAlpha();
+    cubeRoundTrip();
+    packRoundTrip();
+    computeCacheDedupes();
+    cacheBudgetEvictsLRU();
+    userSlotsStable();
+
+    std::system(("rm -rf '" + g_tmp + "'").c_str());
+    std::printf("%d failed\n", g_failed);
+    return g_failed == 0 ? 0 : 1;
+}
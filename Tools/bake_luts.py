@@ -1,10 +1,27 @@
 #!/usr/bin/env python3
-"""Bake deterministic .cube LUT files into generated C++ sources."""
+"""Bake deterministic .cube LUT files into generated C++ sources and the
+binary blobs they embed.
+
+With --pack, also write the same LUTs as a .vtclut pack (layout in
+Plugin/Core/VTC_LUTPack.h).
+
+Tools/vtc_lut_baker.cpp produces the same outputs natively, in parallel and
+with the engine's interpolation; prefer it for large libraries. Only it
+fits 1D shapers (--shaper); every lattice written here is uniform. Only it
+stores each LUT's analysis (LUTAnalysis) with the tables; the plugin
+measures tables baked here when it first loads them.
+"""
+import argparse
 import glob
 import os
+import struct
 import sys
+import tempfile
+import zlib
 
-TARGET_DIM = 33
+# Sizes kept as they are; anything else is resampled up to the next one.
+# Matches kNativeLUTDims in Plugin/Core/VTC_LUTKernel.h.
+NATIVE_DIMS = (17, 33, 65, 129)
 
 LUT_DIR = "/Users/victorbarbaian/Local Projects/VTC/VTC Pack/LUTs"
 LOG_DIR = os.path.join(LUT_DIR, "Log")
@@ -123,31 +140,151 @@ def resample(dim_src, data_src, dim_dst):
     return result
 
 
-def write_array(f, var_name, data):
-    n = len(data)
-    f.write(f"const float {var_name}[{n}] = {{\n")
-    for i in range(0, n, 9):
-        vals = ",".join(f"{v:.6f}f" for v in data[i:i + 9])
-        f.write(f"{vals},\n")
-    f.write("};\n\n")
+def write_blob(path, luts):
+    """Writes the lattices as raw little-endian f32, each starting on a
+    64-byte boundary. Returns their offsets in floats."""
+    offsets = []
+    with open(path, "wb") as f:
+        for data in luts:
+            offsets.append(f.tell() // 4)
+            payload = struct.pack(f"<{len(data)}f", *data)
+            f.write(payload + b"\0" * ((-len(payload)) % 64))
+    return offsets
+
+
+def write_table_source(path, blob_path, blob_symbol, table, count_var, luts):
+    """luts: [(name, sanitized, dim, data)]"""
+    offsets = write_blob(blob_path, [data for _, _, _, data in luts])
+    # Relative to the source's folder, which the build passes to the
+    # assembler (-Wa,-I), so the source does not depend on the checkout path.
+    blob_rel = os.path.relpath(blob_path, os.path.dirname(os.path.abspath(path)))
+    with open(path, "w", encoding="utf-8") as f:
+        f.write('#include "../Shared/VTC_LUTData.h"\n#include "VTC_Incbin.h"\n\n')
+        f.write(f'VTC_INCBIN({blob_symbol}, "{blob_rel}");\n\n')
+        f.write("namespace vtc {\n\n")
+        f.write(f"const LUT3D {table}[] = {{\n")
+        for (name, _, dim, _), offset in zip(luts, offsets):
+            f.write(f"    {{{blob_symbol} + {offset}, {dim}}},  // {name}\n")
+        f.write("};\n\n")
+        f.write(f"const int {count_var} = {len(luts)};\n\n")
+        f.write("}  // namespace vtc\n")
 
 
 def selected_popup(total):
     return "|".join([f"0/{total}"] + [f"{i}/{total}" for i in range(1, total + 1)])
 
 
-def load_and_resample(filepath, name):
+PACK_MAGIC = b"VTCLUTPK"
+PACK_VERSION = 2
+PACK_ALIGN = 64
+PACK_HEADER = struct.Struct("<8sIIQQQqII8x")
+PACK_ENTRY = struct.Struct("<IHBxffIIQIII4x")
+PRECISIONS = {"f32": 0, "f16": 1, "u16": 2, "delta8": 3, "delta16": 4}
+DELTA_MAX = {"delta8": 127, "delta16": 32767}
+
+
+def align_up(v):
+    return (v + PACK_ALIGN - 1) & ~(PACK_ALIGN - 1)
+
+
+def identity(dim):
+    """Identity lattice in the pack layout (r fastest, RGB interleaved)."""
+    step = 1.0 / (dim - 1)
+    return [c * step for b in range(dim) for g in range(dim) for r in range(dim) for c in (r, g, b)]
+
+
+def encode_payload(data, dim, precision):
+    """Returns (payload bytes, range_min, range_max, decoded values)."""
+    n = len(data)
+    if precision == "f32":
+        payload = struct.pack(f"<{n}f", *data)
+        return payload, 0.0, 1.0, struct.unpack(f"<{n}f", payload)
+    if precision == "f16":
+        payload = struct.pack(f"<{n}e", *data)
+        return payload, 0.0, 1.0, struct.unpack(f"<{n}e", payload)
+    if precision == "u16":
+        lo, hi = min(data), max(data)
+        if hi <= lo:
+            hi = lo + 1.0
+        scale = 65535.0 / (hi - lo)
+        quanta = [int(round((v - lo) * scale)) for v in data]
+        step = (hi - lo) / 65535.0
+        return struct.pack(f"<{n}H", *quanta), lo, hi, [lo + step * q for q in quanta]
+
+    # Quantized residual from identity; range_max carries the step.
+    base = identity(dim)
+    limit = DELTA_MAX[precision]
+    max_residual = max(abs(v - i) for v, i in zip(data, base))
+    step = struct.unpack("<f", struct.pack("<f", max_residual / limit if max_residual > 0 else 1.0))[0]
+    quanta = [max(-limit, min(limit, int(round((v - i) / step)))) for v, i in zip(data, base)]
+    fmt = "b" if precision == "delta8" else "h"
+    return struct.pack(f"<{n}{fmt}", *quanta), 0.0, step, [i + step * q for i, q in zip(base, quanta)]
+
+
+def write_pack(path, luts, precision):
+    """luts: [(id, name, dim, data)]. Prints the size and error report."""
+    names = [name.encode("utf-8") for _, name, _, _ in luts]
+    index_offset = PACK_HEADER.size
+    names_offset = index_offset + len(luts) * PACK_ENTRY.size
+    cursor = align_up(names_offset + sum(len(n) for n in names))
+
+    entries, payloads = [], []
+    name_cursor = names_offset
+    raw_bytes = 0
+    library_error = 0.0
+    print(f"\nPacking {len(luts)} LUTs as {precision} ...")
+    for (lut_id, label, dim, data), name in zip(luts, names):
+        payload, lo, hi, decoded = encode_payload(data, dim, precision)
+        max_error = max(abs(a - b) for a, b in zip(data, decoded))
+        library_error = max(library_error, max_error)
+        raw_bytes += len(data) * 4
+        print(f"  {label}: {len(data) * 4 / len(payload):.2f}x, max error {max_error:.2g}")
+        entries.append(PACK_ENTRY.pack(lut_id, dim, PRECISIONS[precision], lo, hi, name_cursor, len(name),
+                                       cursor, len(payload), zlib.crc32(payload), 0))
+        payloads.append(payload + b"\0" * (align_up(len(payload)) - len(payload)))
+        name_cursor += len(name)
+        cursor = align_up(cursor + len(payload))
+
+    table = b"".join(entries) + b"".join(names)
+    header = PACK_HEADER.pack(PACK_MAGIC, PACK_VERSION, len(luts), index_offset, cursor, 0, 0,
+                              zlib.crc32(table), len(table) - len(entries) * PACK_ENTRY.size)
+    padding = b"\0" * (align_up(index_offset + len(table)) - index_offset - len(table))
+    fd, tmp = tempfile.mkstemp(prefix=os.path.basename(path) + ".", dir=os.path.dirname(path) or ".")
+    os.fchmod(fd, 0o644)
+    with os.fdopen(fd, "wb") as f:
+        f.write(header + table + padding)
+        for payload in payloads:
+            f.write(payload)
+    os.replace(tmp, path)
+    print(f"  library: {raw_bytes / os.path.getsize(path):.2f}x vs raw f32, max error {library_error:.2g}")
+
+
+def native_dim(dim):
+    return next((d for d in NATIVE_DIMS if dim <= d), NATIVE_DIMS[-1])
+
+
+def load_and_resample(filepath, name, forced_dim):
+    """Returns (dim, data): the native size, or forced_dim when given."""
     print(f"  {name} ...", end=" ", flush=True)
     dim, data = read_cube(filepath)
     print(f"dim={dim}", end=" ", flush=True)
-    if dim != TARGET_DIM:
-        print("-> resample", end=" ", flush=True)
-        data = resample(dim, data, TARGET_DIM)
+    target = forced_dim or native_dim(dim)
+    if dim != target:
+        print(f"-> resample {target}", end=" ", flush=True)
+        data = resample(dim, data, target)
     print(f"OK ({len(data)} floats)")
-    return data
+    return target, data
 
 
 def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--pack", metavar="PATH", help="also write a .vtclut pack")
+    parser.add_argument("--precision", choices=sorted(PRECISIONS), default="f32",
+                        help="pack sample precision (default f32)")
+    parser.add_argument("--dim", type=int, default=0,
+                        help="resample every LUT to this size (default: keep native sizes)")
+    args = parser.parse_args()
+
     # Hard fail if any required Log LUT is missing.
     missing = [name for name in LOG_ORDER if not os.path.isfile(os.path.join(LOG_DIR, name + ".cube"))]
     if missing:
@@ -159,8 +296,8 @@ def main():
     log_luts = []
     for name in LOG_ORDER:
         cube = os.path.join(LOG_DIR, name + ".cube")
-        data = load_and_resample(cube, name)
-        log_luts.append((name, sanitize(name), data))
+        dim, data = load_and_resample(cube, name, args.dim)
+        log_luts.append((name, sanitize(name), dim, data))
 
     rec_files = sorted(
         glob.glob(os.path.join(REC_DIR, "*.cube")) + glob.glob(os.path.join(REC_DIR, "*.CUBE")),
@@ -170,55 +307,53 @@ def main():
     rec_luts = []
     for fp in rec_files:
         name = os.path.splitext(os.path.basename(fp))[0]
-        data = load_and_resample(fp, name)
-        rec_luts.append((name, sanitize(name), data))
+        dim, data = load_and_resample(fp, name, args.dim)
+        rec_luts.append((name, sanitize(name), dim, data))
 
     print(f"\nGenerating C++ ({len(log_luts)} Log + {len(rec_luts)} Rec709) ...")
 
     log_cpp = os.path.join(CORE_DIR, "VTC_LUTData_Log_Gen.cpp")
-    with open(log_cpp, "w", encoding="utf-8") as f:
-        f.write('#include "../Shared/VTC_LUTData.h"\n\nnamespace vtc {\n\n')
-        for _, sname, data in log_luts:
-            write_array(f, f"kLogLUT_{sname}", data)
-        f.write("const LUT3D kLogLUTs[] = {\n")
-        for _, sname, _ in log_luts:
-            f.write(f"    {{kLogLUT_{sname}, {TARGET_DIM}}},\n")
-        f.write("};\n\n")
-        f.write(f"const int kLogLUTCount = {len(log_luts)};\n\n")
-        f.write("}  // namespace vtc\n")
+    log_bin = os.path.join(CORE_DIR, "VTC_LUTData_Log.bin")
+    write_table_source(log_cpp, log_bin, "vtcLogLUTBlob", "kLogLUTs", "kLogLUTCount", log_luts)
 
     rec_cpp = os.path.join(CORE_DIR, "VTC_LUTData_Rec709_Gen.cpp")
-    with open(rec_cpp, "w", encoding="utf-8") as f:
-        f.write('#include "../Shared/VTC_LUTData.h"\n\nnamespace vtc {\n\n')
-        for _, sname, data in rec_luts:
-            write_array(f, f"kRecLUT_{sname}", data)
-        f.write("const LUT3D kRec709LUTs[] = {\n")
-        for _, sname, _ in rec_luts:
-            f.write(f"    {{kRecLUT_{sname}, {TARGET_DIM}}},\n")
-        f.write("};\n\n")
-        f.write(f"const int kRec709LUTCount = {len(rec_luts)};\n\n")
-        f.write("}  // namespace vtc\n")
+    rec_bin = os.path.join(CORE_DIR, "VTC_LUTData_Rec709.bin")
+    write_table_source(rec_cpp, rec_bin, "vtcRec709LUTBlob", "kRec709LUTs", "kRec709LUTCount", rec_luts)
 
     hdr = os.path.join(SHARED_DIR, "VTC_LUTData.h")
     with open(hdr, "w", encoding="utf-8") as f:
-        f.write("#pragma once\n\nnamespace vtc {\n\n")
-        f.write("struct LUT3D {\n    const float* data;\n    int dimension;\n};\n\n")
-        f.write(f"constexpr int kLUTDim = {TARGET_DIM};\n\n")
+        f.write("#pragma once\n\n#include <cstdint>\n\nnamespace vtc {\n\n")
+        f.write("// What vtc_lut_baker measured on a lattice, stored with the built-in tables\n"
+                "// so the plugin picks kernels without scanning them. In lattice coordinates\n"
+                "// (behind the shaper); errors are the largest node deviation per channel.\n"
+                "struct LUTAnalysis {\n"
+                "    float identityError;   // of the lattice alone: a shaped LUT is never the identity\n"
+                "    float separableError;  // from the curves along the three axes through black\n"
+                "    float affineError;     // from matrix/offset, the least-squares affine fit\n"
+                "    float matrix[3][3];\n    float offset[3];\n"
+                "    float maxGradient;  // steepest output change between neighbouring nodes, per unit input\n"
+                "    float outputMin[3];\n    float outputMax[3];\n"
+                "    std::uint64_t contentHash;  // FNV-1a over lattice and shaper\n};\n\n")
+        f.write("struct LUT3D {\n    const float* data;\n    int dimension;\n"
+                "    // Optional per-channel input curve: shaperSize entries each for r, g, b,\n"
+                "    // mapping [0,1] input to [0,1] lattice coordinate.\n"
+                "    const float* shaper = nullptr;\n    int shaperSize = 0;\n"
+                "    const LUTAnalysis* analysis = nullptr;  // baked tables only\n};\n\n")
         f.write("extern const LUT3D kLogLUTs[];\nextern const int kLogLUTCount;\n\n")
         f.write("extern const LUT3D kRec709LUTs[];\nextern const int kRec709LUTCount;\n\n")
 
-        f.write("inline const char* const kLogLUTNames[] = {\n")
-        for name, _, _ in log_luts:
+        f.write("inline constexpr const char* kLogLUTNames[] = {\n")
+        for name, _, _, _ in log_luts:
             f.write(f'    "{name}",\n')
         f.write("};\n\n")
 
-        f.write("inline const char* const kRec709LUTNames[] = {\n")
-        for name, _, _ in rec_luts:
+        f.write("inline constexpr const char* kRec709LUTNames[] = {\n")
+        for name, _, _, _ in rec_luts:
             f.write(f'    "{name}",\n')
         f.write("};\n\n")
 
-        log_popup = "None|" + "|".join(name for name, _, _ in log_luts)
-        rec_popup = "None|" + "|".join(name for name, _, _ in rec_luts)
+        log_popup = "None|" + "|".join(name for name, _, _, _ in log_luts)
+        rec_popup = "None|" + "|".join(name for name, _, _, _ in rec_luts)
         f.write(f'inline const char kLogPopupStr[] = "{log_popup}";\n')
         f.write(f'inline const char kRec709PopupStr[] = "{rec_popup}";\n\n')
 
@@ -226,8 +361,13 @@ def main():
         f.write(f'inline const char kRec709SelectedPopupStr[] = "{selected_popup(len(rec_luts))}";\n\n')
         f.write("}  // namespace vtc\n")
 
-    print(f"  {log_cpp} ({os.path.getsize(log_cpp) // 1048576} MB)")
-    print(f"  {rec_cpp} ({os.path.getsize(rec_cpp) // 1048576} MB)")
+    if args.pack:
+        luts = [(i, name, dim, data) for i, (name, _, dim, data) in enumerate(log_luts)]
+        luts += [(0x10000 | i, name, dim, data) for i, (name, _, dim, data) in enumerate(rec_luts)]
+        write_pack(args.pack, luts, args.precision)
+
+    print(f"  {log_cpp} + {log_bin} ({os.path.getsize(log_bin) // 1024} KB)")
+    print(f"  {rec_cpp} + {rec_bin} ({os.path.getsize(rec_bin) // 1024} KB)")
     print(f"  {hdr}")
     print(f"\nDone! Log={len(log_luts)}, Rec709={len(rec_luts)}")
 
@@ -0,0 +1,292 @@
+// Sampling benchmark for the native lattice sizes: the generic kernel vs the
+// size-specialized one, what forcing a lattice to 33^3 (the old baker
+// behaviour) costs in accuracy, what a 1D shaper adds to a 17^3 lookup, the
+// footprint, error and speed of the adaptive lattice against dense, and the
+// affine and separable fast paths against trilinear, and the analytic camera
+// conversions against their 33^3 lattices.
+//
+//   clang++ -std=c++17 -O2 -o lut_kernel_bench Tools/lut_kernel_bench.cpp
+//       Plugin/Core/VTC_AdaptiveLUT.cpp Plugin/Core/VTC_LUTStructure.cpp
+//       Plugin/Core/VTC_LogTransforms.cpp
+//   ./lut_kernel_bench [width height]
+//
+// Frames are RGB float. "smooth" is a gradient with mild noise, as in
+// footage; "random" touches the lattice uniformly and is the cache worst case.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../Plugin/Core/VTC_AdaptiveLUT.h"
+#include "../Plugin/Core/VTC_LUTKernel.h"
+#include "../Plugin/Core/VTC_LUTStructure.h"
+#include "../Plugin/Core/VTC_LogTransforms.h"
+
+using namespace vtc;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr int kIterations = 5;
+
+// A curved, channel-mixing grade: not identity, not separable.
+std::vector<float> makeLattice(int dim) {
+    std::vector<float> data(static_cast<std::size_t>(dim) * dim * dim * 3);
+    const float inv = 1.0f / static_cast<float>(dim - 1);
+    float* p = data.data();
+    for (int b = 0; b < dim; ++b) {
+        for (int g = 0; g < dim; ++g) {
+            for (int r = 0; r < dim; ++r) {
+                const float x = r * inv, y = g * inv, z = b * inv;
+                *p++ = clamp01(std::pow(x, 0.8f) * 0.9f + 0.1f * z);
+                *p++ = clamp01(0.5f - 0.5f * std::cos(3.14159265f * y) + 0.05f * x);
+                *p++ = clamp01(std::sqrt(z) * 0.85f + 0.1f * y * x);
+            }
+        }
+    }
+    return data;
+}
+
+std::vector<float> resample(const std::vector<float>& src, int srcDim, int dim) {
+    std::vector<float> out(static_cast<std::size_t>(dim) * dim * dim * 3);
+    const ResolvedLayer layer = ResolveLayer(LUT3D{src.data(), srcDim}, 1.0f);
+    const float inv = 1.0f / static_cast<float>(dim - 1);
+    float* p = out.data();
+    for (int b = 0; b < dim; ++b) {
+        for (int g = 0; g < dim; ++g) {
+            for (int r = 0; r < dim; ++r) {
+                const RGB s = sampleLUTFast(layer, r * inv, g * inv, b * inv);
+                *p++ = s.r;
+                *p++ = s.g;
+                *p++ = s.b;
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<RGB> makeFrame(int width, int height, bool random) {
+    std::vector<RGB> frame(static_cast<std::size_t>(width) * height);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            RGB& c = frame[static_cast<std::size_t>(y) * width + x];
+            if (random) {
+                c = {uni(rng), uni(rng), uni(rng)};
+            } else {
+                const float n = (uni(rng) - 0.5f) * 0.02f;
+                c = {clamp01(float(x) / width + n), clamp01(float(y) / height + n), clamp01(0.5f + n)};
+            }
+        }
+    }
+    return frame;
+}
+
+template <int Dim>
+double mpixPerSecond(const ResolvedLayer& layer, const std::vector<RGB>& frame, std::vector<RGB>& out) {
+    double best = 1e30;
+    for (int it = 0; it < kIterations; ++it) {
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < frame.size(); ++i) {
+            out[i] = sampleLUT<Dim>(layer, frame[i].r, frame[i].g, frame[i].b);
+        }
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return frame.size() / best / 1e6;
+}
+
+template <int Dim>
+void benchSize(const std::vector<RGB>& smooth, const std::vector<RGB>& random) {
+    const std::vector<float> data = makeLattice(Dim);
+    const ResolvedLayer layer = ResolveLayer(LUT3D{data.data(), Dim}, 1.0f);
+    std::vector<RGB> out(smooth.size());
+
+    std::printf("%4d^3 %7.1f KB", Dim, data.size() * sizeof(float) / 1024.0);
+    for (const std::vector<RGB>* frame : {&smooth, &random}) {
+        const double generic = mpixPerSecond<0>(layer, *frame, out);
+        const double special = mpixPerSecond<Dim>(layer, *frame, out);
+        std::printf("   %7.1f -> %7.1f Mpix/s (%.2fx)", generic, special, special / generic);
+    }
+
+    // Error of rendering through a 33^3 resample instead of the native lattice.
+    if (Dim != 33) {
+        const std::vector<float> forced = resample(data, Dim, 33);
+        const ResolvedLayer forcedLayer = ResolveLayer(LUT3D{forced.data(), 33}, 1.0f);
+        float maxError = 0.0f;
+        for (const RGB& c : random) {
+            const RGB a = sampleLUT<Dim>(layer, c.r, c.g, c.b);
+            const RGB b = sampleLUT<33>(forcedLayer, c.r, c.g, c.b);
+            maxError = std::max({maxError, std::fabs(a.r - b.r), std::fabs(a.g - b.g), std::fabs(a.b - b.b)});
+        }
+        std::printf("   forced-33 max error %.2g", maxError);
+    }
+    std::printf("\n");
+}
+
+// Same lattice with and without a per-channel shaper in front: the cost of
+// the three extra 1D lookups.
+void benchShaper(const std::vector<RGB>& smooth, const std::vector<RGB>& random) {
+    constexpr int kShaperSize = 257;
+    const std::vector<float> data = makeLattice(17);
+    std::vector<float> shaper(kShaperSize * 3);
+    for (int i = 0; i < kShaperSize * 3; ++i) {
+        shaper[i] = std::sqrt(static_cast<float>(i % kShaperSize) / (kShaperSize - 1));
+    }
+    const ResolvedLayer plain = ResolveLayer(LUT3D{data.data(), 17}, 1.0f);
+    const ResolvedLayer shaped = ResolveLayer(LUT3D{data.data(), 17, shaper.data(), kShaperSize}, 1.0f);
+    std::vector<RGB> out(smooth.size());
+
+    std::printf("  17^3 + shaper  ");
+    for (const std::vector<RGB>* frame : {&smooth, &random}) {
+        const double base = mpixPerSecond<17>(plain, *frame, out);
+        const double withShaper = mpixPerSecond<17>(shaped, *frame, out);
+        std::printf("   %7.1f -> %7.1f Mpix/s (%.2fx)", base, withShaper, withShaper / base);
+    }
+    std::printf("\n");
+}
+
+// The same lattice as dense and as an AdaptiveLUT at a few tolerances.
+template <int Dim>
+void benchAdaptive(const std::vector<RGB>& smooth, const std::vector<RGB>& random) {
+    const std::vector<float> data = makeLattice(Dim);
+    const ResolvedLayer layer = ResolveLayer(LUT3D{data.data(), Dim}, 1.0f);
+    std::vector<RGB> out(smooth.size());
+
+    for (float tolerance : {1.0f / 1024, 1.0f / 2048, 1.0f / 4096}) {
+        const auto adaptive = AdaptiveLUT::Build(LUT3D{data.data(), Dim}, tolerance);
+        float maxError = 0.0f;
+        for (const RGB& c : random) {
+            const RGB a = sampleLUT<Dim>(layer, c.r, c.g, c.b);
+            const RGB b = adaptive->Sample(c.r, c.g, c.b);
+            maxError = std::max({maxError, std::fabs(a.r - b.r), std::fabs(a.g - b.g), std::fabs(a.b - b.b)});
+        }
+        std::printf("%4d^3 adaptive 1/%-4.0f %7.1f KB (%4.1f%%) %4d bricks, max error %.2g", Dim, 1.0f / tolerance,
+                    adaptive->Bytes() / 1024.0, 100.0 * adaptive->Bytes() / (data.size() * sizeof(float)),
+                    adaptive->BrickCount(), maxError);
+        for (const std::vector<RGB>* frame : {&smooth, &random}) {
+            const double dense = mpixPerSecond<Dim>(layer, *frame, out);
+            double best = 1e30;
+            for (int it = 0; it < kIterations; ++it) {
+                const auto start = Clock::now();
+                for (std::size_t i = 0; i < frame->size(); ++i) {
+                    out[i] = adaptive->Sample((*frame)[i].r, (*frame)[i].g, (*frame)[i].b);
+                }
+                best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+            }
+            const double sparse = frame->size() / best / 1e6;
+            std::printf("   %7.1f -> %7.1f Mpix/s (%.2fx)", dense, sparse, sparse / dense);
+        }
+        std::printf("\n");
+    }
+}
+
+// A desaturating matrix and a per-channel S-curve, each as a 33^3 lattice and
+// as the structure AnalyzeStructure finds in it.
+void benchStructure(const std::vector<RGB>& smooth, const std::vector<RGB>& random) {
+    constexpr int kDim = 33;
+    std::vector<float> affine(static_cast<std::size_t>(kDim) * kDim * kDim * 3);
+    std::vector<float> separable(affine.size());
+    const float inv = 1.0f / static_cast<float>(kDim - 1);
+    for (std::size_t i = 0; i < affine.size(); i += 3) {
+        const std::size_t node = i / 3;
+        const float x = (node % kDim) * inv, y = (node / kDim % kDim) * inv, z = (node / (kDim * kDim)) * inv;
+        const float luma = 0.2126f * x + 0.7152f * y + 0.0722f * z;
+        affine[i] = lerp(luma, x, 0.5f);
+        affine[i + 1] = lerp(luma, y, 0.5f);
+        affine[i + 2] = lerp(luma, z, 0.5f);
+        separable[i] = x * x * (3.0f - 2.0f * x);
+        separable[i + 1] = y * y * (3.0f - 2.0f * y);
+        separable[i + 2] = z * z * (3.0f - 2.0f * z);
+    }
+    std::vector<RGB> out(smooth.size());
+    auto run = [&](const char* name, const std::vector<float>& data, auto apply) {
+        const ResolvedLayer layer = ResolveLayer(LUT3D{data.data(), kDim}, 1.0f);
+        const LUTStructure s = AnalyzeStructure(LUT3D{data.data(), kDim}, 1.0f / 8192.0f);
+        std::printf("%-10s      ", name);
+        for (const std::vector<RGB>* frame : {&smooth, &random}) {
+            const double lattice = mpixPerSecond<kDim>(layer, *frame, out);
+            double best = 1e30;
+            for (int it = 0; it < kIterations; ++it) {
+                const auto start = Clock::now();
+                for (std::size_t i = 0; i < frame->size(); ++i) {
+                    out[i] = apply(s, (*frame)[i].r, (*frame)[i].g, (*frame)[i].b);
+                }
+                best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+            }
+            const double fast = frame->size() / best / 1e6;
+            std::printf("   %7.1f -> %7.1f Mpix/s (%.2fx)", lattice, fast, fast / lattice);
+        }
+        std::printf("   fit error %.2g\n", s.maxError);
+    };
+    run("affine", affine, ApplyStructure<LUTClass::kAffine>);
+    run("separable", separable, ApplyStructure<LUTClass::kSeparable>);
+}
+
+// Each camera conversion baked to 33^3 at its own nodes, as the shipped LUTs
+// are, against the closed form. The error is the lattice's, between nodes.
+void benchAnalytic(const std::vector<RGB>& smooth, const std::vector<RGB>& random) {
+    constexpr int kDim = 33;
+    const float inv = 1.0f / static_cast<float>(kDim - 1);
+    std::vector<RGB> out(smooth.size());
+    for (const char* name : {"Convert Sony", "Convert Canon", "Convert Fujifilm", "Convert RED"}) {
+        LUTStructure s;
+        if (!AnalyticLogConversion(name, s)) continue;
+        std::vector<float> data(static_cast<std::size_t>(kDim) * kDim * kDim * 3);
+        for (std::size_t i = 0; i < data.size(); i += 3) {
+            const std::size_t node = i / 3;
+            const RGB c = ApplyAnalytic(s, (node % kDim) * inv, (node / kDim % kDim) * inv,
+                                        (node / (kDim * kDim)) * inv);
+            data[i] = c.r;
+            data[i + 1] = c.g;
+            data[i + 2] = c.b;
+        }
+        const ResolvedLayer layer = ResolveLayer(LUT3D{data.data(), kDim}, 1.0f);
+        std::printf("%-16s", name);
+        float worst = 0.0f;
+        for (const std::vector<RGB>* frame : {&smooth, &random}) {
+            const double lattice = mpixPerSecond<kDim>(layer, *frame, out);
+            double best = 1e30;
+            for (int it = 0; it < kIterations; ++it) {
+                const auto start = Clock::now();
+                for (std::size_t i = 0; i < frame->size(); ++i) {
+                    out[i] = ApplyAnalytic(s, (*frame)[i].r, (*frame)[i].g, (*frame)[i].b);
+                }
+                best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+            }
+            for (std::size_t i = 0; i < frame->size(); ++i) {
+                const RGB l = sampleLUT<kDim>(layer, (*frame)[i].r, (*frame)[i].g, (*frame)[i].b);
+                worst = std::max({worst, std::fabs(l.r - out[i].r), std::fabs(l.g - out[i].g),
+                                  std::fabs(l.b - out[i].b)});
+            }
+            const double fast = frame->size() / best / 1e6;
+            std::printf("   %7.1f -> %7.1f Mpix/s (%.2fx)", lattice, fast, fast / lattice);
+        }
+        std::printf("   lattice error %.2g\n", worst);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const std::vector<RGB> smooth = makeFrame(width, height, false);
+    const std::vector<RGB> random = makeFrame(width, height, true);
+
+    std::printf("%dx%d, best of %d; generic -> specialized, smooth frame then random frame\n", width, height,
+                kIterations);
+    benchSize<17>(smooth, random);
+    benchSize<33>(smooth, random);
+    benchSize<65>(smooth, random);
+    benchSize<129>(smooth, random);
+    benchShaper(smooth, random);
+    benchAdaptive<65>(smooth, random);
+    benchAdaptive<129>(smooth, random);
+    benchStructure(smooth, random);
+    benchAnalytic(smooth, random);
+    return 0;
+}
@@ -0,0 +1,130 @@
+// Load-time benchmark: .cube text parsing vs mapping a .vtclut pack.
+//
+//   clang++ -std=c++17 -O2 -o lut_loader_bench Tools/lut_loader_bench.cpp
+//       Plugin/Core/VTC_CubeLoader.cpp Plugin/Core/VTC_LUTPack.cpp
+//       Plugin/Core/VTC_MappedFile.cpp
+//   ./lut_loader_bench [file.cube]
+//
+// Without an argument a 65^3 .cube is synthesized in $TMPDIR. "first read"
+// includes the page faults of touching every sample once.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../Plugin/Core/VTC_CubeLoader.h"
+#include "../Plugin/Core/VTC_LUTPack.h"
+#include "../Plugin/Core/VTC_MappedFile.h"
+
+using namespace vtc;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr int kIterations = 20;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+float touch(const LUT3D& lut) {
+    const std::size_t n = static_cast<std::size_t>(lut.dimension) * lut.dimension * lut.dimension * 3;
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < n; ++i) sum += lut.data[i];
+    return sum;
+}
+
+std::string synthesizeCube(const std::string& dir, int dim) {
+    const std::string path = dir + "/vtc_bench.cube";
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return {};
+    std::fprintf(f, "TITLE \"bench\"\nLUT_3D_SIZE %d\n", dim);
+    for (int b = 0; b < dim; ++b) {
+        for (int g = 0; g < dim; ++g) {
+            for (int r = 0; r < dim; ++r) {
+                std::fprintf(f, "%.6f %.6f %.6f\n", r / float(dim - 1), g / float(dim - 1) * 0.9f,
+                             b / float(dim - 1) * 0.8f + 0.1f);
+            }
+        }
+    }
+    std::fclose(f);
+    return path;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* tmp = std::getenv("TMPDIR");
+    const std::string dir = tmp ? tmp : "/tmp";
+    const std::string cubePath = argc > 1 ? argv[1] : synthesizeCube(dir, 65);
+
+    MappedFile text;
+    if (!text.Open(cubePath)) {
+        std::fprintf(stderr, "cannot read %s\n", cubePath.c_str());
+        return 1;
+    }
+
+    std::vector<float> data;
+    int dim = 0;
+    float sink = 0.0f;
+    auto start = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        std::string error;
+        if (!ParseCube(reinterpret_cast<const char*>(text.data()), text.size(), data, dim, &error)) {
+            std::fprintf(stderr, "%s: %s\n", cubePath.c_str(), error.c_str());
+            return 1;
+        }
+        sink += data[0];
+    }
+    std::printf("%-18s %8.3f ms  (%d^3, %zu KB text)\n", ".cube parse", msSince(start) / kIterations, dim,
+                text.size() / 1024);
+
+    for (LUTPrecision precision : {LUTPrecision::kF32, LUTPrecision::kF16, LUTPrecision::kU16,
+                                   LUTPrecision::kDelta8, LUTPrecision::kDelta16}) {
+        static const char* const kNames[] = {"f32", "f16", "u16", "delta8", "delta16"};
+        const char* name = kNames[static_cast<int>(precision)];
+        const std::string packPath = dir + "/vtc_bench_" + name + ".vtclut";
+
+        LUTPackItem item;
+        item.name = "bench";
+        item.data = data.data();
+        item.dimension = dim;
+        item.precision = precision;
+        std::string error;
+        if (!WriteLUTPack(packPath, {item}, {}, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        MappedFile packFile;
+        packFile.Open(packPath);
+        const double ratio = static_cast<double>(data.size() * sizeof(float)) / packFile.size();
+
+        double openMs = 0.0;
+        double readMs = 0.0;
+        float maxError = 0.0f;
+        for (int i = 0; i < kIterations; ++i) {
+            start = Clock::now();
+            std::shared_ptr<LUTPack> pack = LUTPack::Open(packPath);
+            openMs += msSince(start);
+            if (!pack) return 1;
+
+            start = Clock::now();
+            const LUT3D* lut = pack->Get(0);
+            sink += touch(*lut);
+            readMs += msSince(start);
+
+            if (i == 0) {
+                for (std::size_t k = 0; k < data.size(); ++k) {
+                    const float e = lut->data[k] > data[k] ? lut->data[k] - data[k] : data[k] - lut->data[k];
+                    maxError = e > maxError ? e : maxError;
+                }
+            }
+        }
+        std::printf("%-18s %8.3f ms open, %8.3f ms first read  (%5.2fx smaller, max error %.2g)\n",
+                    (std::string(".vtclut ") + name).c_str(), openMs / kIterations, readMs / kIterations,
+                    ratio, maxError);
+    }
+    return sink == 12345.0f;  // keep the loops observable
+}
@@ -0,0 +1,266 @@
+// Builds the catalog (VTC_LUTCatalog.h) the plugin reads in place of
+// scanning a large user LUT folder. Walks the folder recursively: .cube
+// files under "Log" go to the Log Convert table, every other .cube to the
+// creative table, and each .vtclut entry to the table its id names. A
+// look's category is its folder below the table folder (a pack's entries
+// take the pack's name); its tags come from a "<name>.tags" file next to it,
+// comma- or line-separated, which for a pack tags every entry.
+//
+// Every LUT is parsed once here to record its size and content hash, so the
+// plugin never has to. Output does not depend on the thread count. Rerun
+// after changing the folder; the plugin reloads the catalog when it is
+// replaced and warns about looks changed since it was built.
+//
+//   clang++ -std=c++17 -O2 -pthread -o vtc_catalog Tools/vtc_catalog.cpp
+//       Plugin/Core/VTC_LUTCatalog.cpp Plugin/Core/VTC_CubeLoader.cpp Plugin/Core/VTC_LUTPack.cpp
+//       Plugin/Core/VTC_MappedFile.cpp Plugin/Core/VTC_LUTStructure.cpp
+//   ./vtc_catalog --luts <LUT folder> [--jobs N]
+
+#include <dirent.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Plugin/Core/VTC_CubeLoader.h"
+#include "../Plugin/Core/VTC_LUTCatalog.h"
+#include "../Plugin/Core/VTC_LUTLibrary.h"
+#include "../Plugin/Core/VTC_LUTPack.h"
+#include "../Plugin/Core/VTC_LUTStructure.h"
+#include "../Plugin/Core/VTC_MappedFile.h"
+
+using namespace vtc;
+
+namespace {
+
+// A .cube or .vtclut under the root; `relative` is its path from there.
+struct SourceFile {
+    std::string relative;
+    bool pack = false;
+    std::vector<LUTCatalogItem> items;
+    std::string error;
+};
+
+bool hasExtension(const std::string& file, const char* ext) {
+    const std::size_t n = std::strlen(ext);
+    return file.size() > n && strcasecmp(file.c_str() + file.size() - n, ext) == 0;
+}
+
+void walk(const std::string& root, const std::string& relative, std::vector<SourceFile>& out) {
+    DIR* d = ::opendir((relative.empty() ? root : root + "/" + relative).c_str());
+    if (!d) return;
+    std::vector<std::string> dirs;
+    while (dirent* e = ::readdir(d)) {
+        const std::string file = e->d_name;
+        if (file[0] == '.') continue;
+        const std::string path = relative.empty() ? file : relative + "/" + file;
+        struct stat st {};
+        if (::stat((root + "/" + path).c_str(), &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            dirs.push_back(path);
+        } else if (hasExtension(file, ".cube") || hasExtension(file, ".vtclut")) {
+            SourceFile source;
+            source.relative = path;
+            source.pack = hasExtension(file, ".vtclut");
+            out.push_back(std::move(source));
+        }
+    }
+    ::closedir(d);
+    for (const std::string& dir : dirs) walk(root, dir, out);
+}
+
+std::string stemOf(const std::string& relative) {
+    const std::size_t slash = relative.rfind('/');
+    const std::string file = slash == std::string::npos ? relative : relative.substr(slash + 1);
+    return file.substr(0, file.rfind('.'));
+}
+
+std::string folderOf(const std::string& relative) {
+    const std::size_t slash = relative.rfind('/');
+    return slash == std::string::npos ? std::string() : relative.substr(0, slash);
+}
+
+// Tags from "<stem>.tags" beside the source; none when it is missing.
+std::vector<std::string> readTags(const std::string& root, const std::string& relative) {
+    std::vector<std::string> tags;
+    const std::string folder = folderOf(relative);
+    MappedFile file;
+    if (!file.Open(root + "/" + (folder.empty() ? "" : folder + "/") + stemOf(relative) + ".tags")) return tags;
+    std::string tag;
+    for (std::size_t i = 0; i <= file.size(); ++i) {
+        const char c = i < file.size() ? static_cast<char>(file.data()[i]) : '\n';
+        if (c == ',' || c == '\n' || c == '\r') {
+            if (!tag.empty()) tags.push_back(tag);  // WriteLUTCatalog trims them
+            tag.clear();
+        } else {
+            tag += c;
+        }
+    }
+    return tags;
+}
+
+// Offset of the first data row: the first line starting with a number.
+std::uint64_t firstDataRow(const unsigned char* text, std::size_t size) {
+    for (std::size_t line = 0; line < size;) {
+        std::size_t i = line;
+        while (i < size && (text[i] == ' ' || text[i] == '\t')) ++i;
+        if (i < size && (std::strchr("+-.", text[i]) || (text[i] >= '0' && text[i] <= '9'))) return line;
+        while (i < size && text[i] != '\n') ++i;
+        line = i + 1;
+    }
+    return 0;
+}
+
+void catalogCube(const std::string& root, SourceFile& source, std::int64_t size, std::int64_t mtime) {
+    MappedFile text;
+    if (!text.Open(root + "/" + source.relative)) {
+        source.error = "cannot read";
+        return;
+    }
+    std::vector<float> data;
+    int dimension = 0;
+    if (!ParseCube(reinterpret_cast<const char*>(text.data()), text.size(), data, dimension, &source.error)) {
+        return;
+    }
+    // The first folder names the table; the rest is the category.
+    std::string folder = folderOf(source.relative);
+    const std::string top = folder.substr(0, folder.find('/'));
+    LUTCatalogItem item;
+    item.table = top == "Log" ? LUTTable::kLog : LUTTable::kRec709;
+    if (top == "Log" || top == "Rec 709") {
+        folder = folder.size() > top.size() ? folder.substr(top.size() + 1) : std::string();
+    }
+    item.name = stemOf(source.relative);
+    item.category = folder;
+    item.source = source.relative;
+    item.payloadOffset = firstDataRow(text.data(), text.size());
+    item.dimension = dimension;
+    item.contentHash = AnalyzeLattice(LUT3D{data.data(), dimension}).contentHash;
+    item.sourceSize = size;
+    item.sourceMtime = mtime;
+    source.items.push_back(std::move(item));
+}
+
+void catalogPack(const std::string& root, SourceFile& source, std::int64_t size, std::int64_t mtime) {
+    std::shared_ptr<LUTPack> pack = LUTPack::Open(root + "/" + source.relative, &source.error);
+    if (!pack) return;
+    for (int i = 0; i < pack->Count(); ++i) {
+        const LUTPackEntry& entry = pack->Entry(i);
+        if ((entry.id >> 16) >= 2) continue;  // not a table the library has
+        const LUT3D* lut = pack->Get(i);
+        if (!lut) {
+            source.error = "entry \"" + entry.name + "\" fails its checksum";
+            return;
+        }
+        LUTCatalogItem item;
+        item.table = LUTLibrary::TableOf(entry.id);
+        item.name = entry.name;
+        item.category = stemOf(source.relative);
+        item.source = source.relative;
+        item.packIndex = i;
+        item.packId = entry.id;
+        item.payloadOffset = pack->PayloadOffset(i);
+        item.dimension = entry.dimension;
+        item.contentHash = AnalyzeLattice(*lut).contentHash;
+        item.sourceSize = size;
+        item.sourceMtime = mtime;
+        source.items.push_back(std::move(item));
+    }
+}
+
+// Size and mtime as the plugin's folder scan reads them, so its revisions
+// match the catalog's.
+void catalog(const std::string& root, SourceFile& source) {
+    FileStamp stamp;
+    if (!StatFile(root + "/" + source.relative, stamp)) {
+        source.error = "cannot stat";
+        return;
+    }
+    const std::int64_t size = stamp.size;
+    const std::int64_t mtime = stamp.mtimeNs;
+    if (source.pack) {
+        catalogPack(root, source, size, mtime);
+    } else {
+        catalogCube(root, source, size, mtime);
+    }
+    if (!source.error.empty()) source.items.clear();
+}
+
+// Each worker takes the next uncatalogued file; results land in its slot.
+void catalogAll(const std::string& root, std::vector<SourceFile>& sources, int jobs) {
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t i = next++; i < sources.size(); i = next++) {
+            catalog(root, sources[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < jobs; ++i) threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads) t.join();
+}
+
+int usage() {
+    std::fprintf(stderr, "usage: vtc_catalog --luts DIR [--jobs N]\n");
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string root;
+    int jobs = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) return usage();
+        if (arg == "--luts") root = value;
+        else if (arg == "--jobs") jobs = std::atoi(value);
+        else return usage();
+        ++i;
+    }
+    if (root.empty()) return usage();
+    if (jobs <= 0) jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<SourceFile> sources;
+    walk(root, "", sources);
+    const auto start = std::chrono::steady_clock::now();
+    catalogAll(root, sources, jobs);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // A bad file is left out rather than failing the library.
+    std::vector<LUTCatalogItem> items;
+    std::size_t skipped = 0;
+    for (SourceFile& source : sources) {
+        if (!source.error.empty()) {
+            std::fprintf(stderr, "WARNING: skipping %s: %s\n", source.relative.c_str(), source.error.c_str());
+            ++skipped;
+            continue;
+        }
+        const std::vector<std::string> tags = readTags(root, source.relative);
+        for (LUTCatalogItem& item : source.items) {
+            item.tags = tags;
+            items.push_back(std::move(item));
+        }
+    }
+
+    const std::string out = root + "/" + kLUTCatalogFileName;
+    std::string error;
+    const std::size_t count = items.size();
+    if (!WriteLUTCatalog(out, std::move(items), &error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return 1;
+    }
+    std::printf("%s: %zu looks from %zu files (%zu skipped) in %.0f ms on %d threads\n", out.c_str(), count,
+                sources.size() - skipped, skipped, ms, jobs);
+    return 0;
+}
@@ -0,0 +1,642 @@
+// Native replacement for the resampling half of bake_luts.py: parses a LUT
+// folder in parallel, resamples through the engine's own trilinear kernel
+// (so baked and rendered interpolation are bit-identical), and writes the
+// generated C++ sources, a .vtclut pack, or both. Output does not depend on
+// the thread count. The generated tables embed their lattices as aligned
+// binary blobs (VTC_Incbin.h). LUTs keep their native size when it is one of
+// kNativeLUTDims and are resampled up to the next one otherwise; --dim
+// forces one size for all.
+//
+// --shaper log|all fits a per-channel 1D shaper to the Log LUTs (or every
+// LUT) and bakes them on the smallest of kShapedDims whose error against the
+// source is no worse than the uniform bake it replaces, at the LUT's own
+// size (plus --shaper-tolerance, 0 by default). LUTs no shaped size can
+// match keep their uniform bake, so a native 65^3 conversion stays exact.
+//
+// Every look is also run through ReduceLUT, as the engine does when it first
+// renders it interactively, and the size it will use there and its CIEDE2000
+// against the bake are reported (--interactive-delta-e sets the bound, 0
+// skips this).
+//
+// Each bake is also measured (AnalyzeLattice: distance from identity,
+// separable and least-squares affine error, steepest gradient, output range,
+// content hash) and the generated tables carry the result, so the plugin
+// classifies built-ins without reading their lattices.
+//
+//   clang++ -std=c++17 -O2 -pthread -o vtc_lut_baker Tools/vtc_lut_baker.cpp
+//       Plugin/Core/VTC_CubeLoader.cpp Plugin/Core/VTC_LUTPack.cpp
+//       Plugin/Core/VTC_MappedFile.cpp Plugin/Core/VTC_LUTReduce.cpp Plugin/Core/VTC_LUTStructure.cpp
+//   ./vtc_lut_baker --luts <dir with Log/ and "Rec 709"/> [--dim N] [--jobs N]
+//       [--shaper log|all [--shaper-tolerance E]] [--interactive-delta-e E]
+//       [--cpp <Plugin dir>] [--pack out.vtclut [--precision f32|f16|u16|delta8|delta16]]
+
+#include <dirent.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Plugin/Core/VTC_CubeLoader.h"
+#include "../Plugin/Core/VTC_LUTKernel.h"
+#include "../Plugin/Core/VTC_LUTPack.h"
+#include "../Plugin/Core/VTC_LUTReduce.h"
+#include "../Plugin/Core/VTC_LUTStructure.h"
+#include "../Plugin/Core/VTC_MappedFile.h"
+
+using namespace vtc;
+
+namespace {
+
+// Popup order of the Log Convert group; every entry is required.
+const char* const kLogOrder[] = {
+    "Convert Sony", "Dark Forest", "Amethyst", "Low Highlights", "Convert Canon", "Convert Fujifilm", "Convert RED",
+};
+
+// Shaped lattice sizes tried, smallest first.
+constexpr int kShapedDims[] = {17, 25};
+// 1/256 spacing: every node of a 17/33/65/129 lattice falls on a sample.
+constexpr int kShaperSize = 257;
+constexpr int kProbeCount = 1 << 15;
+
+enum class ShaperMode { kOff, kLog, kAll };
+
+struct Options {
+    std::string lutDir;
+    std::string pluginDir;  // writes Core/*_Gen.cpp and Shared/VTC_LUTData.h
+    std::string packPath;
+    LUTPrecision precision = LUTPrecision::kF32;
+    int dimension = 0;  // 0: native sizes
+    int jobs = 0;
+    ShaperMode shaper = ShaperMode::kOff;
+    float shaperTolerance = 0.0f;  // error a shaped bake may add over the uniform one
+    float interactiveDeltaE = kDefaultInteractiveDeltaE;
+};
+
+struct BakedLUT {
+    std::string name;
+    std::string path;
+    bool log = false;
+    int sourceDim = 0;
+    int dim = 0;
+    std::vector<float> data;    // at dim
+    std::vector<float> shaper;  // kShaperSize per channel, or empty
+    int shapedDim = 0;            // last shaped size tried, 0 if none was
+    float shapedError = 0.0f;     // its max error vs the source
+    int referenceDim = 0;         // the uniform bake's size, NativeLUTDim or --dim
+    float referenceError = 0.0f;  // its max error vs the source
+    int interactiveDim = 0;       // ReduceLUT's choice for a look; 0 if not run
+    float interactiveError = 0.0f;
+    LUTAnalysis analysis = {};  // of the bake
+    std::string error;
+};
+
+bool fileExists(const std::string& path) {
+    MappedFile f;
+    return f.Open(path);
+}
+
+std::vector<std::string> listCubes(const std::string& dir) {
+    std::vector<std::string> names;
+    if (DIR* d = ::opendir(dir.c_str())) {
+        while (dirent* e = ::readdir(d)) {
+            const std::string file = e->d_name;
+            if (file[0] != '.' && file.size() > 5 && strcasecmp(file.c_str() + file.size() - 5, ".cube") == 0) {
+                names.push_back(file);
+            }
+        }
+        ::closedir(d);
+    }
+    // Same order as bake_luts.py: by lowercased stem.
+    std::sort(names.begin(), names.end(), [](const std::string& a, const std::string& b) {
+        std::string la = a.substr(0, a.size() - 5), lb = b.substr(0, b.size() - 5);
+        std::transform(la.begin(), la.end(), la.begin(), ::tolower);
+        std::transform(lb.begin(), lb.end(), lb.begin(), ::tolower);
+        return la < lb;
+    });
+    return names;
+}
+
+// Samples `src` at every point of a dim^3 identity lattice, with the same
+// coordinates and kernel the stack bake uses. With a shaper the nodes sit at
+// its preimage of the grid instead.
+std::vector<float> resample(const std::vector<float>& src, int srcDim, int dim, const float* shaper = nullptr,
+                            int shaperSize = 0) {
+    if (srcDim == dim && !shaper) return src;
+    std::vector<float> nodes(static_cast<std::size_t>(dim) * 3);
+    const float inv = 1.0f / static_cast<float>(dim - 1);
+    for (int c = 0; c < 3; ++c) {
+        for (int i = 0; i < dim; ++i) {
+            nodes[c * dim + i] = shaper ? InvertShaper(shaper + c * shaperSize, shaperSize, i * inv) : i * inv;
+        }
+    }
+    std::vector<float> out(static_cast<std::size_t>(dim) * dim * dim * 3);
+    const ResolvedLayer layer = ResolveLayer(LUT3D{src.data(), srcDim}, 1.0f);
+    float* dst = out.data();
+    for (int b = 0; b < dim; ++b) {
+        for (int g = 0; g < dim; ++g) {
+            for (int r = 0; r < dim; ++r) {
+                const RGB s = sampleLUTFast(layer, nodes[r], nodes[dim + g], nodes[2 * dim + b]);
+                *dst++ = s.r;
+                *dst++ = s.g;
+                *dst++ = s.b;
+            }
+        }
+    }
+    return out;
+}
+
+// ── Shaper fitting ──
+
+// Fixed pseudo-random points in the unit cube (xorshift, so every platform
+// measures the same points).
+const std::vector<RGB>& probePoints() {
+    static const std::vector<RGB> points = [] {
+        std::vector<RGB> p(kProbeCount);
+        std::uint32_t x = 2463534242u;
+        auto next = [&x] {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            return static_cast<float>(x >> 8) / 16777215.0f;
+        };
+        for (RGB& c : p) c = {next(), next(), next()};
+        return p;
+    }();
+    return points;
+}
+
+float maxError(const ResolvedLayer& a, const ResolvedLayer& b) {
+    float error = 0.0f;
+    for (const RGB& c : probePoints()) {
+        const RGB x = sampleLUTFast(a, c.r, c.g, c.b);
+        const RGB y = sampleLUTFast(b, c.r, c.g, c.b);
+        error = std::max({error, std::fabs(x.r - y.r), std::fabs(x.g - y.g), std::fabs(x.b - y.b)});
+    }
+    return error;
+}
+
+// Source output along one axis: kShaperSize samples on each of a grid of
+// lines through the other two axes (at most 17 x 17 source nodes).
+struct AxisProfile {
+    int lines = 0;
+    std::vector<float> values;  // [line][sample][rgb]
+};
+
+AxisProfile sampleAxis(const ResolvedLayer& source, int axis) {
+    const int n = source.dimension;
+    const int step = std::max(1, (n - 1 + 15) / 16);
+    std::vector<float> positions;
+    for (int i = 0; i < n; i += step) positions.push_back(static_cast<float>(i) / (n - 1));
+    if (positions.back() != 1.0f) positions.push_back(1.0f);
+
+    AxisProfile profile;
+    profile.lines = static_cast<int>(positions.size() * positions.size());
+    profile.values.resize(static_cast<std::size_t>(profile.lines) * kShaperSize * 3);
+    float* out = profile.values.data();
+    for (float v : positions) {
+        for (float w : positions) {
+            for (int s = 0; s < kShaperSize; ++s) {
+                float in[3];
+                in[axis] = static_cast<float>(s) / (kShaperSize - 1);
+                in[(axis + 1) % 3] = v;
+                in[(axis + 2) % 3] = w;
+                const RGB c = sampleLUTFast(source, in[0], in[1], in[2]);
+                *out++ = c.r;
+                *out++ = c.g;
+                *out++ = c.b;
+            }
+        }
+    }
+    return profile;
+}
+
+// Worst error, over every line, of replacing the samples between a and b by
+// their chord.
+float chordError(const AxisProfile& profile, int a, int b) {
+    float error = 0.0f;
+    for (int line = 0; line < profile.lines; ++line) {
+        const float* v = profile.values.data() + static_cast<std::size_t>(line) * kShaperSize * 3;
+        for (int s = a + 1; s < b; ++s) {
+            const float t = static_cast<float>(s - a) / static_cast<float>(b - a);
+            for (int o = 0; o < 3; ++o) {
+                error = std::max(error, std::fabs(lerp(v[a * 3 + o], v[b * 3 + o], t) - v[s * 3 + o]));
+            }
+        }
+    }
+    return error;
+}
+
+// Greedy walk: each segment runs as far as it can within `tolerance`. Stops
+// once it has used more than `limit` knots.
+std::vector<int> walkKnots(const AxisProfile& profile, float tolerance, int limit) {
+    constexpr int kLast = kShaperSize - 1;
+    std::vector<int> knots{0};
+    for (int a = 0; a < kLast && static_cast<int>(knots.size()) <= limit;) {
+        int lo = a + 1, hi = kLast;
+        while (lo < hi) {
+            const int mid = (lo + hi + 1) / 2;
+            if (chordError(profile, a, mid) <= tolerance) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        knots.push_back(lo);
+        a = lo;
+    }
+    return knots;
+}
+
+// Sample indices of `count` lattice nodes along one axis: the piecewise-
+// linear fit with the smallest worst-case error the greedy walk reaches,
+// found by bisecting the tolerance. Nodes left over split the widest gaps.
+std::vector<int> placeKnots(const AxisProfile& profile, int count) {
+    constexpr int kLast = kShaperSize - 1;
+    std::vector<int> best{0, kLast};
+    float lo = 0.0f, hi = chordError(profile, 0, kLast);
+    for (int i = 0; i < 24; ++i) {
+        const float tolerance = 0.5f * (lo + hi);
+        std::vector<int> knots = walkKnots(profile, tolerance, count);
+        if (static_cast<int>(knots.size()) <= count && knots.back() == kLast) {
+            best = std::move(knots);
+            hi = tolerance;
+        } else {
+            lo = tolerance;
+        }
+    }
+    while (static_cast<int>(best.size()) < count) {
+        std::size_t widest = 0;
+        for (std::size_t i = 1; i + 1 < best.size(); ++i) {
+            if (best[i + 1] - best[i] > best[widest + 1] - best[widest]) widest = i;
+        }
+        if (best[widest + 1] - best[widest] < 2) break;
+        best.insert(best.begin() + widest + 1, (best[widest] + best[widest + 1]) / 2);
+    }
+    return best;
+}
+
+// Per-channel shaper for a dim^3 lattice: maps each channel's knots onto the
+// lattice grid, linear in between. Knots sit on shaper samples, so nodes
+// land exactly on kinks of the source (such as its own lattice nodes).
+std::vector<float> fitShaper(const ResolvedLayer& source, int dim) {
+    std::vector<float> shaper(static_cast<std::size_t>(kShaperSize) * 3);
+    for (int c = 0; c < 3; ++c) {
+        const std::vector<int> knots = placeKnots(sampleAxis(source, c), dim);
+        const float scale = 1.0f / static_cast<float>(knots.size() - 1);
+        float* curve = shaper.data() + c * kShaperSize;
+        for (std::size_t i = 0; i + 1 < knots.size(); ++i) {
+            for (int s = knots[i]; s <= knots[i + 1]; ++s) {
+                curve[s] = (i + static_cast<float>(s - knots[i]) / (knots[i + 1] - knots[i])) * scale;
+            }
+        }
+    }
+    return shaper;
+}
+
+// Replaces lut's uniform bake with the smallest shaped one that is as
+// accurate (within `tolerance`), if there is one.
+void fitShaped(BakedLUT& lut, const std::vector<float>& src, float tolerance) {
+    const ResolvedLayer source = ResolveLayer(LUT3D{src.data(), lut.sourceDim}, 1.0f);
+    lut.referenceDim = lut.dim;
+    lut.referenceError = maxError(source, ResolveLayer(LUT3D{lut.data.data(), lut.dim}, 1.0f));
+    const float target = lut.referenceError + tolerance;
+
+    for (int dim : kShapedDims) {
+        if (dim >= lut.dim) return;
+        std::vector<float> shaper = fitShaper(source, dim);
+        std::vector<float> data = resample(src, lut.sourceDim, dim, shaper.data(), kShaperSize);
+        lut.shapedDim = dim;
+        lut.shapedError = maxError(source, ResolveLayer(LUT3D{data.data(), dim, shaper.data(), kShaperSize}, 1.0f));
+        if (lut.shapedError <= target) {
+            lut.dim = dim;
+            lut.data = std::move(data);
+            lut.shaper = std::move(shaper);
+            return;
+        }
+    }
+}
+
+void bake(BakedLUT& lut, const Options& opt) {
+    MappedFile text;
+    if (!text.Open(lut.path)) {
+        lut.error = "cannot read";
+        return;
+    }
+    std::vector<float> src;
+    if (!ParseCube(reinterpret_cast<const char*>(text.data()), text.size(), src, lut.sourceDim, &lut.error)) {
+        return;
+    }
+    lut.dim = opt.dimension > 0 ? opt.dimension : NativeLUTDim(lut.sourceDim);
+    lut.data = resample(src, lut.sourceDim, lut.dim);
+    if (opt.shaper == ShaperMode::kAll || (opt.shaper == ShaperMode::kLog && lut.log)) {
+        fitShaped(lut, src, opt.shaperTolerance);
+    }
+    const LUT3D baked{lut.data.data(), lut.dim, lut.shaper.empty() ? nullptr : lut.shaper.data(),
+                      lut.shaper.empty() ? 0 : kShaperSize};
+    lut.analysis = AnalyzeLattice(baked);
+    if (!lut.log && opt.interactiveDeltaE > 0.0f) {
+        const LUTReduction reduced = ReduceLUT(baked, opt.interactiveDeltaE);
+        lut.interactiveDim = reduced.dimension;
+        lut.interactiveError = reduced.maxDeltaE;
+    }
+}
+
+// Each worker takes the next unbaked LUT; results land in their own slot.
+void bakeAll(std::vector<BakedLUT>& luts, const Options& opt) {
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t i = next++; i < luts.size(); i = next++) {
+            bake(luts[i], opt);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < opt.jobs; ++i) threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads) t.join();
+}
+
+// Raw little-endian f32, each lattice (and shaper, after its lattice) on a
+// 64-byte boundary; returns the offsets in floats.
+bool writeBlob(const std::string& path, const std::vector<const BakedLUT*>& luts, std::vector<std::size_t>& offsets,
+               std::vector<std::size_t>& shaperOffsets) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    static const char kZeros[64] = {};
+    std::size_t bytes = 0;
+    bool ok = true;
+    auto write = [&](const std::vector<float>& values) {
+        const std::size_t offset = bytes / sizeof(float);
+        const std::size_t size = values.size() * sizeof(float);
+        const std::size_t pad = (64 - size % 64) % 64;
+        ok = ok && std::fwrite(values.data(), 1, size, f) == size && std::fwrite(kZeros, 1, pad, f) == pad;
+        bytes += size + pad;
+        return offset;
+    };
+    for (const BakedLUT* lut : luts) {
+        offsets.push_back(write(lut->data));
+        shaperOffsets.push_back(lut->shaper.empty() ? 0 : write(lut->shaper));
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+// `file` relative to the folder of `source`. The baker writes blobs beside
+// their sources, and the build passes that folder to the assembler (-Wa,-I),
+// so the generated source does not depend on the checkout path.
+std::string relativeToSource(const std::string& source, const std::string& file) {
+    const std::size_t slash = source.rfind('/');
+    const std::string dir = slash == std::string::npos ? std::string() : source.substr(0, slash + 1);
+    return file.compare(0, dir.size(), dir) == 0 ? file.substr(dir.size()) : file;
+}
+
+bool writeTableSource(const std::string& path, const std::string& blobPath, const char* blobSymbol,
+                      const char* table, const char* countVar, const std::vector<const BakedLUT*>& luts) {
+    std::vector<std::size_t> offsets, shaperOffsets;
+    if (!writeBlob(blobPath, luts, offsets, shaperOffsets)) return false;
+
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::fprintf(f, "#include \"../Shared/VTC_LUTData.h\"\n#include \"VTC_Incbin.h\"\n\n");
+    std::fprintf(f, "VTC_INCBIN(%s, \"%s\");\n\n", blobSymbol, relativeToSource(path, blobPath).c_str());
+    std::fprintf(f, "namespace vtc {\n\n");
+
+    // Hex floats, so the runtime sees exactly what the baker measured.
+    std::fprintf(f, "namespace {\n\nconst LUTAnalysis kAnalysis[] = {\n");
+    for (const BakedLUT* lut : luts) {
+        const LUTAnalysis& a = lut->analysis;
+        std::fprintf(f, "    {%a, %a, %a,  // %s\n", a.identityError, a.separableError, a.affineError,
+                     lut->name.c_str());
+        std::fprintf(f, "     {{%a, %a, %a}, {%a, %a, %a}, {%a, %a, %a}},\n", a.matrix[0][0], a.matrix[0][1],
+                     a.matrix[0][2], a.matrix[1][0], a.matrix[1][1], a.matrix[1][2], a.matrix[2][0], a.matrix[2][1],
+                     a.matrix[2][2]);
+        std::fprintf(f, "     {%a, %a, %a}, %a,\n", a.offset[0], a.offset[1], a.offset[2], a.maxGradient);
+        std::fprintf(f, "     {%a, %a, %a}, {%a, %a, %a}, 0x%016llxull},\n", a.outputMin[0], a.outputMin[1],
+                     a.outputMin[2], a.outputMax[0], a.outputMax[1], a.outputMax[2],
+                     static_cast<unsigned long long>(a.contentHash));
+    }
+    std::fprintf(f, "};\n\n}  // namespace\n\n");
+
+    std::fprintf(f, "const LUT3D %s[] = {\n", table);
+    for (std::size_t i = 0; i < luts.size(); ++i) {
+        if (luts[i]->shaper.empty()) {
+            std::fprintf(f, "    {%s + %zu, %d, nullptr, 0, &kAnalysis[%zu]},  // %s\n", blobSymbol, offsets[i],
+                         luts[i]->dim, i, luts[i]->name.c_str());
+        } else {
+            std::fprintf(f, "    {%s + %zu, %d, %s + %zu, %d, &kAnalysis[%zu]},  // %s\n", blobSymbol, offsets[i],
+                         luts[i]->dim, blobSymbol, shaperOffsets[i], kShaperSize, i, luts[i]->name.c_str());
+        }
+    }
+    std::fprintf(f, "};\n\n");
+    std::fprintf(f, "const int %s = %zu;\n\n", countVar, luts.size());
+    std::fprintf(f, "}  // namespace vtc\n");
+    return std::fclose(f) == 0;
+}
+
+std::string selectedPopup(std::size_t total) {
+    std::string s;
+    for (std::size_t i = 0; i <= total; ++i) {
+        s += (i ? "|" : "") + std::to_string(i) + "/" + std::to_string(total);
+    }
+    return s;
+}
+
+bool writeHeader(const std::string& path, const std::vector<const BakedLUT*>& log,
+                 const std::vector<const BakedLUT*>& rec709) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::fprintf(f, "#pragma once\n\n#include <cstdint>\n\nnamespace vtc {\n\n");
+    std::fprintf(f,
+                 "// What vtc_lut_baker measured on a lattice, stored with the built-in tables\n"
+                 "// so the plugin picks kernels without scanning them. In lattice coordinates\n"
+                 "// (behind the shaper); errors are the largest node deviation per channel.\n"
+                 "struct LUTAnalysis {\n"
+                 "    float identityError;   // of the lattice alone: a shaped LUT is never the identity\n"
+                 "    float separableError;  // from the curves along the three axes through black\n"
+                 "    float affineError;     // from matrix/offset, the least-squares affine fit\n"
+                 "    float matrix[3][3];\n    float offset[3];\n"
+                 "    float maxGradient;  // steepest output change between neighbouring nodes, per unit input\n"
+                 "    float outputMin[3];\n    float outputMax[3];\n"
+                 "    std::uint64_t contentHash;  // FNV-1a over lattice and shaper\n};\n\n");
+    std::fprintf(f,
+                 "struct LUT3D {\n    const float* data;\n    int dimension;\n"
+                 "    // Optional per-channel input curve: shaperSize entries each for r, g, b,\n"
+                 "    // mapping [0,1] input to [0,1] lattice coordinate.\n"
+                 "    const float* shaper = nullptr;\n    int shaperSize = 0;\n"
+                 "    const LUTAnalysis* analysis = nullptr;  // baked tables only\n};\n\n");
+    std::fprintf(f, "extern const LUT3D kLogLUTs[];\nextern const int kLogLUTCount;\n\n");
+    std::fprintf(f, "extern const LUT3D kRec709LUTs[];\nextern const int kRec709LUTCount;\n\n");
+
+    auto names = [f](const char* var, const std::vector<const BakedLUT*>& luts) {
+        std::fprintf(f, "inline constexpr const char* %s[] = {\n", var);
+        for (const BakedLUT* lut : luts) std::fprintf(f, "    \"%s\",\n", lut->name.c_str());
+        std::fprintf(f, "};\n\n");
+    };
+    names("kLogLUTNames", log);
+    names("kRec709LUTNames", rec709);
+
+    auto popup = [](const std::vector<const BakedLUT*>& luts) {
+        std::string s = "None";
+        for (const BakedLUT* lut : luts) s += "|" + lut->name;
+        return s;
+    };
+    std::fprintf(f, "inline const char kLogPopupStr[] = \"%s\";\n", popup(log).c_str());
+    std::fprintf(f, "inline const char kRec709PopupStr[] = \"%s\";\n\n", popup(rec709).c_str());
+    std::fprintf(f, "inline const char kLogSelectedPopupStr[] = \"%s\";\n", selectedPopup(log.size()).c_str());
+    std::fprintf(f, "inline const char kRec709SelectedPopupStr[] = \"%s\";\n\n",
+                 selectedPopup(rec709.size()).c_str());
+    std::fprintf(f, "}  // namespace vtc\n");
+    return std::fclose(f) == 0;
+}
+
+bool parsePrecision(const char* s, LUTPrecision& out) {
+    static const char* const kNames[] = {"f32", "f16", "u16", "delta8", "delta16"};
+    for (int i = 0; i < 5; ++i) {
+        if (std::strcmp(s, kNames[i]) == 0) {
+            out = static_cast<LUTPrecision>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: vtc_lut_baker --luts DIR [--dim N] [--jobs N] [--cpp PLUGIN_DIR]\n"
+                 "                     [--shaper log|all [--shaper-tolerance E]] [--interactive-delta-e E]\n"
+                 "                     [--pack OUT.vtclut [--precision f32|f16|u16|delta8|delta16]]\n");
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) return usage();
+        if (arg == "--luts") opt.lutDir = value;
+        else if (arg == "--cpp") opt.pluginDir = value;
+        else if (arg == "--pack") opt.packPath = value;
+        else if (arg == "--dim") opt.dimension = std::atoi(value);
+        else if (arg == "--jobs") opt.jobs = std::atoi(value);
+        else if (arg == "--shaper-tolerance") opt.shaperTolerance = static_cast<float>(std::atof(value));
+        else if (arg == "--interactive-delta-e") opt.interactiveDeltaE = static_cast<float>(std::atof(value));
+        else if (arg == "--shaper") {
+            if (std::strcmp(value, "log") == 0) opt.shaper = ShaperMode::kLog;
+            else if (std::strcmp(value, "all") == 0) opt.shaper = ShaperMode::kAll;
+            else return usage();
+        }
+        else if (arg == "--precision") {
+            if (!parsePrecision(value, opt.precision)) return usage();
+        } else {
+            return usage();
+        }
+        ++i;
+    }
+    if (opt.lutDir.empty() || (opt.dimension != 0 && opt.dimension < 2) ||
+        (opt.dimension != 0 && opt.shaper != ShaperMode::kOff) ||
+        (opt.pluginDir.empty() && opt.packPath.empty())) {
+        return usage();
+    }
+    if (opt.jobs <= 0) opt.jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<BakedLUT> luts;
+    const std::string logDir = opt.lutDir + "/Log";
+    for (const char* name : kLogOrder) {
+        BakedLUT lut;
+        lut.name = name;
+        lut.path = logDir + "/" + name + ".cube";
+        lut.log = true;
+        if (!fileExists(lut.path)) {
+            std::fprintf(stderr, "ERROR: missing required Log LUT %s.cube\n", name);
+            return 1;
+        }
+        luts.push_back(std::move(lut));
+    }
+    const std::string recDir = opt.lutDir + "/Rec 709";
+    for (const std::string& file : listCubes(recDir)) {
+        BakedLUT lut;
+        lut.name = file.substr(0, file.size() - 5);
+        lut.path = recDir + "/" + file;
+        luts.push_back(std::move(lut));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    bakeAll(luts, opt);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<const BakedLUT*> log, rec709;
+    for (const BakedLUT& lut : luts) {
+        if (!lut.error.empty()) {
+            std::fprintf(stderr, "ERROR: %s: %s\n", lut.path.c_str(), lut.error.c_str());
+            return 1;
+        }
+        if (!lut.shaper.empty()) {
+            std::printf("  %s dim=%d -> shaped %d (max error %.2g, uniform %d^3 %.2g)\n", lut.name.c_str(),
+                        lut.sourceDim, lut.dim, lut.shapedError, lut.referenceDim, lut.referenceError);
+        } else if (lut.shapedDim > 0) {
+            std::printf("  %s dim=%d -> %d, unshaped (shaped %d max error %.2g > %.2g)\n", lut.name.c_str(),
+                        lut.sourceDim, lut.dim, lut.shapedDim, lut.shapedError,
+                        lut.referenceError + opt.shaperTolerance);
+        } else if (lut.dim != lut.sourceDim) {
+            std::printf("  %s dim=%d -> resample %d\n", lut.name.c_str(), lut.sourceDim, lut.dim);
+        } else {
+            std::printf("  %s dim=%d\n", lut.name.c_str(), lut.sourceDim);
+        }
+        (lut.log ? log : rec709).push_back(&lut);
+    }
+    std::printf("Baked %zu Log + %zu Rec709 in %.0f ms on %d threads\n", log.size(), rec709.size(), ms, opt.jobs);
+
+    if (opt.interactiveDeltaE > 0.0f) {
+        std::printf("Interactive lattices (max dE2000 %g):\n", opt.interactiveDeltaE);
+        for (const BakedLUT* lut : rec709) {
+            if (lut->interactiveDim < lut->dim) {
+                std::printf("  %s %d^3 -> %d^3 (dE2000 %.2f)\n", lut->name.c_str(), lut->dim, lut->interactiveDim,
+                            lut->interactiveError);
+            } else {
+                std::printf("  %s %d^3, nothing smaller within bound\n", lut->name.c_str(), lut->dim);
+            }
+        }
+    }
+
+    if (!opt.pluginDir.empty()) {
+        const std::string core = opt.pluginDir + "/Core/";
+        const std::string shared = opt.pluginDir + "/Shared/";
+        if (!writeTableSource(core + "VTC_LUTData_Log_Gen.cpp", core + "VTC_LUTData_Log.bin", "vtcLogLUTBlob",
+                              "kLogLUTs", "kLogLUTCount", log) ||
+            !writeTableSource(core + "VTC_LUTData_Rec709_Gen.cpp", core + "VTC_LUTData_Rec709.bin",
+                              "vtcRec709LUTBlob", "kRec709LUTs", "kRec709LUTCount", rec709) ||
+            !writeHeader(shared + "VTC_LUTData.h", log, rec709)) {
+            std::fprintf(stderr, "ERROR: cannot write sources under %s\n", opt.pluginDir.c_str());
+            return 1;
+        }
+        std::printf("  wrote %sVTC_LUTData_*_Gen.cpp + .bin and %sVTC_LUTData.h\n", core.c_str(), shared.c_str());
+    }
+
+    if (!opt.packPath.empty()) {
+        std::vector<LUTPackItem> items;
+        auto add = [&](std::uint32_t id, const BakedLUT& lut) {
+            items.push_back({id, lut.name, lut.data.data(), lut.dim, opt.precision,
+                             lut.shaper.empty() ? nullptr : lut.shaper.data(),
+                             lut.shaper.empty() ? 0 : kShaperSize});
+        };
+        for (std::size_t i = 0; i < log.size(); ++i) add(static_cast<std::uint32_t>(i), *log[i]);
+        for (std::size_t i = 0; i < rec709.size(); ++i) add(0x10000u | static_cast<std::uint32_t>(i), *rec709[i]);
+        std::string error;
+        if (!WriteLUTPack(opt.packPath, items, {}, &error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+            return 1;
+        }
+        std::printf("  wrote %s\n", opt.packPath.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Flattens a look stack into one .cube or .vtclut for systems that cannot run
+// the plugin. Layers are named as in the popups (user LUTs included, from
+// the same folder the plugin reads) with an optional intensity in percent;
+// trims take the plugin's slider values. The result is what the plugin
+// renders for the same settings (see VTC_StackExport.h).
+//
+//   clang++ -std=c++17 -O2 -pthread -IPlugin/Shared -IPlugin/Core -o vtc_stack_export
+//       Tools/vtc_stack_export.cpp $(ls Plugin/Core/*.cpp | grep -v -e Cuda -e OpenCL -e RenderBackend)
+//   ./vtc_stack_export [--log NAME[@PCT]] [--creative NAME[@PCT]] [--secondary NAME[@PCT]]
+//       [--accent NAME[@PCT]] [--exposure STOPS] [--temperature V] [--tint V] [--saturation PCT]
+//       [--output-gain PCT] [--output-saturation PCT] [--dim N] [--title T]
+//       (--cube out.cube | --pack out.vtclut [--precision f32|f16|u16|delta8|delta16])
+//
+//   ./vtc_stack_export --log "Convert Sony" --creative "Dark Forest@80" --cube sony_forest.cube
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "../Plugin/Core/VTC_LUTLibrary.h"
+#include "../Plugin/Core/VTC_StackExport.h"
+
+using namespace vtc;
+
+namespace {
+
+bool parsePrecision(const char* s, LUTPrecision& out) {
+    static const char* const kNames[] = {"f32", "f16", "u16", "delta8", "delta16"};
+    for (int i = 0; i < 5; ++i) {
+        if (std::strcmp(s, kNames[i]) == 0) {
+            out = static_cast<LUTPrecision>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// "NAME" or "NAME@PCT", looked up in `table`.
+bool parseLayer(const char* s, LUTTable table, LayerParams& out) {
+    std::string name = s;
+    float intensity = 100.0f;
+    const std::size_t at = name.rfind('@');
+    if (at != std::string::npos) {
+        char* end = nullptr;
+        intensity = std::strtof(name.c_str() + at + 1, &end);
+        if (!end || *end || intensity < 0.0f || intensity > 100.0f) {
+            std::fprintf(stderr, "ERROR: bad intensity in \"%s\"\n", s);
+            return false;
+        }
+        name.resize(at);
+    }
+    const int index = LUTLibrary::Shared().Find(table, name.c_str());
+    if (index < 0) {
+        std::fprintf(stderr, "ERROR: no %s look called \"%s\"\n", table == LUTTable::kLog ? "Log" : "Rec 709",
+                     name.c_str());
+        return false;
+    }
+    out.enabled = true;
+    out.lutIndex = index;
+    out.intensity = intensity / 100.0f;
+    return true;
+}
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: vtc_stack_export [--log NAME[@PCT]] [--creative NAME[@PCT]] [--secondary NAME[@PCT]]\n"
+                 "                        [--accent NAME[@PCT]] [--exposure STOPS] [--temperature V] [--tint V]\n"
+                 "                        [--saturation PCT] [--output-gain PCT] [--output-saturation PCT]\n"
+                 "                        [--dim N] [--title T] (--cube OUT.cube | --pack OUT.vtclut\n"
+                 "                        [--precision f32|f16|u16|delta8|delta16])\n");
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ParamsSnapshot params;
+    StackExportOptions options;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) return usage();
+        bool ok = true;
+        if (arg == "--log") ok = parseLayer(value, LUTTable::kLog, params.logConvert);
+        else if (arg == "--creative") ok = parseLayer(value, LUTTable::kRec709, params.creative);
+        else if (arg == "--secondary") ok = parseLayer(value, LUTTable::kRec709, params.secondary);
+        else if (arg == "--accent") ok = parseLayer(value, LUTTable::kRec709, params.accent);
+        else if (arg == "--exposure") params.trim.exposure = std::strtof(value, nullptr);
+        else if (arg == "--temperature") params.trim.temperature = std::strtof(value, nullptr);
+        else if (arg == "--tint") params.trim.tint = std::strtof(value, nullptr);
+        else if (arg == "--saturation") params.trim.saturation = std::strtof(value, nullptr) / 100.0f;
+        else if (arg == "--output-gain") params.trim.outputGain = std::strtof(value, nullptr) / 100.0f;
+        else if (arg == "--output-saturation") params.trim.outputSaturation = std::strtof(value, nullptr) / 100.0f;
+        else if (arg == "--dim") options.dimension = std::atoi(value);
+        else if (arg == "--title") options.title = value;
+        else if (arg == "--cube") { path = value; options.pack = false; }
+        else if (arg == "--pack") { path = value; options.pack = true; }
+        else if (arg == "--precision") ok = parsePrecision(value, options.precision);
+        else return usage();
+        if (!ok) return usage();
+        ++i;
+    }
+    if (path.empty() || options.dimension < 2 || options.dimension > kMaxExportDimension) {
+        return usage();
+    }
+
+    std::string error;
+    if (!ExportStack(params, path, options, &error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return 1;
+    }
+    std::printf("%s: %d^3 %s\n", path.c_str(), options.dimension, options.pack ? "pack" : "cube");
+    return 0;
+}
@@ -19,10 +19,29 @@ clang++ -arch arm64 -std=c++17 -O2 -bundle \
     -I"$AE_SDK_ROOT/Examples/Headers/SP" \
     -I"$AE_SDK_ROOT/Examples/Util" \
     -I"$VTC_HOST" -I"$VTC_CORE" -I"$VTC_ROOT/Shared" \
+    -Wa,-I"$VTC_CORE" \
     "$VTC_HOST/VTC_Looks_AdobePF.cpp" \
     "$VTC_HOST/VTC_FrameMap_AdobePF.cpp" \
     "$VTC_HOST/VTC_ParamMap_AdobePF.cpp" \
+    "$VTC_HOST/VTC_ComputeCache_AdobePF.cpp" \
     "$VTC_CORE/VTC_LUTSampling.cpp" \
+    "$VTC_CORE/VTC_StackBake.cpp" \
+    "$VTC_CORE/VTC_BackgroundQueue.cpp" \
+    "$VTC_CORE/VTC_ProgressiveBake.cpp" \
+    "$VTC_CORE/VTC_Prefetch.cpp" \
+    "$VTC_CORE/VTC_CacheBudget.cpp" \
+    "$VTC_CORE/VTC_SequencePrebake.cpp" \
+    "$VTC_CORE/VTC_ComputeCache.cpp" \
+    "$VTC_CORE/VTC_MappedFile.cpp" \
+    "$VTC_CORE/VTC_CubeLoader.cpp" \
+    "$VTC_CORE/VTC_LUTLibrary.cpp" \
+    "$VTC_CORE/VTC_LUTPack.cpp" \
+    "$VTC_CORE/VTC_DirectoryWatcher.cpp" \
+    "$VTC_CORE/VTC_AdaptiveLUT.cpp" \
+    "$VTC_CORE/VTC_LUTStructure.cpp" \
+    "$VTC_CORE/VTC_LogTransforms.cpp" \
+    "$VTC_CORE/VTC_LUTReduce.cpp" \
+    "$VTC_CORE/VTC_LUTCatalog.cpp" \
     "$VTC_CORE/VTC_LUTData_Log_Gen.cpp" \
     "$VTC_CORE/VTC_LUTData_Rec709_Gen.cpp" \
     "$VTC_CORE/VTC_MetalBootstrap.mm" \